@@ -0,0 +1,438 @@
+/*
+    bench/cfd_bench.c
+    更新核基准：在不同 NX、OpenMP 线程数与调度方式下，对各个核推进固定步数并计时，
+    输出每个网格点更新的耗时 (ns/point)、加速比与并行效率
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cfd_util.h"
+#include "cfd_config.h"
+#include "cfd_report.h"
+#include "cfd_simd.h"
+#include "cfd_temporal.h"
+#include "constants.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define BENCH_MAX_LIST  32          // 每个扫描维度最多的取值个数
+#define BENCH_WORK      2e7         // 默认每个配置推进的总点更新数（NX * 步数）
+#define BENCH_MIN_STEPS 5
+#define BENCH_WARMUP    2           // 计时前的预热调用次数
+#define BENCH_TEMPORAL_DEPTH 32     // temporal 核每次载入 tile 推进的步数
+
+/* 单步的核用 run 逐次调用；一次推进多步的方式（常驻并行区、时间分块）用 advance */
+typedef struct {
+    const char *name;
+    void (*run)(CfdSolver *s);
+    i64 (*advance)(CfdSolver *s, i64 steps);
+} BenchKernel;
+
+static void runFused(CfdSolver *s)    { updateFlowField(s, s->pa.acc); }
+static void runScalar(CfdSolver *s)
+{
+    i32 simd = s->simd;
+    s->simd = CFD_SIMD_SCALAR;
+    updateFlowField(s, s->pa.acc);
+    s->simd = simd;
+}
+static void runVelocity(CfdSolver *s) { updateVelocity(s, s->pa.acc); }
+static void runRho(CfdSolver *s)      { updateRho(s, s->pa.acc); }
+static void runPressure(CfdSolver *s) { updatePressure(s); }
+static void runStep(CfdSolver *s)     { cfdSolverStep(s); }
+static i64 advanceRegion(CfdSolver *s, i64 steps) { return cfdSolverAdvance(s, steps, 1e300); }
+
+/* 时间分块的工作区随求解器一起创建与释放（见 main） */
+static CfdTemporal *bench_temporal = NULL;
+static i64 advanceTemporal(CfdSolver *s, i64 steps)
+{
+    if (bench_temporal == NULL) bench_temporal = cfdTemporalCreate(s, BENCH_TEMPORAL_DEPTH, 0);
+    if (bench_temporal == NULL) return 0;
+    return cfdTemporalAdvance(bench_temporal, s, steps, 1e300);
+}
+
+static const BenchKernel bench_kernels[] = {
+    {"fused",    runFused,    NULL},    // 融合核，按 CPU 自动选择的 SIMD 实现
+    {"scalar",   runScalar,   NULL},    // 融合核的标量实现
+    {"velocity", runVelocity, NULL},
+    {"rho",      runRho,      NULL},
+    {"pressure", runPressure, NULL},
+    {"step",     runStep,     NULL},    // 完整的一步（核、边界、交换、活塞加速度）
+    {"region",   NULL, advanceRegion},  // 同上，但全部步数在一个常驻并行区内推进（cfdSolverAdvance）
+    {"temporal", NULL, advanceTemporal},// 同上，按时间分块推进（cfdTemporalAdvance，tile 按 L2 选取）
+};
+#define BENCH_KERNEL_COUNT ((i32)(sizeof(bench_kernels) / sizeof(bench_kernels[0])))
+
+typedef struct {
+    const char *name;
+#ifdef _OPENMP
+    omp_sched_t kind;
+#endif
+    i32 chunk;
+} BenchSchedule;
+
+typedef struct {
+    i32 nx;
+    i32 threads;
+    i32 schedule;                   // 下标，对应 BenchOptions.schedules
+    i32 kernel;                     // 下标，对应 bench_kernels
+    i64 steps;
+    f64 seconds;                    // 重复测量中的最短时间
+} BenchResult;
+
+typedef struct {
+    i64 nx[BENCH_MAX_LIST];
+    i32 nx_count;
+    i64 threads[BENCH_MAX_LIST];
+    i32 threads_count;
+    char schedule_names[BENCH_MAX_LIST][32];
+    BenchSchedule schedules[BENCH_MAX_LIST];
+    i32 schedule_count;
+    i32 kernels[BENCH_KERNEL_COUNT];
+    i32 kernel_count;
+    i64 steps;                      // 0 表示按 BENCH_WORK 自动选择
+    i32 repeat;
+    const char *csv;
+} BenchOptions;
+
+static void printUsage(const char *prog)
+{
+    printf("Usage: %s [options]\n", prog);
+    printf("  --nx LIST        grid sizes (default 1e3,1e4,1e5,1e6,1e7)\n");
+    printf("  --threads LIST   OpenMP thread counts (default 1,2,4,... up to the core count)\n");
+    printf("  --schedule LIST  OpenMP schedules: static, dynamic, guided, auto, optionally KIND:CHUNK\n");
+    printf("                   (default static,dynamic,guided; only static unless built with\n"
+           "                   -DUSE_RUNTIME_SCHEDULE=ON)\n");
+    printf("  --kernels LIST   kernels to time: fused, scalar, velocity, rho, pressure, step, region,\n"
+           "                   temporal\n"
+           "                   (default all)\n");
+    printf("  --steps N        steps per measurement (default NX * steps = %.0e)\n", BENCH_WORK);
+    printf("  --repeat N       measurements per configuration, the fastest is reported (default 3)\n");
+    printf("  --csv PATH       also write the results as CSV\n");
+    printf("  --help           show this message\n");
+    printf("LIST is comma separated, e.g. --nx 1000,1e6 --threads 1,8\n");
+}
+
+/* 解析逗号分隔的数值列表，允许 1e6 这样的写法 */
+static i32 parseNumberList(const char *arg, i64 *out, i32 *count)
+{
+    const char *p = arg;
+    *count = 0;
+    while (*p)
+    {
+        char *end;
+        f64 v = strtod(p, &end);
+        if (end == p || v < 1 || (*end != ',' && *end != '\0') || *count >= BENCH_MAX_LIST)
+        {
+            printf("[ERROR] Invalid list '%s'\n", arg);
+            return -1;
+        }
+        out[(*count)++] = (i64)(v + 0.5);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return *count > 0 ? 0 : -1;
+}
+
+static i32 parseSchedule(const char *text, BenchSchedule *sched)
+{
+    char kind[32];
+    const char *colon = strchr(text, ':');
+    size_t len = colon ? (size_t)(colon - text) : strlen(text);
+    if (len == 0 || len >= sizeof(kind)) return -1;
+    memcpy(kind, text, len);
+    kind[len] = '\0';
+    sched->chunk = colon ? atoi(colon + 1) : 0;
+#ifdef _OPENMP
+    if (strcmp(kind, "static") == 0)       sched->kind = omp_sched_static;
+    else if (strcmp(kind, "dynamic") == 0) sched->kind = omp_sched_dynamic;
+    else if (strcmp(kind, "guided") == 0)  sched->kind = omp_sched_guided;
+    else if (strcmp(kind, "auto") == 0)    sched->kind = omp_sched_auto;
+    else return -1;
+#else
+    if (strcmp(kind, "static") != 0 && strcmp(kind, "dynamic") != 0
+        && strcmp(kind, "guided") != 0 && strcmp(kind, "auto") != 0) return -1;
+#endif
+    return 0;
+}
+
+static i32 parseScheduleList(const char *arg, BenchOptions *opt)
+{
+    const char *p = arg;
+    opt->schedule_count = 0;
+    while (*p)
+    {
+        const char *comma = strchr(p, ',');
+        size_t len = comma ? (size_t)(comma - p) : strlen(p);
+        if (opt->schedule_count >= BENCH_MAX_LIST || len == 0 || len >= sizeof(opt->schedule_names[0]))
+        {
+            printf("[ERROR] Invalid schedule list '%s'\n", arg);
+            return -1;
+        }
+        char *name = opt->schedule_names[opt->schedule_count];
+        memcpy(name, p, len);
+        name[len] = '\0';
+        BenchSchedule *sched = &opt->schedules[opt->schedule_count];
+        if (parseSchedule(name, sched) != 0)
+        {
+            printf("[ERROR] Unknown schedule '%s'\n", name);
+            return -1;
+        }
+        sched->name = name;
+        opt->schedule_count++;
+        p = comma ? comma + 1 : p + len;
+    }
+    return opt->schedule_count > 0 ? 0 : -1;
+}
+
+static i32 parseKernelList(const char *arg, BenchOptions *opt)
+{
+    const char *p = arg;
+    opt->kernel_count = 0;
+    while (*p)
+    {
+        const char *comma = strchr(p, ',');
+        size_t len = comma ? (size_t)(comma - p) : strlen(p);
+        i32 found = -1;
+        for (i32 k = 0; k < BENCH_KERNEL_COUNT; k++)
+        {
+            if (strlen(bench_kernels[k].name) == len && strncmp(bench_kernels[k].name, p, len) == 0) found = k;
+        }
+        if (found < 0 || opt->kernel_count >= BENCH_KERNEL_COUNT)
+        {
+            printf("[ERROR] Invalid kernel list '%s'\n", arg);
+            return -1;
+        }
+        opt->kernels[opt->kernel_count++] = found;
+        p = comma ? comma + 1 : p + len;
+    }
+    return opt->kernel_count > 0 ? 0 : -1;
+}
+
+/* 返回 0 成功；1 表示已打印帮助信息；其余为错误 */
+static i32 parseArgs(i32 argc, char **argv, BenchOptions *opt)
+{
+    memset(opt, 0, sizeof(*opt));
+    for (i64 n = 1000; n <= 10000000; n *= 10) opt->nx[opt->nx_count++] = n;
+#ifdef _OPENMP
+    i32 procs = omp_get_num_procs();
+#else
+    i32 procs = 1;
+#endif
+    for (i64 p = 1; p <= procs; p *= 2) opt->threads[opt->threads_count++] = p;
+    if (opt->threads[opt->threads_count - 1] != procs) opt->threads[opt->threads_count++] = procs;
+#ifdef CFD_RUNTIME_SCHEDULE
+    parseScheduleList("static,dynamic,guided", opt);
+#else
+    parseScheduleList("static", opt);
+#endif
+    for (i32 k = 0; k < BENCH_KERNEL_COUNT; k++) opt->kernels[opt->kernel_count++] = k;
+    opt->repeat = 3;
+
+    for (i32 i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (i + 1 >= argc)
+        {
+            printf("[ERROR] Missing value for %s\n", argv[i]);
+            return -1;
+        }
+        const char *flag = argv[i], *value = argv[++i];
+        i32 status;
+        i64 list[BENCH_MAX_LIST];
+        i32 count;
+        if (strcmp(flag, "--nx") == 0)            status = parseNumberList(value, opt->nx, &opt->nx_count);
+        else if (strcmp(flag, "--threads") == 0)  status = parseNumberList(value, opt->threads, &opt->threads_count);
+        else if (strcmp(flag, "--schedule") == 0) status = parseScheduleList(value, opt);
+        else if (strcmp(flag, "--kernels") == 0)  status = parseKernelList(value, opt);
+        else if (strcmp(flag, "--steps") == 0)
+        {
+            status = parseNumberList(value, list, &count);
+            opt->steps = list[0];
+        }
+        else if (strcmp(flag, "--repeat") == 0)
+        {
+            status = parseNumberList(value, list, &count);
+            opt->repeat = (i32)list[0];
+        }
+        else if (strcmp(flag, "--csv") == 0)
+        {
+            opt->csv = value;
+            status = 0;
+        }
+        else
+        {
+            printf("[ERROR] Unknown option %s (see --help)\n", flag);
+            return -1;
+        }
+        if (status != 0) return -1;
+    }
+    for (i32 k = 0; k < opt->nx_count; k++)
+    {
+        if (opt->nx[k] < 3 || opt->nx[k] > 0x7fffffff)
+        {
+            printf("[ERROR] NX must be in [3, 2^31) (got %lld)\n", opt->nx[k]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* 对一个核推进 steps 次，重复 repeat 次取最短时间 */
+static f64 timeKernel(CfdSolver *s, const BenchKernel *kernel, i64 steps, i32 repeat)
+{
+    if (kernel->run) for (i32 w = 0; w < BENCH_WARMUP; w++) kernel->run(s);
+    else kernel->advance(s, BENCH_WARMUP);
+    f64 best = 0.0;
+    for (i32 r = 0; r < repeat; r++)
+    {
+        f64 t0 = cfdWallTime();
+        if (kernel->run) for (i64 k = 0; k < steps; k++) kernel->run(s);
+        else kernel->advance(s, steps);
+        f64 elapsed = cfdWallTime() - t0;
+        if (r == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+/* 同一 (NX, 调度, 核) 下线程数最少的结果，作为加速比的基准 */
+static const BenchResult *findBaseline(const BenchResult *results, i32 count, const BenchResult *r)
+{
+    const BenchResult *base = NULL;
+    for (i32 k = 0; k < count; k++)
+    {
+        const BenchResult *c = &results[k];
+        if (c->nx != r->nx || c->schedule != r->schedule || c->kernel != r->kernel) continue;
+        if (base == NULL || c->threads < base->threads) base = c;
+    }
+    return base;
+}
+
+static void report(const BenchOptions *opt, const BenchResult *results, i32 count)
+{
+    FILE *csv = NULL;
+    if (opt->csv)
+    {
+        csv = fopen(opt->csv, "w");
+        if (csv == NULL) printf("[WARN] Cannot open %s for writing; skipping CSV output.\n", opt->csv);
+        else fprintf(csv, "nx,threads,schedule,kernel,steps,seconds,ns_per_point,mpoints_per_s,speedup,efficiency\n");
+    }
+
+    printf("\n%10s %7s %-12s %-9s %10s %12s %12s %8s %8s\n",
+           "nx", "threads", "schedule", "kernel", "steps", "ns/point", "Mpoint/s", "speedup", "eff");
+    for (i32 k = 0; k < count; k++)
+    {
+        const BenchResult *r = &results[k];
+        const BenchResult *base = findBaseline(results, count, r);
+        f64 updates = (f64)r->nx * (f64)r->steps;
+        f64 ns = r->seconds / updates * 1e9;
+        /* 以线程数最少的配置为基准：加速比 = T_base / T，效率 = 加速比 * p_base / p */
+        f64 speedup = (base->seconds / base->steps) / (r->seconds / r->steps);
+        f64 efficiency = speedup * base->threads / r->threads;
+        const char *sched = opt->schedules[r->schedule].name;
+        const char *kernel = bench_kernels[r->kernel].name;
+        printf("%10d %7d %-12s %-9s %10lld %12.3f %12.2f %8.2f %7.1f%%\n",
+               r->nx, r->threads, sched, kernel, r->steps, ns, updates / r->seconds * 1e-6,
+               speedup, efficiency * 100.0);
+        if (csv)
+        {
+            fprintf(csv, "%d,%d,%s,%s,%lld,%.9g,%.9g,%.9g,%.6g,%.6g\n", r->nx, r->threads, sched, kernel,
+                    r->steps, r->seconds, ns, updates / r->seconds * 1e-6, speedup, efficiency);
+        }
+    }
+    if (csv)
+    {
+        fclose(csv);
+        printf("[INFO] Wrote benchmark results to %s\n", opt->csv);
+    }
+}
+
+i32 main(i32 argc, char **argv)
+{
+    BenchOptions opt;
+    i32 status = parseArgs(argc, argv, &opt);
+    if (status == 1) return 0;
+    if (status != 0) return -1;
+
+#ifndef _OPENMP
+    printf("[WARN] Built without OpenMP; thread counts and schedules are ignored.\n");
+    opt.threads_count = 1;
+    opt.threads[0] = 1;
+    opt.schedule_count = 1;
+#elif !defined(CFD_RUNTIME_SCHEDULE)
+    /* 更新核编译为 schedule(static)，只有 USE_RUNTIME_SCHEDULE 构建才能比较调度方式 */
+    if (opt.schedule_count > 1 || opt.schedules[0].kind != omp_sched_static || opt.schedules[0].chunk > 0)
+        printf("[WARN] Kernels are compiled with schedule(static); configure with -DUSE_RUNTIME_SCHEDULE=ON to compare schedules.\n");
+    parseScheduleList("static", &opt);
+#endif
+
+    i32 capacity = opt.nx_count * opt.threads_count * opt.schedule_count * opt.kernel_count;
+    BenchResult *results = (BenchResult *)calloc((size_t)capacity, sizeof(BenchResult));
+    if (!results)
+    {
+        printf("[ERROR] Memory allocation failed for benchmark results\n");
+        return -1;
+    }
+    i32 count = 0;
+
+    for (i32 a = 0; a < opt.nx_count; a++)
+    {
+        const i32 nx = (i32)opt.nx[a];
+        i64 steps = opt.steps > 0 ? opt.steps : (i64)(BENCH_WORK / nx);
+        if (steps < BENCH_MIN_STEPS) steps = BENCH_MIN_STEPS;
+
+        for (i32 b = 0; b < opt.threads_count; b++)
+        {
+            const i32 threads = (i32)opt.threads[b];
+#ifdef _OPENMP
+            omp_set_num_threads(threads);
+#endif
+            /* 每个线程数重新创建求解器，使首次写入的页面划分与线程数一致 */
+            CfdConfig cfg;
+            cfdConfigDefaults(&cfg);
+            cfg.nx = nx;
+            CfdSolver *s = cfdSolverCreate(&cfg);
+            if (s == NULL)
+            {
+                printf("[WARN] Skipping NX=%d with %d threads\n", nx, threads);
+                continue;
+            }
+
+            for (i32 c = 0; c < opt.schedule_count; c++)
+            {
+#ifdef _OPENMP
+                omp_set_schedule(opt.schedules[c].kind, opt.schedules[c].chunk);
+#endif
+                for (i32 d = 0; d < opt.kernel_count; d++)
+                {
+                    const BenchKernel *kernel = &bench_kernels[opt.kernels[d]];
+                    BenchResult *r = &results[count++];
+                    r->nx = nx;
+                    r->threads = threads;
+                    r->schedule = c;
+                    r->kernel = opt.kernels[d];
+                    r->steps = steps;
+                    r->seconds = timeKernel(s, kernel, steps, opt.repeat);
+                    printf("[INFO] NX=%d threads=%d schedule=%s kernel=%s: %.3f ns/point\n",
+                           nx, threads, opt.schedules[c].name, kernel->name,
+                           r->seconds / ((f64)nx * steps) * 1e9);
+                    fflush(stdout);
+                }
+            }
+            cfdTemporalDestroy(bench_temporal);
+            bench_temporal = NULL;
+            cfdSolverDestroy(s);
+        }
+    }
+
+    report(&opt, results, count);
+    free(results);
+    return 0;
+}
@@ -0,0 +1,49 @@
+/*
+    include/cfd_active.h
+    活动区跟踪：声波前沿之前仍与初始状态逐位相同的一段网格不逐点更新
+*/
+#ifndef CFD_ACTIVE_H
+#define CFD_ACTIVE_H
+
+#include "constants.h"
+#include "cfd_util.h"
+
+/*
+    波前之前的点在活塞坐标系中并不静止（惯性力 -a 作用在每个点上），但它们彼此逐位相同：
+    三点模板的差分全为零，融合核对每个点给出同样的结果。因此只需记住一段均匀段 [lo, hi)
+    及其中的一个代表值，每步用同一个核推进代表值，逐点循环只覆盖 [1, lo] 与 [hi - 1, nx - 2]
+    以及两端边界。模板半径为 1，每步只有段两端的点可能与代表值不同，推进后逐位比较，
+    不同则把该点移出均匀段（不用波速加安全余量估计，判据是零阈值的逐点变化），结果与逐点更新逐位相同。
+    均匀段在两端相遇后跟踪结束，此后每步更新全部网格。
+*/
+typedef struct CfdActive {
+    i32 lo, hi;                     // 均匀段 [lo, hi)，1 <= lo < hi <= nx
+    f64 rho, vel, pres;             // 段内当前步的值（pres 只在存储压力场时使用）
+    f64 rho_prev;                   // 段内上一步的密度（导出压力时 rho_next 中应有的值）
+} CfdActive;
+
+/*
+    按当前数组识别均匀段：从右端 nx - 1 向左与之逐位相同的最长一段。
+    s 上原有的跟踪状态先被释放；识别不出（不到两个点）时 s->active 为 NULL
+*/
+void    cfdActiveStart      (CfdSolver *s);
+
+/* 把均匀段写回数组后结束跟踪 */
+void    cfdActiveStop       (CfdSolver *s);
+
+/*
+    代替 updateBorders/updateFlowField/updatePressure 推进一步（不交换缓冲区），
+    并更新均匀段与代表值；均匀段为空时结束跟踪。返回实际逐点更新的网格点数
+*/
+i32     cfdActiveStep       (CfdSolver *s, f64 acc);
+
+/* 把均匀段写入当前步的数组（vel/rho，存储压力时 pres，导出压力时 rho_next），供输出与检查点读取 */
+void    cfdActiveFill       (CfdSolver *s);
+
+/* 点 i 在均匀段内时按代表值写出 out[0..2]（与 cfdSolverPoint 相同）并返回 1，否则返回 0 */
+i32     cfdActivePoint      (const CfdSolver *s, i32 i, f64 *out);
+
+/* 均匀段外各点与代表值的 max|v| */
+f64     cfdActiveMaxSpeed   (const CfdSolver *s);
+
+#endif /* CFD_ACTIVE_H */
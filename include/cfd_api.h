@@ -0,0 +1,88 @@
+/*
+    include/cfd_api.h
+    求解器库 libcfd 的稳定 C 接口：用不透明句柄在进程内创建、推进与读取算例，供 Python 等调用方直接驱动
+*/
+#ifndef CFD_API_H
+#define CFD_API_H
+
+/*
+    这个头文件只用标准 C 类型，不包含 constants.h，也不暴露 CfdSolver 的布局，
+    结构体的增删不影响调用方；只在接口不兼容地改变时增加 CFD_API_VERSION。
+    共享库 libcfd 只导出这里的 cfdLib* 函数；静态链接时它们在 libcfd_core 中。
+
+    每个句柄独占一个求解器，库内没有可写的全局状态，不同线程可以同时使用不同的句柄；
+    同一个句柄不能被多个线程同时使用。出错时在标准输出打印 [ERROR] 信息。
+*/
+#define CFD_API_VERSION     1
+
+#if defined(CFD_API_BUILD) && (defined(__GNUC__) || defined(__clang__))
+#define CFD_API __attribute__((visibility("default")))
+#else
+#define CFD_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct CfdHandle CfdHandle;
+
+/* cfdLibField 的 field */
+#define CFD_LIB_RHO     0           // 密度 (kg/m^3)
+#define CFD_LIB_VEL     1           // 速度 (m/s)
+#define CFD_LIB_PRES    2           // 压力 (Pa)
+#define CFD_LIB_X       3           // 网格点坐标 (m)，拉伸网格时不均匀
+
+/* 库实际实现的接口版本 CFD_API_VERSION，调用方用它检查加载到的库是否匹配 */
+CFD_API int         cfdLibVersion   (void);
+
+/*
+    按参数创建一个算例并初始化流场。options 为若干 "key = value"，以换行或分号分隔，
+    键与配置文件相同（nx、dx、dt、precision、stepper、persistent……），NULL 或空串表示全部用默认值。
+    只使用求解器本身的参数：输出、探针、检查点、实时发布、扫描与集合运行由调用方自己处理，
+    步长固定为 dt（不做 cfl 自适应）。失败返回 NULL
+*/
+CFD_API CfdHandle * cfdLibCreate    (const char *options);
+CFD_API void        cfdLibDestroy   (CfdHandle *h);
+
+/*
+    换用另一条活塞加速度曲线 a(t) = amplitude * (dc + Σ a_n cos(w_n t) + b_n sin(w_n t))，
+    w_n = 2πn / period，从当前时刻起生效。coef 为 n 对 (a_n, b_n)（n = 1, 2, ... 依次排列），
+    超出的谐波为 0，n 至多为 cfdLibHarmonics()；coef 为 NULL 时保留题设曲线的系数。成功返回 0
+*/
+CFD_API int         cfdLibSetProfile(CfdHandle *h, double period, double dc, double amplitude,
+                                     const double *coef, int n);
+
+/* 活塞加速度级数的最大谐波数 */
+CFD_API int         cfdLibHarmonics (void);
+
+/*
+    推进 nsteps 步，返回实际推进的步数。看门狗（见 watchdog）发现发散时提前停止，
+    之后再调用也不再推进，原因见 cfdLibStatus。融合核每步检查；多级格式、卸载等路径与 sim 一样
+    每 nan_check（为 0 时取 print_after_steps）步扫描一次，扫描点按句柄累计的步数计，与每次推进多少步无关。
+    参数无效时返回 -1
+*/
+CFD_API long long   cfdLibStep      (CfdHandle *h, long long nsteps);
+
+/*
+    当前步的一个场（CFD_LIB_*），*data 指向求解器自己的 nx 个 double，不做复制。
+    求解器交替使用两组缓冲区，指针只在下一次 cfdLibStep 或 cfdLibDestroy 之前有效，
+    每步之后需要重新获取；调用方不应写入。返回 nx，field 无效时返回 -1
+*/
+CFD_API int         cfdLibField     (CfdHandle *h, int field, const double **data);
+
+CFD_API double      cfdLibTime      (const CfdHandle *h);   // 当前时刻 (s)
+CFD_API long long   cfdLibSteps     (const CfdHandle *h);   // 已推进的步数
+CFD_API double      cfdLibDt        (const CfdHandle *h);   // 时间步长 (s)
+
+/*
+    看门狗的状态：0 为正常，1 为出现非有限值，2 为密度不为正，3 为 CFL 数超过格式的稳定上限。
+    reason 非空时写入原因的说明文字（正常时为空串）
+*/
+CFD_API int         cfdLibStatus    (const CfdHandle *h, const char **reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CFD_API_H */
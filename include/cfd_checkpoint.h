@@ -0,0 +1,103 @@
+/*
+    include/cfd_checkpoint.h
+    检查点与断点续算：求解器完整状态的二进制转储，原子替换写入，后台线程落盘
+*/
+#ifndef CFD_CHECKPOINT_H
+#define CFD_CHECKPOINT_H
+
+#include <pthread.h>
+#include "constants.h"
+#include "cfd_util.h"
+
+#define CFD_CHECKPOINT_MAGIC    "CFDCKPT1"
+#define CFD_CHECKPOINT_VERSION  1
+#define CFD_CHECKPOINT_FILE     "checkpoint.bin"
+
+/*
+    检查点文件格式（本机字节序与结构体布局，只保证同一份程序读回）：
+      文件头（CfdCheckpointHeader），随后是 payload_bytes 字节的数据：
+        CfdRunState；
+        每个求解器（主求解器，有 shadow 时再跟一个）一段：CfdCheckpointSolver，随后是流场数组。
+    流场数组只存下一步真正要读的部分，其余缓冲区每步都会被整体重写：
+        f64 存储压力         rho, vel, pres
+        f64 导出压力         rho, vel, rho_next（上一步的密度，边界的压力差由它求出）
+        混合精度             drho, vel32, drho_next，存储压力时再加 dpres
+    checksum 为 payload 的 FNV-1a 64 位散列，读回时校验，防止截断或损坏的文件被当作有效状态。
+*/
+typedef struct {
+    char magic[8];                  // "CFDCKPT1"
+    u32  version;                   // CFD_CHECKPOINT_VERSION
+    u32  header_bytes;              // 文件头字节数（= sizeof(CfdCheckpointHeader)）
+    i32  nx;                        // 网格点数
+    i32  precision;                 // CFD_PRECISION_*
+    i32  derived_pressure;          // 是否导出压力
+    i32  solvers;                   // 求解器段数（1，或带 shadow 时为 2）
+    u64  payload_bytes;             // 文件头之后的数据字节数
+    u64  checksum;                  // payload 的 FNV-1a 散列
+} CfdCheckpointHeader;
+
+/* 主循环中不属于求解器的状态，续算时原样交回 */
+typedef struct {
+    f64 total_timer;                // 固定步长：下一个快照判定时刻
+    f64 next_snapshot;              // 自适应：下一个快照时刻
+    i64 snapshot_index;             // 自适应：下一个快照的序号
+    f64 dt_cfl;                     // 自适应：最近一次估计的稳定步长
+    i64 output_frames;              // 已写入 snapshots.bin 的帧数
+    i64 output_calls;               // cfdOutputWrite 的调用次数（用于 output_every 抽取）
+    i64 probe_samples;              // 已写入 probes.bin 的记录数
+} CfdRunState;
+
+/* 每个求解器段的标量部分；PistonAccel 中的 profile 指针在读回时重新指向 CfdSolver.profile */
+typedef struct {
+    f64 dx, dt, half_dt2;
+    f64 t;
+    i64 step;
+    PistonProfile profile;
+    PistonAccel pa;
+} CfdCheckpointSolver;
+
+/*
+    检查点写入器。cfdCheckpointSave 在求解线程中把状态复制到内存缓冲区（一次 memcpy 的代价），
+    散列、写文件、fsync 与改名在后台线程中完成，推进循环不等待磁盘。
+    先写 <path>.tmp，完整落盘后再 rename 覆盖 <path>，任何时刻中断都只会留下旧的或新的完整检查点。
+*/
+typedef struct {
+    char path[CFD_PATH_MAX];
+    char tmp_path[CFD_PATH_MAX + 8];
+    char *buffer;                   // 文件头 + payload
+    size_t bytes;                   // 当前待写出的字节数
+    size_t capacity;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    i32 pending;                    // 缓冲区中有尚未写出的检查点
+    i32 stop;
+    i64 written;                    // 已完整写出的检查点个数
+    i64 skipped;                    // 因上一个检查点仍在写出而跳过的次数
+    f64 write_seconds;              // 后台写出累计耗时
+} CfdCheckpoint;
+
+/* 检查点文件为 cfg->checkpoint，空串时为 <output_dir>/checkpoint.bin；失败返回 NULL */
+CfdCheckpoint * cfdCheckpointOpen   (const CfdConfig *cfg);
+
+/*
+    保存当前状态（s 及其 shadow，加上 rs）。上一个检查点还在写出时跳过本次并返回 1，
+    成功提交返回 0，失败返回 -1。调用前输出队列须已清空（见 cfdOutputFlush），
+    使 rs->output_frames 帧确实都已在文件中。
+*/
+i32             cfdCheckpointSave   (CfdCheckpoint *ck, const CfdSolver *s, const CfdRunState *rs);
+
+/* 等待正在写出的检查点落盘（不再有 pending），之后的 cfdCheckpointSave 不会被跳过 */
+void            cfdCheckpointWait   (CfdCheckpoint *ck);
+
+/* 等待后台写出完成并释放 */
+void            cfdCheckpointClose  (CfdCheckpoint *ck);
+
+/*
+    从检查点恢复。s 须已按相同的配置创建（网格、精度、压力模式与 shadow 须与检查点一致），
+    读回后 s 与写检查点时逐位相同。成功返回 0。
+*/
+i32             cfdCheckpointLoad   (const CfdConfig *cfg, CfdSolver *s, CfdRunState *rs);
+
+#endif /* CFD_CHECKPOINT_H */
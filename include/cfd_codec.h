@@ -0,0 +1,53 @@
+/*
+    include/cfd_codec.h
+    压缩快照的字段编码：预测残差 + 字节重排 + 按字节平面的零压缩
+*/
+#ifndef CFD_CODEC_H
+#define CFD_CODEC_H
+
+#include <stddef.h>
+#include "constants.h"
+
+#define CFD_CODEC_SPATIAL       0   // 只在帧内预测（关键帧）：残差为相邻两点的键之差
+#define CFD_CODEC_TEMPORAL      1   // 帧间预测：残差为相邻两点相对上一帧的变化之差
+
+#define CFD_CODEC_PLANE_ZERO    0   // 字节平面全为零，不存数据
+#define CFD_CODEC_PLANE_SPARSE  1   // 非零字节的位图（ceil(n/8) 字节，低位在前）+ 按顺序排列的非零字节
+#define CFD_CODEC_PLANE_RAW     2   // n 个字节原样存储
+
+/*
+    一个字段的 n 个 f64 先映射成 u64 的键：
+      无损（quantum = 0）：IEEE 位模式的保序映射，负数取反、非负数置最高位，相邻的数键也相邻；
+      有损（quantum > 0）：键为 llround(x / quantum) 的补码，还原值为 键 * quantum。
+    帧间预测先取相对上一帧的变化 d[i] = 键[i] - 上一帧键[i]（帧内预测时 d[i] = 键[i]），
+    残差为 r[i] = d[i] - d[i-1]（r[0] = d[0]，均模 2^64），即 fpzip 一类的 Lorenzo 预测：
+    波形在相邻两帧间平移、整体抬升时相邻点的变化几乎相同。残差按 zigzag 映射成小的无符号数后
+    拆成 8 个字节平面（平面 k 为各残差的第 k 个字节，低位在前），每个平面以一个模式字节
+    CFD_CODEC_PLANE_* 开头，取三种存法中最短的一种。未受扰动的区域残差全为零，高位平面几乎不占空间。
+*/
+
+/* 编码一个 n 点字段最多需要的字节数 */
+size_t  cfdCodecBound       (i32 n);
+
+/* 无损的键 */
+void    cfdCodecKeys        (const f64 *x, i32 n, u64 *key);
+
+/*
+    有损的键：还原值与原值之差不超过 quantum / 2（按 f64 运算逐点校验）。
+    有非有限值或 |x| / quantum 不小于 2^52 时返回 -1，此时应改用无损编码
+*/
+i32     cfdCodecQuantize    (const f64 *x, i32 n, f64 quantum, u64 *key);
+
+/* 由键还原字段值（quantum 与编码时相同） */
+void    cfdCodecValues      (const u64 *key, i32 n, f64 quantum, f64 *x);
+
+/*
+    把键编码到 dst（至少 cfdCodecBound(n) 字节）。prev 非空时按时间预测，否则按空间预测；
+    scratch 为 n 个 u64 的工作区。返回写出的字节数
+*/
+size_t  cfdCodecEncode      (const u64 *key, const u64 *prev, i32 n, u64 *scratch, u8 *dst);
+
+/* 由 src 的 bytes 个字节解码出 n 个键（prev 与编码时相同）；数据不完整或损坏时返回 -1 */
+i32     cfdCodecDecode      (const u8 *src, size_t bytes, const u64 *prev, i32 n, u64 *key);
+
+#endif /* CFD_CODEC_H */
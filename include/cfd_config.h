@@ -0,0 +1,95 @@
+/*
+    include/cfd_config.h
+    运行参数（网格、时间步长、输出间隔等）的默认值、命令行与配置文件解析
+*/
+#ifndef CFD_CONFIG_H
+#define CFD_CONFIG_H
+
+#include "constants.h"
+
+#define CFD_PATH_MAX 512
+#define CFD_PROBE_MAX 64                // 探针个数上限
+
+typedef struct {
+    i32 nx;                         // X 方向的仿真点数
+    f64 dx;                         // X 方向的空间步长 (m)
+    f64 grid_stretch;               // 拉伸网格的系数 β（见 cfd_grid.h），0 表示均匀网格
+    f64 grid_length;                // 拉伸网格的管长 (m)，0 表示与均匀网格相同的 (nx - 1) * dx
+    f64 dt;                         // 时间步长 (s)
+    f64 t_end;                      // 结束时间 (s)
+    f64 timer;                      // 保存时间间隔 (s)
+    i32 print_after_steps;          // 每隔多少步更新一次终端输出
+    i32 quiet;                      // 不输出进度（批处理作业）
+    i32 piston_source;              // 活塞加速度的来源 CFD_PISTON_*（见 cfd_util.h）
+    i32 piston_recurrence;          // 活塞加速度是否使用递推求值
+    i32 simd;                       // 融合核内部点的实现 CFD_SIMD_*（见 cfd_simd.h），默认自动选择
+    i32 stepper;                    // 时间推进格式 CFD_STEPPER_*（见 cfd_stepper.h），默认 Taylor
+    i32 persistent_region;          // 固定步长时在常驻并行区内连续推进（见 cfdSolverAdvance）
+    i32 temporal_depth;             // 固定步长时按时间分块推进，每个 tile 载入一次推进的步数（见 cfd_temporal.h），0 表示不分块
+    i32 temporal_tile;              // 时间分块的 tile 点数，0 表示按 L2 容量自动选取
+    i32 active_region;              // 跟踪活动区，前沿之前的均匀段只推进一个代表值（见 cfd_active.h）
+    i32 precision;                  // 流场存储精度 CFD_PRECISION_*（见 cfd_util.h）
+    i32 precision_check;            // 混合精度时同时推进一份 f64 解并报告误差
+    i32 derived_pressure;           // 不存储压力场，按状态方程在边界与输出时求出
+    f64 cfl;                        // 自适应时间步的 CFL 数，0 表示固定步长
+    i32 cfl_interval;               // 每隔多少步重新估计一次稳定步长
+    char output_dir[CFD_PATH_MAX];  // 快照输出目录
+    i32 output_format;              // 快照格式，CFD_OUTPUT_* 的组合（见 cfd_output.h）
+    i32 output_queue;               // 异步写出的队列深度，0 表示同步写出
+    i32 output_stride;              // 空间采样间隔（网格点数）
+    i32 output_window_start;        // 输出窗口起点（网格下标，含）
+    i32 output_window_end;          // 输出窗口终点（网格下标，不含），-1 表示到末端
+    i32 output_every;               // 每隔多少个快照时刻写出一帧
+    i32 output_sampling;            // 采样方式 CFD_SAMPLE_*（见 cfd_output.h）
+    f64 output_error;               // 压缩快照中速度的绝对误差界 (m/s)，0 表示无损（见 cfd_output.h）
+    char perf_json[CFD_PATH_MAX];   // 性能汇总 JSON 文件，空串表示 <output_dir>/perf.json
+    char ensemble[CFD_PATH_MAX];    // 集合运行的成员列表文件，空串表示单个算例（见 cfd_ensemble.h）
+    i32 ensemble_layout;            // 集合运行方式 CFD_ENSEMBLE_*
+    f64 checkpoint_interval;        // 每隔多少秒墙钟时间写一次检查点，0 表示不写
+    char checkpoint[CFD_PATH_MAX];  // 检查点文件，空串表示 <output_dir>/checkpoint.bin（见 cfd_checkpoint.h）
+    i32 restart;                    // 从检查点恢复后继续推进
+    i32 probe_count;                // 探针个数，0 表示不记录探针时间序列（见 cfd_probe.h）
+    i32 probe_idx[CFD_PROBE_MAX];   // 探针的网格下标，负数从末端数起（-1 为 nx-1）
+    i32 probe_every;                // 每隔多少步采样一次探针
+    char live[CFD_PATH_MAX];        // 实时发布的共享内存对象名，空串表示不发布（见 cfd_live.h）
+    i32 live_every;                 // 每隔多少步发布一次
+    i32 live_slots;                 // 环形缓冲区的槽数
+    i32 watchdog;                   // 每步在融合核内检查 max|v|、min rho 与非有限值，发散或超过 CFL 上限时中止（见 CfdWatch）
+    i32 nan_check;                  // 核内不归约的推进路径每隔多少步扫描一次流场，0 表示开启看门狗时取 print_after_steps、否则不扫描
+    char sweep[CFD_PATH_MAX];       // 参数扫描的作业列表文件，空串表示不扫描（见 cfd_sweep.h）
+    i32 sweep_split_nx;             // 参数扫描中 nx 不小于此值的作业用全部线程运行
+} CfdConfig;
+
+/* 用 constants.h 中的默认值填充 */
+void    cfdConfigDefaults   (CfdConfig *cfg);
+
+/* 设置单个参数，key 与配置文件中的键名相同；成功返回 0 */
+i32     cfdConfigSet        (CfdConfig *cfg, const char *key, const char *value);
+
+/*
+    一次设置多个参数：text 为若干 "key = value"，以换行或分号分隔，# 之后为注释（与配置文件相同，
+    但没有 [run] 段）。遇到第一个无效的项即停止并返回非 0，之前的项已经生效
+*/
+i32     cfdConfigSetString  (CfdConfig *cfg, const char *text);
+
+/* 检查参数是否合法，不合法时打印原因并返回非 0 */
+i32     cfdConfigValidate   (const CfdConfig *cfg);
+
+/*
+    读取配置文件。格式为每行一个 "key = value"，# 开头为注释。
+    出现 [run] 时开始一组新的运行参数，继承文件开头（第一个 [run] 之前）的公共设置，
+    由此一个配置文件可以描述一批不同分辨率的算例。
+    *runs 由调用者 free，返回 0 表示成功。
+*/
+i32     cfdConfigLoadFile   (const char *path, const CfdConfig *base, CfdConfig **runs, i32 *count);
+
+/*
+    解析命令行，得到本次要运行的全部参数组。
+    --config 指定的文件先被读入，其余命令行选项覆盖到每一组参数上。
+    返回 0 成功；返回 1 表示已打印帮助信息；其余为错误。
+*/
+i32     cfdConfigParseArgs  (i32 argc, char **argv, CfdConfig **runs, i32 *count);
+
+void    cfdConfigPrintUsage (const char *prog);
+
+#endif /* CFD_CONFIG_H */
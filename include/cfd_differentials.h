@@ -7,16 +7,19 @@
 
 
 #include "constants.h"
-f64     prho_pt     (i32 idx);
-f64     pprho_ppt   (i32 idx, f64 time);
+#include "cfd_util.h"
 
-f64     pvx_pt      (i32 idx, f64 time);
-f64     ppvx_ppt    (i32 idx, f64 time);
+/* acc 为当前时间步的活塞加速度，由调用者每步计算一次后传入 */
+f64     prho_pt     (const CfdSolver *s, i32 idx);
+f64     pprho_ppt   (const CfdSolver *s, i32 idx, f64 acc);
 
-f64     prho_px     (i32 idx);
-f64     pprho_ppx   (i32 idx);
+f64     pvx_pt      (const CfdSolver *s, i32 idx, f64 acc);
+f64     ppvx_ppt    (const CfdSolver *s, i32 idx, f64 acc);
 
-f64     pvx_px      (i32 idx);
-f64     ppvx_ppx    (i32 idx);
+f64     prho_px     (const CfdSolver *s, i32 idx);
+f64     pprho_ppx   (const CfdSolver *s, i32 idx);
+
+f64     pvx_px      (const CfdSolver *s, i32 idx);
+f64     ppvx_ppx    (const CfdSolver *s, i32 idx);
 
 #endif /*__CFD_DIFFERENTIALS_H*/
\ No newline at end of file
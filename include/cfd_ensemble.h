@@ -0,0 +1,72 @@
+/*
+    include/cfd_ensemble.h
+    集合运行：同一网格上一批不同活塞加速度曲线的算例在一个进程内一起推进
+*/
+#ifndef CFD_ENSEMBLE_H
+#define CFD_ENSEMBLE_H
+
+#include "constants.h"
+#include "cfd_config.h"
+#include "cfd_util.h"
+#include "cfd_eos.h"
+#include "cfd_report.h"
+
+#define CFD_ENSEMBLE_INTERLEAVED    0   // 成员维在最内层（[i * members + m]），一个核同时推进全部成员，成员维向量化
+#define CFD_ENSEMBLE_MEMBER         1   // 每个线程从头到尾独立推进一个成员（各自的 CfdSolver）
+
+#define CFD_ENSEMBLE_NAME_MAX       64
+
+typedef struct {
+    char name[CFD_ENSEMBLE_NAME_MAX];   // 成员名，快照写到 <output_dir>/<name>/
+    PistonProfile profile;              // 活塞加速度曲线
+} CfdEnsembleMember;
+
+/*
+    读取成员列表。格式与配置文件相同（每行 "key = value"，# 为注释），
+    [member] 开始一个新成员，继承第一个 [member] 之前的公共设置。可用的键：
+        name        成员名（默认 member_000、member_001……）
+        period      周期 (s)
+        dc          常数项 a0/2
+        amplitude   整体缩放系数
+        harmonics   只保留前 N 个谐波
+        harmonic    "n a_n b_n"，设置第 n 个谐波的系数（可多行）
+    未设置的项取题设曲线的值。*members 由调用者 free，返回 0 表示成功。
+*/
+i32     cfdEnsembleLoad     (const char *path, CfdEnsembleMember **members, i32 *count);
+
+/* 设置成员的一项（上面列出的键），参数扫描的作业列表也用它设置活塞曲线；成功返回 0 */
+i32     cfdEnsembleMemberSet(CfdEnsembleMember *mb, const char *key, const char *value);
+
+/*
+    交错布局的集合求解器。所有成员共用网格与固定步长，只有活塞加速度不同；
+    压力按状态方程由上一步的密度导出（见 derived_pressure），不存储压力场。
+    每个成员的结果与单独运行 sim 逐位相同。
+*/
+typedef struct {
+    i32 nx;                         // 仿真点数
+    i32 members;                    // 成员数
+    f64 dx, dt, half_dt2;
+    i32 simd;                       // 成员维循环的实现 CFD_SIMD_*
+
+    f64 *rho, *vel;                 // 当前步，rho[i * members + m]
+    f64 *rho_next, *vel_next;       // 下一步；交换后 rho_next 为上一步的密度
+    PistonAccel *pa;                // 每个成员的活塞加速度上下文
+    f64 *acc;                       // 当前时刻每个成员的加速度
+    CfdEos eos;
+
+    f64 t;
+    i64 step;
+    CfdTimers timers;
+} CfdEnsemble;
+
+CfdEnsemble *   cfdEnsembleCreate   (const CfdConfig *cfg, const CfdEnsembleMember *members, i32 count);
+void            cfdEnsembleDestroy  (CfdEnsemble *e);
+void            cfdEnsembleStep     (CfdEnsemble *e);
+
+/* 取出成员 m 当前步的 rho/vel/pres（各 nx 个点） */
+void            cfdEnsembleGather   (const CfdEnsemble *e, i32 m, f64 *rho, f64 *vel, f64 *pres);
+
+/* 读取 cfg->ensemble 中的成员列表，按 cfg->ensemble_layout 运行到 t_end 并写出每个成员的快照 */
+i32             cfdEnsembleRun      (const CfdConfig *cfg);
+
+#endif /* CFD_ENSEMBLE_H */
@@ -0,0 +1,40 @@
+/*
+    include/cfd_eos.h
+    状态方程 p = p(rho)：导出压力模式（derived_pressure）下边界与输出处按需求压力
+*/
+#ifndef CFD_EOS_H
+#define CFD_EOS_H
+
+#include "constants.h"
+
+typedef struct CfdEos CfdEos;
+
+/* 由密度求压力；eos 中带有模型参数 */
+typedef f64 (*CfdEosPressureFn)(const CfdEos *eos, f64 rho);
+
+/*
+    状态方程挂钩。求解器只通过 pressure 调用状态方程，换用其他模型时
+    填入新的函数与参数即可，无需改动各个核。
+*/
+struct CfdEos {
+    const char *name;               // 模型名称（日志输出）
+    CfdEosPressureFn pressure;      // p(rho)
+    f64 gas_constant;               // 比气体常数 R / MU_STAR (J/(kg·K))
+    f64 temperature;                // 温度 (K)
+};
+
+/* 等温理想气体 p = R / MU_STAR * rho * T，与 updatePressure 的计算逐位相同 */
+void    cfdEosIsothermal    (CfdEos *eos, f64 temperature);
+
+/* eos 是否为等温模型（设备上的核直接展开它，见 cfd_offload.h） */
+i32     cfdEosIsIsothermal  (const CfdEos *eos);
+
+static inline f64 cfdEosPressure(const CfdEos *eos, f64 rho)
+{
+    return eos->pressure(eos, rho);
+}
+
+/* pres[i] = p(rho[i])，i ∈ [0, n)，OpenMP 并行 */
+void    cfdEosFill          (const CfdEos *eos, const f64 *rho, f64 *pres, i32 n);
+
+#endif /* CFD_EOS_H */
@@ -0,0 +1,42 @@
+/*
+    include/cfd_grid.h
+    拉伸网格：点向活塞面加密的坐标映射，以及由映射度量预先求出的逐点差分系数
+*/
+#ifndef CFD_GRID_H
+#define CFD_GRID_H
+
+#include "constants.h"
+
+/*
+    计算空间 ξ ∈ [0, 1] 上均匀分布 nx 个点（Δξ = 1/(nx - 1)），物理坐标由单侧 tanh 映射给出：
+        x(ξ) = L * (1 - tanh(β(1 - ξ)) / tanh(β))
+    β > 0 越大，点越向活塞面（ξ = 0）集中：活塞面处的间距约为均匀网格的 2β / sinh(2β) 倍，
+    开口端约为 β / tanh(β) 倍，相邻间距之比为 1 + O(β Δξ)。
+    内部点的导数取过 (i-1, i, i+1) 三点的抛物线的导数（对 x 的二次多项式精确），
+    写成均匀网格的中心差分加一项修正，系数预先求出：
+        f_x  ≈ d1[i] * (f[i+1] - f[i-1]) + d1s[i] * (f[i+1] - 2 f[i] + f[i-1])
+        f_xx ≈ d2[i] * (f[i+1] - 2 f[i] + f[i-1]) + d2s[i] * (f[i+1] - f[i-1])
+    均匀网格对应 d1 = 1/(2dx)、d2 = 1/dx^2、d1s = d2s = 0。
+    只用链式法则 f_x = f_ξ / x_ξ 换算时系数只对 ξ 的二次多项式精确，实测在活塞附近误差大一到两个量级。
+*/
+typedef struct {
+    i32 nx;                         // 网格点数
+    f64 stretch;                    // 拉伸系数 β
+    f64 length;                     // 管长 L (m)
+    f64 *x;                         // 各点坐标 (m)，nx 个
+    f64 *d1;                        // 一阶导数中一阶差分的系数，nx 个（端点为 0）
+    f64 *d1s;                       // 一阶导数中二阶差分的系数
+    f64 *d2;                        // 二阶导数中二阶差分的系数
+    f64 *d2s;                       // 二阶导数中一阶差分的系数
+    f64 dx_min;                     // 最小间距 x[1] - x[0]（活塞面处）
+    f64 dx_max;                     // 最大间距 x[nx-1] - x[nx-2]（开口端）
+} CfdGrid;
+
+/* 映射 x(ξ) / L，ξ ∈ [0, 1]；stretch <= 0 时为恒等映射 */
+f64         cfdGridMap      (f64 xi, f64 stretch);
+
+/* 生成 nx 个点、管长 length、拉伸系数 stretch (> 0) 的网格；失败返回 NULL */
+CfdGrid *   cfdGridCreate   (i32 nx, f64 length, f64 stretch);
+void        cfdGridDestroy  (CfdGrid *g);
+
+#endif /* CFD_GRID_H */
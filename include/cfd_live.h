@@ -0,0 +1,71 @@
+/*
+    include/cfd_live.h
+    实时发布：把当前流场写入 POSIX 共享内存中的环形缓冲区，供可视化脚本直接映射读取
+*/
+#ifndef CFD_LIVE_H
+#define CFD_LIVE_H
+
+#include "constants.h"
+#include "cfd_config.h"
+#include "cfd_output.h"
+#include "cfd_util.h"
+
+#define CFD_LIVE_MAGIC          "CFDLIVE1"
+#define CFD_LIVE_VERSION        1
+#define CFD_LIVE_ALIGN          64      // 文件头与每个槽按缓存行对齐
+
+/*
+    共享内存对象（Linux 上为 /dev/shm/<name>）的布局，本机字节序：
+      CfdLiveHeader，补齐到 header_bytes 字节；随后是 slots 个槽，每个 slot_bytes 字节：
+      CfdLiveSlot，接着 rho[npoints]、vel[npoints]、pres[npoints]（f64）。
+    采样方式与快照文件相同，snap 中记录 NX、采样窗口与拉伸网格的参数（magic 为 "CFDSNAP1"）。
+
+    第 k 帧（从 0 起）写入槽 k % slots，用序号锁（seqlock）保护：
+      写者先把槽的 seq 置为 2k + 1（奇数表示正在写），写数据，再置为 2k + 2，最后把 published 置为 k + 1；
+      读者取 published 得到最新一帧 k = published - 1，读 seq，复制数据后再读一次 seq，
+      两次都等于 2k + 2 才说明复制到的是完整的第 k 帧，否则丢弃（下一次轮询再取）。
+    写者从不等待读者：读者慢于求解器时只会跳过帧。
+    写者每次打开时先删除同名对象再新建，已映射旧对象的读者可以通过 inode 变化发现新的运行。
+*/
+typedef struct {
+    char magic[8];                  // "CFDLIVE1"
+    u32  version;                   // CFD_LIVE_VERSION
+    u32  header_bytes;              // 第一个槽的偏移
+    u32  slots;                     // 槽数
+    u32  closed;                    // 写者结束后置 1
+    u64  slot_bytes;                // 每个槽的字节数（含 CfdLiveSlot）
+    u64  published;                 // 已发布的帧数
+    i64  pid;                       // 写者的进程号
+    CfdSnapshotHeader snap;         // 采样布局，与快照文件头相同
+} CfdLiveHeader;
+
+typedef struct {
+    u64  seq;                       // 序号锁：奇数为正在写，2k + 2 为第 k 帧已写完
+    u64  frame;                     // 帧号 k
+    i64  step;                      // 求解器步数
+    f64  time;                      // 模拟时间 (s)
+} CfdLiveSlot;
+
+typedef struct {
+    char name[CFD_PATH_MAX + 1];    // 共享内存对象名（以 / 开头，比配置项 live 多一个前缀字符）
+    u8 *base;                       // 映射起点
+    size_t bytes;                   // 映射长度
+    CfdLiveHeader *header;
+    const CfdOutput *out;           // 采样设置取自快照输出
+    i32 every;                      // 每隔多少步发布一次
+    i64 frames;                     // 已发布的帧数
+} CfdLive;
+
+/*
+    新建共享内存对象 cfg->live 并写入文件头，采样设置与 out 相同。
+    失败时给出警告并返回 NULL（不影响求解）
+*/
+CfdLive *   cfdLiveOpen         (const CfdConfig *cfg, const CfdSolver *s, const CfdOutput *out);
+
+/* 发布当前流场（先 cfdSolverSync）；只做一次抽取复制，不做系统调用，也不等待读者 */
+void        cfdLivePublish      (CfdLive *live, CfdSolver *s);
+
+/* 标记结束、解除映射并删除共享内存对象；已映射的读者仍可读到最后一帧 */
+void        cfdLiveClose        (CfdLive *live);
+
+#endif /* CFD_LIVE_H */
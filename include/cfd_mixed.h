@@ -0,0 +1,56 @@
+/*
+    include/cfd_mixed.h
+    混合精度模式：流场以 f32 存储、以 f64 计算，以及相对 f64 解的误差报告
+*/
+#ifndef CFD_MIXED_H
+#define CFD_MIXED_H
+
+#include <stdio.h>
+#include "constants.h"
+#include "cfd_util.h"
+
+/*
+    f32 只存相对初值的偏差：rho - RHO_INIT、vel、pres - P_INIT。
+    每步的增量约为 1e-8，远小于 rho ≈ 1.2、pres ≈ 1e5 处的 f32 精度，
+    直接存 rho/pres 时更新会被舍入吞掉；偏差量从 0 开始，相对精度高得多。
+    读入后全部转成 f64 参与求导与 Taylor 更新，只在写回时舍入。
+*/
+
+/* 分配 f32 存储（由 cfdSolverCreate 调用），返回 0 成功 */
+i32     cfdMixedAlloc       (CfdSolver *s);
+void    cfdMixedFree        (CfdSolver *s);
+void    cfdMixedInit        (CfdSolver *s);
+
+/* 推进一步（边界、内部点、压力、交换），不含时间与活塞加速度的推进 */
+void    cfdMixedStep        (CfdSolver *s);
+
+/* max |vel|，直接读 f32 存储 */
+f64     cfdMixedMaxSpeed    (const CfdSolver *s);
+
+/* 把 f32 存储展开到 vel/rho（存储压力时还有 pres）三个 f64 数组，由 cfdSolverSync 调用 */
+void    cfdMixedExpand      (CfdSolver *s);
+
+/* 与 shadow（f64 解）比较得到的误差，下标 0/1/2 对应 rho/vel/pres */
+typedef struct {
+    f64 abs_err[3];                 // 最大绝对误差
+    f64 rel_err[3];                 // 最大绝对误差 / f64 解偏离初值的最大幅度
+} CfdPrecisionError;
+
+/* 比较当前时刻的混合精度解与 shadow；没有 shadow 时返回 -1 */
+i32     cfdSolverPrecisionError(CfdSolver *s, CfdPrecisionError *err);
+
+/*
+    误差报告：每个快照时刻记录一行到 <dir>/precision.csv，
+    关闭时打印整个运行过程中的最大误差。
+*/
+typedef struct {
+    FILE *csv;
+    i64 samples;
+    CfdPrecisionError max;
+} CfdPrecisionReport;
+
+i32     cfdPrecisionReportOpen  (CfdPrecisionReport *rep, const char *dir);
+void    cfdPrecisionReportSample(CfdPrecisionReport *rep, CfdSolver *s);
+void    cfdPrecisionReportClose (CfdPrecisionReport *rep);
+
+#endif /* CFD_MIXED_H */
@@ -0,0 +1,65 @@
+/*
+    include/cfd_mpi.h
+    MPI 区域分解：把一维管道切成连续的段，每个进程推进一段，段间交换一层幽灵点
+*/
+#ifndef CFD_MPI_H
+#define CFD_MPI_H
+
+#include "constants.h"
+#include "cfd_config.h"
+#include "cfd_util.h"
+
+#ifdef CFD_MPI
+#include <mpi.h>
+#endif
+
+/*
+    融合核是三点模板（i-1, i, i+1），二阶导数也由这三个点给出，
+    每一步只需要相邻段最靠边的一个点，幽灵层宽度为 1。
+*/
+#define CFD_MPI_HALO        1
+
+/* 初始化 / 结束 MPI。未启用 USE_MPI 时为空操作，cfdMpiSize 返回 1 */
+void    cfdMpiInit      (i32 *argc, char ***argv);
+void    cfdMpiFinalize  (void);
+i32     cfdMpiRank      (void);
+i32     cfdMpiSize      (void);
+
+#ifdef CFD_MPI
+/*
+    一个进程上的子区域。进程 r 拥有全局网格 [g0, g1)，本地求解器在两侧各多存
+    一个幽灵点（第一个进程左侧与最后一个进程右侧除外，那里是物理边界）：
+        本地下标 j 对应全局下标 g0 - offset + j，offset = (r > 0)。
+    本地求解器的 rborderRho/rborderVel 与左壁面只在最后 / 第一个进程上调用。
+*/
+typedef struct {
+    MPI_Comm comm;
+    i32 rank, size;
+    i32 left, right;                // 相邻进程，物理边界一侧为 MPI_PROC_NULL
+    i32 nx;                         // 全局网格点数
+    i32 g0, g1;                     // 本进程拥有的全局下标 [g0, g1)
+    i32 offset;                     // g0 在本地数组中的下标（0 或 1）
+    CfdSolver *s;                   // 本地求解器，nx = g1 - g0 加幽灵点
+    MPI_Request req[4];
+    f64 send[4], recv[4];           // 左 / 右各一对 (rho, vel)
+} CfdMpiDomain;
+
+/* 按 cfg->nx 均分网格并创建本地求解器。只支持 f64 存储，失败返回 NULL */
+CfdMpiDomain *  cfdMpiDomainCreate  (const CfdConfig *cfg, MPI_Comm comm);
+void            cfdMpiDomainDestroy (CfdMpiDomain *d);
+
+/*
+    推进一步，结果与单进程的 cfdSolverStep 逐位相同：
+    先更新物理边界与紧邻幽灵层的两个点，发出非阻塞的幽灵层交换，
+    在等待期间更新其余内部点与压力，最后收下邻段的新值并交换缓冲区。
+*/
+void            cfdMpiDomainStep    (CfdMpiDomain *d);
+#endif /* CFD_MPI */
+
+/*
+    多进程运行一个算例：固定步长推进到 t_end，快照用 MPI-IO 集合写入同一个 snapshots.bin
+    （格式与单进程相同），性能汇总由 0 号进程写出。看门狗中止或未启用 USE_MPI 时返回 -1
+*/
+i32     cfdMpiRun       (const CfdConfig *cfg);
+
+#endif /* CFD_MPI_H */
@@ -0,0 +1,40 @@
+/*
+    include/cfd_offload.h
+    OpenMP target 卸载：流场整个运行期间常驻在加速器上，每步一次融合的核启动
+*/
+#ifndef CFD_OFFLOAD_H
+#define CFD_OFFLOAD_H
+
+#include "constants.h"
+#include "cfd_util.h"
+
+/*
+    把求解器的流场搬到默认设备上并设置 s->device。之后 cfdSolverStep 在设备上推进，
+    数据只在 cfdSolverSync（快照、检查点）与 cfdSolverFetchPoints（探针、进度显示）时传回。
+    只支持 f64 存储与等温状态方程，其余情况给出提示后留在主机上；未启用 USE_OFFLOAD 时什么也不做。
+    返回 0 表示成功（包括留在主机上）。
+*/
+i32     cfdOffloadAttach    (CfdSolver *s);
+
+/* 等待设备上排队的工作完成并释放设备上的数组（cfdSolverDestroy 调用） */
+void    cfdOffloadDetach    (CfdSolver *s);
+
+/*
+    在设备上推进一步：内部点、左右边界与（存储压力时的）压力在同一次核启动中完成，
+    然后交换缓冲区。核以 nowait 排队，主机不等待它完成。
+*/
+void    cfdOffloadStep      (CfdSolver *s);
+
+/*
+    把当前步的 rho/vel 与 pres（导出压力时为 rho_next）传回主机数组并等待完成。
+    主机数组与设备缓冲区一一对应、随步交替，传输不与后续的步重叠
+*/
+void    cfdOffloadDownload  (CfdSolver *s);
+
+/* 只传回 idx[0..n) 这些点，语义同 cfdOffloadDownload */
+void    cfdOffloadFetchPoints(const CfdSolver *s, const i32 *idx, i32 n);
+
+/* 设备上的 max|v| 归约（自适应步长） */
+f64     cfdOffloadMaxSpeed  (CfdSolver *s);
+
+#endif /* CFD_OFFLOAD_H */
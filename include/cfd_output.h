@@ -0,0 +1,162 @@
+/*
+    include/cfd_output.h
+    快照输出：追加写入的二进制容器（可直接 mmap / numpy.memmap），以及 CSV 导出
+*/
+#ifndef CFD_OUTPUT_H
+#define CFD_OUTPUT_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include "constants.h"
+#include "cfd_config.h"
+#include "cfd_util.h"
+
+#define CFD_OUTPUT_CSV      1           // 每个快照一个 CSV 文件
+#define CFD_OUTPUT_BINARY   2           // 所有快照追加到同一个二进制文件
+#define CFD_OUTPUT_COMPRESSED 4         // 所有快照压缩后追加到同一个文件（见下方的压缩格式）
+
+#define CFD_SNAPSHOT_MAGIC      "CFDSNAP1"
+#define CFD_SNAPSHOT_VERSION    4
+#define CFD_SNAPSHOT_FILE       "snapshots.bin"
+#define CFD_SNAPSHOT_Z_MAGIC    "CFDSNAPZ"
+#define CFD_SNAPSHOT_Z_FILE     "snapshots.cfz"
+#define CFD_SNAPSHOT_KEYFRAME   64      // 压缩快照每隔多少帧写一个关键帧（不依赖上一帧）
+
+#define CFD_SAMPLE_POINT        0       // 每 stride 个点取一个
+#define CFD_SAMPLE_MINMAX       1       // 每 stride 个点保留最小值与最大值（保留激波前沿）
+
+/*
+    二进制快照文件格式（本机字节序，x86/ARM 上为小端）：
+      文件头（CfdSnapshotHeader，header_bytes 字节），随后是若干定长帧；
+      每帧为 f64 time，接着 rho[npoints]、vel[npoints]、pres[npoints]。
+    sampling 为 CFD_SAMPLE_POINT 时，第 k 个采样点对应网格下标 idx_start + k * idx_stride；
+    为 CFD_SAMPLE_MINMAX 时，每 idx_stride 个点构成一个桶，每个桶按出现顺序存两个值
+    （最小值与最大值），第 k 个值记在桶 k/2 的起点（k 为偶数）或终点（k 为奇数）上，
+    最后一个桶的终点不超过 idx_end - 1。
+    网格下标 i 的坐标为 i * dx；grid_stretch > 0 时为 grid_length * cfdGridMap(i / (nx - 1), grid_stretch)。
+    帧数 = (文件大小 - header_bytes) / 帧大小，写到一半的尾帧会被读者忽略。
+*/
+typedef struct {
+    char magic[8];                  // "CFDSNAP1"
+    u32  version;                   // CFD_SNAPSHOT_VERSION
+    u32  header_bytes;              // 文件头字节数（= sizeof(CfdSnapshotHeader)）
+    i64  nx;                        // 网格点数
+    i64  npoints;                   // 每帧每个物理量的采样点数
+    i64  idx_start;                 // 第一个采样点的网格下标
+    i64  idx_stride;                // 采样点之间的网格下标间隔
+    f64  dx;                        // 空间步长 (m)，拉伸网格时为最小间距
+    f64  dt;                        // 时间步长 (s)，自适应步长时为初始步长
+    u32  sampling;                  // CFD_SAMPLE_*（版本 2 起）
+    u32  reserved;
+    f64  grid_stretch;              // 拉伸网格的系数 β，0 为均匀网格（版本 3 起，见 cfd_grid.h）
+    f64  grid_length;               // 拉伸网格的管长 (m)，均匀网格时为 0
+    i64  idx_end;                   // 采样窗口的结束下标（不含，版本 4 起；此前为 nx）
+} CfdSnapshotHeader;
+
+/*
+    压缩快照文件（snapshots.cfz）：文件头与 CfdSnapshotHeader 相同（magic 为 "CFDSNAPZ"），
+    随后是若干变长帧：CfdZFrameHeader，接着 rho/vel/pres 三个字段各一个 CfdZFieldHeader
+    与 bytes 字节的编码数据（见 cfd_codec.h）。predictor 为 CFD_CODEC_TEMPORAL 的字段
+    要用上一帧同一字段的键解码，因此必须从关键帧起顺序读取；每 CFD_SNAPSHOT_KEYFRAME 帧、
+    续算后的第一帧以及量化步长改变的字段都按空间预测编码。
+    有损压缩时速度的误差不超过 output_error，密度与压力按声学关系 ρ' = ρ0 v' / c、
+    p' = ρ0 c v' 换算为 output_error * ρ0 / c 与 output_error * ρ0 c（c = sqrt(K)）。
+    写到一半的尾帧（frame_bytes 超出文件末尾）会被读者忽略。
+*/
+typedef struct {
+    u64  frame_bytes;               // 整帧字节数（含本帧头）
+    f64  time;
+} CfdZFrameHeader;
+
+typedef struct {
+    f64  quantum;                   // 量化步长，0 为无损
+    u32  predictor;                 // CFD_CODEC_SPATIAL / CFD_CODEC_TEMPORAL
+    u32  reserved;
+    u64  bytes;                     // 编码数据的字节数
+} CfdZFieldHeader;
+
+/* 一帧快照数据（已采样）；异步模式下指向写线程缓冲池中的存储 */
+typedef struct {
+    f64 t;
+    i32 npoints;
+    f64 *rho;
+    f64 *vel;
+    f64 *pres;
+} CfdFrame;
+
+typedef struct {
+    i32 format;                     // CFD_OUTPUT_* 的组合
+    FILE *bin;                      // 二进制快照文件
+    FILE *zbin;                     // 压缩快照文件
+    i64 frames;                     // 已写出的帧数
+    char dir[CFD_PATH_MAX];         // 输出目录
+
+    /* 采样：网格窗口 [window_start, window_end)，空间步长 stride，时间上每 every 个快照写一次 */
+    i32 sampling;                   // CFD_SAMPLE_*
+    i32 window_start;
+    i32 window_end;
+    i32 stride;
+    i32 npoints;                    // 每帧每个物理量的采样点数
+    i32 every;
+    i64 calls;                      // cfdOutputWrite 被调用的次数
+    CfdFrame scratch;               // 同步模式下的采样缓冲（不需要采样时不分配）
+
+    /* 压缩输出的状态，只由写出帧的线程访问 */
+    f64 zquantum[3];                // 各字段请求的量化步长，0 为无损
+    f64 zlast[3];                   // 上一帧各字段实际使用的量化步长，-1 表示没有可用的上一帧
+    u64 *zkey[3];                   // 上一帧各字段的键
+    u64 *zcur;                      // 当前字段的键
+    u64 *zres;                      // 编码的工作区
+    u8 *zbuf;                       // 一帧的编码结果
+    i64 zbytes;                     // 本次运行写出的压缩帧字节数
+    i64 zraw;                       // 这些帧不压缩时的字节数
+
+    /*
+        异步写出：求解线程把流场复制进池中的空闲帧后立即返回，
+        由后台线程完成编码与文件 I/O。队列满时求解线程等待（背压）。
+    */
+    i32 async;                      // 是否启用后台写线程
+    pthread_t thread;               // 后台写线程
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;       // 队列中有待写帧
+    pthread_cond_t not_full;        // 队列中有空闲帧
+    CfdFrame *slots;                // 环形队列，容量为 capacity
+    f64 *storage;                   // 所有帧共用的一块存储
+    i32 capacity;
+    i32 head;                       // 最早的待写帧
+    i32 count;                      // 待写帧数
+    i32 stop;                       // 关闭标志
+    i64 stalls;                     // 求解线程因队列满而等待的次数
+} CfdOutput;
+
+/* 打开输出；二进制文件写入文件头，异步模式下启动写线程。失败返回 NULL */
+CfdOutput * cfdOutputOpen       (const CfdConfig *cfg, const CfdSolver *s);
+
+/*
+    从检查点恢复时打开输出：已有的二进制文件保留前 frames 帧并在其后续写，
+    calls 为检查点时 cfdOutputWrite 的调用次数（用于 every 抽取）。失败返回 NULL
+*/
+CfdOutput * cfdOutputResume     (const CfdConfig *cfg, const CfdSolver *s, i64 frames, i64 calls);
+
+/* 等待已提交的帧全部写入文件，返回已写出的帧数 */
+i64         cfdOutputFlush      (CfdOutput *out);
+
+/* 写出当前时刻的流场（按采样设置抽取；异步模式下只做一次复制） */
+void        cfdOutputWrite      (CfdOutput *out, const CfdSolver *s);
+
+/* 等待队列中的帧全部写完，关闭文件并释放资源 */
+void        cfdOutputClose      (CfdOutput *out);
+
+/* 按采样设置填写快照文件头（magic 为 CFD_SNAPSHOT_MAGIC） */
+void        cfdOutputHeader     (const CfdOutput *out, const CfdSolver *s, CfdSnapshotHeader *hdr);
+
+/* 按采样设置把当前流场抽取到 frame（npoints 个点，流场须已 cfdSolverSync） */
+void        cfdOutputSample     (const CfdOutput *out, const CfdSolver *s, CfdFrame *frame);
+
+/* 第 k 个采样点对应的网格下标 */
+i32         cfdOutputSampleIndex(const CfdOutput *out, i32 k);
+
+/* 单独写出一个 CSV 快照（CSV 导出模式使用） */
+void        cfdWriteSnapshotCsv (const CfdOutput *out, const CfdFrame *frame);
+
+#endif /* CFD_OUTPUT_H */
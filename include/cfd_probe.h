@@ -0,0 +1,67 @@
+/*
+    include/cfd_probe.h
+    探针时间序列：每隔若干步在指定网格点上采样，连同活塞运动量流式写入一个紧凑的二进制文件
+*/
+#ifndef CFD_PROBE_H
+#define CFD_PROBE_H
+
+#include <stdio.h>
+#include "constants.h"
+#include "cfd_config.h"
+#include "cfd_util.h"
+
+#define CFD_PROBE_MAGIC     "CFDPROB1"
+#define CFD_PROBE_VERSION   2
+#define CFD_PROBE_FILE      "probes.bin"
+
+/*
+    探针文件格式（本机字节序，x86/ARM 上为小端）：
+      文件头（CfdProbeHeader），随后是 i64 idx[nprobes]（探针的网格下标），共 header_bytes 字节；
+      之后是若干定长记录，每条记录全部为 f64：
+        time, piston_acc, piston_vel, piston_disp,
+        然后每个探针依次为 rho, vel, pres。
+    活塞速度与位移由加速度曲线解析积分得到（见 pistonAccelKinematics），t = 0 时为 0。
+    探针坐标的换算与快照文件相同（见 cfd_output.h）。
+    记录数 = (文件大小 - header_bytes) / 记录大小，写到一半的尾记录会被读者忽略。
+*/
+typedef struct {
+    char magic[8];                  // "CFDPROB1"
+    u32  version;                   // CFD_PROBE_VERSION
+    u32  header_bytes;              // 文件头加下标表的字节数
+    i64  nx;                        // 网格点数
+    i64  nprobes;                   // 探针个数
+    i64  every;                     // 采样间隔（步）
+    f64  dx;                        // 空间步长 (m)，拉伸网格时为最小间距
+    f64  dt;                        // 时间步长 (s)，自适应步长时为初始步长
+    f64  grid_stretch;              // 拉伸网格的系数 β，0 为均匀网格（版本 2 起）
+    f64  grid_length;               // 拉伸网格的管长 (m)，均匀网格时为 0
+} CfdProbeHeader;
+
+#define CFD_PROBE_RECORD_MAX (4 + 3 * CFD_PROBE_MAX)
+
+typedef struct {
+    FILE *fp;
+    i32 nprobes;
+    i32 idx[CFD_PROBE_MAX];         // 已换算为非负的网格下标
+    i32 every;
+    i64 samples;                    // 已写出的记录数
+    f64 record[CFD_PROBE_RECORD_MAX];
+} CfdProbes;
+
+/*
+    打开 <output_dir>/probes.bin。resume_samples >= 0 时续写检查点时已有的文件：
+    核对文件头，保留前 resume_samples 条记录并在其后接着写。失败返回 NULL
+*/
+CfdProbes * cfdProbesOpen   (const CfdConfig *cfg, const CfdSolver *s, i64 resume_samples);
+
+/*
+    记录当前时刻的一条采样。只读取探针所在的点（见 cfdSolverPoint），
+    不需要先调用 cfdSolverSync；流场在设备上时只传回这几个点。
+*/
+void        cfdProbesSample (CfdProbes *pr, const CfdSolver *s);
+
+/* 把缓冲的记录写入文件，返回已写出的记录数（写检查点前调用） */
+i64         cfdProbesFlush  (CfdProbes *pr);
+void        cfdProbesClose  (CfdProbes *pr);
+
+#endif /* CFD_PROBE_H */
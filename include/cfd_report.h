@@ -0,0 +1,77 @@
+/*
+    include/cfd_report.h
+    运行过程报告：墙钟计时、终端进度显示与分阶段性能统计
+*/
+#ifndef CFD_REPORT_H
+#define CFD_REPORT_H
+
+#include "constants.h"
+
+/* 单调墙钟时间 (s)。clock() 统计的是所有线程的 CPU 时间，OpenMP 下不能用来估计剩余时间 */
+f64     cfdWallTime         (void);
+
+/*
+    进度显示。stdout 是终端时用 ANSI 转义原地刷新同一行，
+    否则（重定向到文件、批处理作业）每次输出一行普通日志；quiet 时不输出。
+*/
+typedef struct {
+    i32 quiet;                      // 不输出进度
+    i32 tty;                        // stdout 是否为终端
+    i32 pending;                    // 终端上是否有一行尚未换行的进度
+    f64 start;                      // 开始时刻（墙钟）
+    i64 first_step;                 // 开始时的步数，续算时不为 0
+    f64 first_progress;             // 开始时的完成比例
+} CfdProgress;
+
+/* 开始计时；first_step、first_progress 为本次运行开始时的步数与完成比例，速度与 ETA 只按之后推进的部分估计 */
+void    cfdProgressBegin    (CfdProgress *p, i32 quiet, i64 first_step, f64 first_progress);
+
+/*
+    输出一次进度。progress 为 [0, 1] 的完成比例，total 为总步数（未知时传 0），
+    line 为附加信息（可为 NULL）。
+*/
+void    cfdProgressUpdate   (CfdProgress *p, f64 t, i64 step, i64 total, f64 progress, const char *line);
+
+/* 结束进度显示：终端上补一个换行，并打印总耗时 */
+void    cfdProgressEnd      (CfdProgress *p, i64 steps);
+
+/*
+    分阶段计时。每个阶段累计墙钟时间、调用次数与按最少访存量估计的读写字节数
+    （每个数组每步读或写一遍），由此得到有效带宽。
+*/
+#define CFD_PHASE_FUSED     0       // 融合核（rho/vel 内部点）
+#define CFD_PHASE_VELOCITY  1       // 参考核 updateVelocity
+#define CFD_PHASE_RHO       2       // 参考核 updateRho
+#define CFD_PHASE_BORDER    3       // 边界 rborderRho/rborderVel
+#define CFD_PHASE_PRESSURE  4       // updatePressure
+#define CFD_PHASE_SWAP      5       // 交换缓冲区
+#define CFD_PHASE_PISTON    6       // 活塞加速度推进
+#define CFD_PHASE_CFL       7       // 自适应步长的波速估计
+#define CFD_PHASE_OUTPUT    8       // 快照输出（异步模式下只含复制）
+#define CFD_PHASE_REGION    9       // 常驻并行区内推进的全部步骤（核、压力、边界与交换）
+#define CFD_PHASE_SHADOW    10      // 精度检查的 f64 影子求解器（见 cfd_mixed.h）
+#define CFD_PHASE_CHECKPOINT 11     // 检查点（清空快照队列与状态复制，写盘在后台）
+#define CFD_PHASE_PROBE     12      // 探针采样（见 cfd_probe.h）
+#define CFD_PHASE_HALO      13      // MPI 幽灵层交换中未被计算掩盖的等待（见 cfd_mpi.h）
+#define CFD_PHASE_TEMPORAL  14      // 时间分块推进的全部 tile（见 cfd_temporal.h）
+#define CFD_PHASE_STAGES    15      // 多级时间格式的各级遍历（见 cfd_stepper.h）
+#define CFD_PHASE_COUNT     16
+
+typedef struct {
+    f64 seconds[CFD_PHASE_COUNT];
+    i64 calls[CFD_PHASE_COUNT];
+    f64 bytes[CFD_PHASE_COUNT];
+} CfdTimers;
+
+void    cfdTimersReset      (CfdTimers *tm);
+
+/* 把 [t0, 现在) 计入 phase，返回当前时刻，便于连续计时 */
+f64     cfdTimersAdd        (CfdTimers *tm, i32 phase, f64 t0, f64 bytes);
+
+/*
+    运行结束时的性能汇总：打印各阶段耗时，并把同样的数据写成 JSON（path 为 NULL 或空串时不写）。
+    wall 为整个时间推进循环的墙钟时间。
+*/
+i32     cfdReportSummary    (const CfdTimers *tm, i32 nx, i64 steps, f64 wall, const char *path);
+
+#endif /* CFD_REPORT_H */
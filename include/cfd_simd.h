@@ -0,0 +1,42 @@
+/*
+    include/cfd_simd.h
+    向量化的内部点模板核：按运行时检测到的 CPU 指令集选择实现，标量核作为回退
+*/
+#ifndef CFD_SIMD_H
+#define CFD_SIMD_H
+
+#include "constants.h"
+#include "cfd_util.h"
+
+#define CFD_SIMD_AUTO       -1      // 选择当前 CPU 支持的最快实现
+#define CFD_SIMD_SCALAR     0       // 逐点标量循环（融合核的原始实现）
+#define CFD_SIMD_GENERIC    1       // omp simd，编译目标的基线指令集（x86-64 为 SSE2，AArch64 为 NEON）
+#define CFD_SIMD_AVX2       2       // omp simd，AVX2（x86）
+#define CFD_SIMD_AVX512     3       // omp simd，AVX-512F（x86）
+
+#define CFD_SIMD_BLOCK      1024    // SIMD 核在 OpenMP 线程间分配的块大小（网格点数）
+
+/* 按指令集分别编译同一段循环（GCC/Clang，x86），其他平台只有 GENERIC 与标量实现 */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CFD_SIMD_X86 1
+#define CFD_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/* 解析配置中的名字（auto/scalar/generic/avx2/avx512），无法识别时返回 -2 */
+i32         cfdSimdParse    (const char *name);
+const char *cfdSimdName     (i32 level);
+
+/* 把请求的实现换成当前 CPU 可以运行的实现：AUTO 取最快的一个，不支持的请求降级并给出警告 */
+i32         cfdSimdResolve  (i32 requested);
+
+/*
+    用 level 对应的实现更新内部点 [lo, hi)（1 <= lo, hi <= nx - 1），写出 rho_next 与 vel_next。
+    不做 FMA 收缩与重结合，各实现的结果与标量核逐位相同。
+    w 不为 NULL 时把新值的看门狗归约合并进 *w（流场的结果不变）。
+*/
+void        cfdSimdInterior (i32 level, CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w);
+
+/* 混合精度存储的内部点核：读 drho/vel32，写 drho_next/vel32_next（见 cfdSolverSync） */
+void        cfdSimdInteriorMixed(i32 level, CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w);
+
+#endif /* CFD_SIMD_H */
@@ -0,0 +1,174 @@
+/*
+    include/cfd_stencil.h
+    融合模板核的逐点计算（f64 与混合精度两种存储），供标量核（cfd_util.c）与 SIMD 核（cfd_simd.c）共用
+*/
+#ifndef CFD_STENCIL_H
+#define CFD_STENCIL_H
+
+#include <math.h>
+#include "constants.h"
+
+/* 强制内联：SIMD 核要求循环体完全展开在带 target 属性的函数内 */
+#if defined(__GNUC__) || defined(__clang__)
+#define CFD_ALWAYS_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define CFD_ALWAYS_INLINE __forceinline
+#else
+#define CFD_ALWAYS_INLINE inline
+#endif
+
+/*
+    由中心点的 rho/vel 及其一阶、二阶空间导数求出一阶、二阶时间导数。
+    展开式与 cfd_differentials.c 中的 pprho_ppt/ppvx_ppt 相同；只用到空间导数的值，
+    均匀网格与拉伸网格（见 cfd_grid.h）共用这一段。
+*/
+static CFD_ALWAYS_INLINE void fusedTimeDerivs(f64 r_c, f64 v_c, f64 rx, f64 vx, f64 rxx, f64 vxx, f64 acc,
+                                              f64 *rho_t_out, f64 *rho_tt_out, f64 *vel_t_out, f64 *vel_tt_out)
+{
+    const f64 k_r = K / r_c;
+    const f64 rx_r = rx / r_c;
+
+    /* 一阶时间导数 */
+    const f64 rho_t = -v_c * rx - r_c * vx;
+    const f64 vel_t = -v_c * vx - k_r * rx - acc;
+
+    /* 公共子式：A = ∂x(∂v/∂t)（不含 a），B = ∂x(∂ρ/∂t) */
+    const f64 A = -vx * vx - v_c * vxx + K * rx_r * rx_r - k_r * rxx;
+    const f64 B = -2 * vx * rx - v_c * rxx - r_c * vxx;
+
+    /* 二阶时间导数 */
+    *rho_tt_out = -vel_t * rx - v_c * B - rho_t * vx - r_c * A;
+    *vel_tt_out = -vel_t * vx - v_c * A + k_r * rx_r * rho_t - k_r * B;
+    *rho_t_out = rho_t;
+    *vel_t_out = vel_t;
+}
+
+/* 融合核的三点模板：由 (l, c, r) 三个点的 rho/vel 求出中心点的一阶、二阶时间导数（均匀网格） */
+static CFD_ALWAYS_INLINE void fusedDerivs(f64 r_l, f64 r_c, f64 r_r, f64 v_l, f64 v_c, f64 v_r,
+                                          f64 inv_2dx, f64 inv_dx2, f64 acc,
+                                          f64 *rho_t_out, f64 *rho_tt_out, f64 *vel_t_out, f64 *vel_tt_out)
+{
+    const f64 rx  = (r_r - r_l) * inv_2dx;
+    const f64 vx  = (v_r - v_l) * inv_2dx;
+    const f64 rxx = (r_r - 2 * r_c + r_l) * inv_dx2;
+    const f64 vxx = (v_r - 2 * v_c + v_l) * inv_dx2;
+    fusedTimeDerivs(r_c, v_c, rx, vx, rxx, vxx, acc, rho_t_out, rho_tt_out, vel_t_out, vel_tt_out);
+}
+
+/*
+    只求一阶时间导数（多级时间格式的右端项，见 cfd_stepper.h），表达式与 prho_pt/pvx_pt 相同。
+    rx = (r_r - r_l) * inv_span：中心差分时 (l, r) = (i-1, i+1)、inv_span = 1/(2dx)，
+    单边差分时 l 或 r 取中心点本身、inv_span = 1/dx。
+*/
+static CFD_ALWAYS_INLINE void firstDerivs(f64 r_l, f64 r_c, f64 r_r, f64 v_l, f64 v_c, f64 v_r,
+                                          f64 inv_span, f64 acc, f64 *rho_t_out, f64 *vel_t_out)
+{
+    const f64 rx = (r_r - r_l) * inv_span;
+    const f64 vx = (v_r - v_l) * inv_span;
+    *rho_t_out = -v_c * rx - r_c * vx;
+    *vel_t_out = -v_c * vx - K / r_c * rx - acc;
+}
+
+/*
+    融合核在一个内部点 i 上的计算：读取 rho/vel 的三点模板，
+    写出 new_rho[i] 与 new_vel[i]。标量核、SIMD 核与常驻并行区共用这一段。
+*/
+static CFD_ALWAYS_INLINE void fusedPoint(const f64 *restrict rho, const f64 *restrict vel,
+                                         f64 *restrict new_rho, f64 *restrict new_vel,
+                                         f64 dt, f64 half_dt2, f64 inv_2dx, f64 inv_dx2, f64 acc, i32 i)
+{
+    const f64 r_c = rho[i], v_c = vel[i];
+    f64 rho_t, rho_tt, vel_t, vel_tt;
+    fusedDerivs(rho[i - 1], r_c, rho[i + 1], vel[i - 1], v_c, vel[i + 1], inv_2dx, inv_dx2, acc,
+                &rho_t, &rho_tt, &vel_t, &vel_tt);
+    new_rho[i] = r_c + dt * rho_t + half_dt2 * rho_tt;
+    new_vel[i] = v_c + dt * vel_t + half_dt2 * vel_tt;
+}
+
+/*
+    看门狗的逐点归约（见 cfd_util.h 的 CfdWatchSums），写在融合核的同一个循环里，读的是刚写出的新值。
+    写成按值传递的纯函数：归约变量不能取地址，omp simd 才能把 max/min/+ 归约放进向量寄存器。
+*/
+static CFD_ALWAYS_INLINE f64 watchMax(f64 vmax, f64 v)
+{
+    const f64 a = fabs(v);
+    return a > vmax ? a : vmax;
+}
+
+static CFD_ALWAYS_INLINE f64 watchMin(f64 rmin, f64 r)
+{
+    return r < rmin ? r : rmin;
+}
+
+static CFD_ALWAYS_INLINE f64 watchBad(f64 bad, f64 r, f64 v)
+{
+    return bad + r + v;
+}
+
+/* 单个点（边界、活动区的代表值、标量循环）的归约，累加到 *vmax、*rmin、*bad */
+static CFD_ALWAYS_INLINE void watchPoint(f64 r, f64 v, f64 *vmax, f64 *rmin, f64 *bad)
+{
+    *vmax = watchMax(*vmax, v);
+    *rmin = watchMin(*rmin, r);
+    *bad = watchBad(*bad, r, v);
+}
+
+/*
+    拉伸网格上的融合核：空间导数的系数逐点取自 d1/d1s/d2/d2s（见 cfd_grid.h），其余与 fusedPoint 相同
+*/
+static CFD_ALWAYS_INLINE void fusedPointStretched(const f64 *restrict rho, const f64 *restrict vel,
+                                                  f64 *restrict new_rho, f64 *restrict new_vel,
+                                                  const f64 *restrict d1, const f64 *restrict d1s,
+                                                  const f64 *restrict d2, const f64 *restrict d2s,
+                                                  f64 dt, f64 half_dt2, f64 acc, i32 i)
+{
+    const f64 r_c = rho[i], v_c = vel[i];
+    const f64 dr = rho[i + 1] - rho[i - 1], dv = vel[i + 1] - vel[i - 1];
+    const f64 sr = rho[i + 1] - 2 * r_c + rho[i - 1], sv = vel[i + 1] - 2 * v_c + vel[i - 1];
+    f64 rho_t, rho_tt, vel_t, vel_tt;
+    fusedTimeDerivs(r_c, v_c, dr * d1[i] + sr * d1s[i], dv * d1[i] + sv * d1s[i],
+                    sr * d2[i] + dr * d2s[i], sv * d2[i] + dv * d2s[i], acc, &rho_t, &rho_tt, &vel_t, &vel_tt);
+    new_rho[i] = r_c + dt * rho_t + half_dt2 * rho_tt;
+    new_vel[i] = v_c + dt * vel_t + half_dt2 * vel_tt;
+}
+
+/*
+    混合精度版本：drho 存 rho - RHO_INIT，vel 直接存速度，均为 f32；
+    读入后转成 f64 求导与做 Taylor 更新，只在写回时舍入到 f32。
+    存偏差量而不是 rho 本身，是因为每步的增量（约 1e-8）远小于 rho ≈ 1.2 处的 f32 精度。
+*/
+static CFD_ALWAYS_INLINE void fusedPointMixed(const f32 *restrict drho, const f32 *restrict vel,
+                                              f32 *restrict new_drho, f32 *restrict new_vel,
+                                              f64 dt, f64 half_dt2, f64 inv_2dx, f64 inv_dx2, f64 acc, i32 i)
+{
+    const f64 d_c = (f64)drho[i], v_c = (f64)vel[i];
+    f64 rho_t, rho_tt, vel_t, vel_tt;
+    fusedDerivs(RHO_INIT + (f64)drho[i - 1], RHO_INIT + d_c, RHO_INIT + (f64)drho[i + 1],
+                (f64)vel[i - 1], v_c, (f64)vel[i + 1], inv_2dx, inv_dx2, acc,
+                &rho_t, &rho_tt, &vel_t, &vel_tt);
+    new_drho[i] = (f32)(d_c + dt * rho_t + half_dt2 * rho_tt);
+    new_vel[i] = (f32)(v_c + dt * vel_t + half_dt2 * vel_tt);
+}
+
+/*
+    边界点的一阶显式更新（由 rborderRho/rborderVel 与混合精度路径共用）。
+    下标 m 为右边界的左邻点，c 为右边界点；p_diff = pres[c] - pres[m]。
+*/
+static CFD_ALWAYS_INLINE f64 borderRhoRight(f64 r_m, f64 r_c, f64 v_m, f64 v_c, f64 dx, f64 dt)
+{
+    return (-r_c * (v_c - v_m) / dx - v_c * (r_c - r_m) / dx) * dt + r_c;
+}
+
+static CFD_ALWAYS_INLINE f64 borderVelRight(f64 r_c, f64 v_m, f64 v_c, f64 p_diff, f64 dx, f64 dt, f64 acc)
+{
+    f64 fx = -r_c * acc;
+    return ((fx - (p_diff / dx)) / r_c - v_c * (v_c - v_m) / dx) * dt + v_c;
+}
+
+/* 左边界：用连续性方程更新，避免与内部离散不一致（活塞处 v = 0） */
+static CFD_ALWAYS_INLINE f64 borderRhoLeft(f64 r_0, f64 v_0, f64 v_1, f64 dx, f64 dt)
+{
+    return r_0 - r_0 * dt * ((v_1 - v_0) / dx);
+}
+
+#endif /* CFD_STENCIL_H */
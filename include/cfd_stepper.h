@@ -0,0 +1,46 @@
+/*
+    include/cfd_stepper.h
+    可替换的时间推进格式：默认的二阶 Taylor 展开，以及只用一阶时间导数的多级格式
+*/
+#ifndef CFD_STEPPER_H
+#define CFD_STEPPER_H
+
+#include "constants.h"
+#include "cfd_util.h"
+
+#define CFD_STEPPER_TAYLOR      0   // 二阶 Taylor 展开（融合核），CFL <= 1
+#define CFD_STEPPER_SSPRK3      1   // 三阶强稳定保持 Runge-Kutta（Shu-Osher），中心差分下 CFL 约 1.7
+#define CFD_STEPPER_RK4         2   // 经典四阶 Runge-Kutta，中心差分下 CFL 约 2.8
+#define CFD_STEPPER_MACCORMACK  3   // MacCormack 预测-校正（前向/后向差分交替），CFL <= 1
+
+/*
+    Runge-Kutta 格式的右端项 L(u) 是 prho_pt/pvx_pt 给出的一阶时间导数：内部点中心差分，
+    两端单边差分，活塞壁面 ∂v/∂t = 0，各级之间不需要二阶导数，活塞加速度按各级的时刻精确求值。
+    右端开口处没有显式的边界条件，不带耗散的中心差分半离散系统在这里有一个缓慢增长的模态
+    （Taylor 格式的 dt^2/2 项与 MacCormack 的交替差分都隐含了抑制它的耗散），
+    因此内部点再加一项四阶人工耗散 -ε (|v| + c) / dx · δ⁴u，对光滑解是 O(dx^3) 的修正。
+    输出约定与 Taylor 相同：一步结束时 pres 为步初的密度经状态方程得到的压力。
+*/
+#define CFD_STEPPER_DISSIPATION (1.0 / 64)  // Runge-Kutta 格式四阶耗散的系数 ε
+
+/* 解析配置中的名字（taylor/ssprk3/rk4/maccormack），无法识别时返回 -1 */
+i32         cfdStepperParse (const char *name);
+const char *cfdStepperName  (i32 stepper);
+
+/* 格式在本模板下的线性稳定 CFL 上限（自适应步长时用于提示） */
+f64         cfdStepperCflLimit(i32 stepper);
+
+/* 格式需要的阶段缓冲对数（每对为一个 rho 与一个 vel 数组） */
+i32         cfdStepperStages(i32 stepper);
+
+/* 按 s->stepper 分配阶段缓冲 s->stage_rho/stage_vel；失败返回 -1 */
+i32         cfdStepperAlloc (CfdSolver *s);
+void        cfdStepperFree  (CfdSolver *s);
+
+/*
+    用 s->stepper 对应的多级格式把 rho/vel 推进一步，结果（含两端边界）写入 rho_next/vel_next。
+    不更新压力、不交换缓冲区，也不推进时间（由 cfdSolverStep 完成）
+*/
+void        cfdStepperStep  (CfdSolver *s);
+
+#endif /* CFD_STEPPER_H */
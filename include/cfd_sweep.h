@@ -0,0 +1,41 @@
+/*
+    include/cfd_sweep.h
+    参数扫描：读取作业列表，用工作窃取调度在一个进程内运行全部算例，并汇总每个算例的耗时与稳定性
+*/
+#ifndef CFD_SWEEP_H
+#define CFD_SWEEP_H
+
+#include "constants.h"
+#include "cfd_config.h"
+#include "cfd_ensemble.h"
+
+#define CFD_RUN_OK          0       // 运行到 t_end
+#define CFD_RUN_FAILED      1       // 参数或资源错误，未能完成
+#define CFD_RUN_UNSTABLE    2       // 看门狗发现非有限值、非正密度或 CFL 超限，已提前中止
+
+typedef struct {
+    i32 status;                     // CFD_RUN_*
+    i64 steps;                      // 实际推进的步数
+    f64 t;                          // 结束时的模拟时间 (s)
+} CfdRunResult;
+
+/* 运行一个算例（由 main.c 提供）；profile 为 NULL 时用题设的活塞曲线。成功返回 0 */
+typedef i32 (*CfdRunFn)(const CfdConfig *cfg, const PistonProfile *profile, CfdRunResult *result);
+
+/*
+    作业列表的格式与配置文件相同（每行 "key = value"，# 为注释），[job] 开始一个新作业，
+    继承第一个 [job] 之前的公共设置。可用的键为全部运行参数，加上活塞曲线的
+    name、period、dc、amplitude、harmonics、harmonic（含义见 cfd_ensemble.h）。
+    "vary key = v1, v2, ..." 列出一个参数的多个取值，作业按所有 vary 的笛卡尔积展开
+    （公共部分的 vary 对每个作业都生效，除非该作业显式设置了同一个键），展开后的作业名为 <name>_000、<name>_001……
+    未命名的作业依次为 job_000、job_001……
+
+    调度：nx >= sweep_split_nx 的大算例一个接一个运行，每个都用全部线程；
+    其余的小算例各用一个线程，按估计的计算量（nx * 步数）从大到小分给各线程的双端队列，
+    线程从自己队列的头部取作业，空了就从剩余计算量最多的队列尾部窃取。
+    提前中止的算例空出的线程由此立即去做别的作业。
+    每个作业的输出写到 <output_dir>/<name>/，汇总表同时写入 <output_dir>/sweep_summary.csv。
+*/
+i32     cfdSweepRun         (const CfdConfig *cfg, CfdRunFn run);
+
+#endif /* CFD_SWEEP_H */
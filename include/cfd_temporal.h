@@ -0,0 +1,44 @@
+/*
+    include/cfd_temporal.h
+    时间分块：把网格切成放得进 L2 的 tile，每个 tile 载入一次连续推进多步再写回
+*/
+#ifndef CFD_TEMPORAL_H
+#define CFD_TEMPORAL_H
+
+#include "constants.h"
+#include "cfd_util.h"
+
+#define CFD_TEMPORAL_L2_DEFAULT (1 << 20)   // 查不到 L2 容量时假定的每核 L2 字节数
+#define CFD_TEMPORAL_ARRAYS     5           // 每个 tile 的私有缓冲：三层密度（上一步、当前、下一步）与两层速度
+
+/*
+    重叠 tile（ghost zone）方式的时间分块。每个 tile 拥有网格 [a, b)，推进 depth 步时
+    两侧各多载入 depth 个点：模板半径为 1，每推进一步有效区向内收缩一个点，depth 步后
+    恰好剩下 [a, b)。相邻 tile 的重叠部分重复计算，但 tile 之间不需要同步，
+    所有 tile 读同一份当前场、写同一份 *_next，一个 depth 的分块只有一次往返主存。
+    靠近两端的 tile 每步就地更新活塞壁面与右边界，与逐步推进的计算顺序相同，结果逐位相同。
+*/
+typedef struct {
+    i32 depth;                      // 每次载入推进的最大步数
+    i32 tile;                       // 每个 tile 拥有的点数
+    i32 threads;                    // 私有缓冲的份数
+    i32 width;                      // 私有缓冲每层的点数 tile + 2 * depth
+    f64 *scratch;                   // threads * CFD_TEMPORAL_ARRAYS * width
+    f64 *acc;                       // 分块内每一步的活塞加速度，depth 个
+    f64 *rho_lag;                   // 导出压力时分块结束后 rho_next 应有的上一步密度（nx 个），否则为 NULL
+} CfdTemporal;
+
+/*
+    为 s 创建时间分块的工作区。tile <= 0 时按每核 L2 容量自动选取，
+    使一个 tile 的全部私有缓冲占 L2 的一半。只支持主机上的 f64 存储，失败返回 NULL
+*/
+CfdTemporal *   cfdTemporalCreate   (const CfdSolver *s, i32 depth, i32 tile);
+void            cfdTemporalDestroy  (CfdTemporal *tb);
+
+/*
+    与 cfdSolverAdvance 的约定相同：至多推进 nsteps 步，某一步结束时 t > t_stop 则停下，
+    返回实际推进的步数。结果与逐步调用 cfdSolverStep 逐位相同。
+*/
+i64             cfdTemporalAdvance  (CfdTemporal *tb, CfdSolver *s, i64 nsteps, f64 t_stop);
+
+#endif /* CFD_TEMPORAL_H */
@@ -6,21 +6,242 @@
 #define CFD_UTIL_H
 
 #include "constants.h"
+#include "cfd_config.h"
+#include "cfd_report.h"
+#include "cfd_eos.h"
+#include "cfd_grid.h"
 
-extern f64 vel[NX];    // 速度数组
-extern f64 pres[NX];   // 压力数组
-extern f64 rho[NX];    // 密度数组
+#define PISTON_HARMONICS    50      // 活塞加速度 Fourier 级数的谐波数
+#define PISTON_RESYNC_STEPS 4096    // 递推模式下每隔多少步用精确求和重新同步
 
-extern f64 fourierSeries[50][2];
+extern const f64 fourierSeries[PISTON_HARMONICS][2];
 
+/* 活塞加速度的来源（pistonAccelInit 的 source） */
+#define CFD_PISTON_FOURIER      0   // 傅里叶级数：逐步精确求和，或按 use_recurrence 递推
+#define CFD_PISTON_TABLE        1   // 一个周期内均匀采样的级数值，线性插值
+#define CFD_PISTON_PIECEWISE    2   // 题设的分段常数曲线 3/0/1/0 m/s^2，精确且没有 Gibbs 振荡
+
+#define PISTON_TABLE_SIZE       2048    // 查表模式每个周期的采样段数
+
+/*
+    活塞加速度曲线：a(t) = amplitude * (dc + Σ a_n cos(w_n t) + b_n sin(w_n t))，w_n = 2πn / period。
+    题设曲线（pistonProfileDefault）的系数即 fourierSeries；集合运行（见 cfd_ensemble.h）中
+    每个成员各有一条曲线。
+*/
+typedef struct {
+    f64 period;                     // 周期 (s)
+    f64 dc;                         // 常数项 a0/2
+    f64 amplitude;                  // 整体缩放系数
+    f64 coef[PISTON_HARMONICS][2];  // (a_n, b_n)
+} PistonProfile;
+
+void    pistonProfileDefault(PistonProfile *p);
+f64     pistonProfileEval   (const PistonProfile *p, f64 time);
+/* 题设的分段常数曲线，按 p->period 伸缩、乘以 p->amplitude（不使用傅里叶系数） */
+f64     pistonPiecewiseEval (const PistonProfile *p, f64 time);
+/* 活塞从静止出发（t = 0 时速度与位移为 0），加速度曲线的一次与二次积分（解析求出） */
+void    pistonProfileKinematics(const PistonProfile *p, f64 time, f64 *vel, f64 *disp);
+
+/*
+    每个时间步的活塞加速度上下文：加速度只依赖于 t，每步计算一次后传给各个核。
+    source 选择加速度的来源 CFD_PISTON_*。傅里叶级数下 use_recurrence 为真时，
+    各谐波的 (cos, sin) 以固定角度 w*dt 旋转推进，每步只需乘加运算，不再调用三角函数；
+    查表与分段曲线每步只需 O(1) 次运算，不使用递推。
+*/
+typedef struct {
+    const PistonProfile *profile;   // 加速度曲线（由调用者持有）
+    i32 source;                     // CFD_PISTON_*
+    f64 time;                       // 当前时刻
+    f64 dt;                         // 时间步长
+    f64 acc;                        // 当前时刻的加速度
+    i32 use_recurrence;             // 是否使用递推求值（只用于傅里叶级数）
+    i32 since_sync;                 // 距上次精确同步的步数
+    f64 w[PISTON_HARMONICS];        // 各谐波的角频率 2πn/T，初始化时求出
+    f64 c[PISTON_HARMONICS];        // cos(w_n t)
+    f64 s[PISTON_HARMONICS];        // sin(w_n t)
+    f64 cd[PISTON_HARMONICS];       // cos(w_n dt)
+    f64 sd[PISTON_HARMONICS];       // sin(w_n dt)
+    f64 table[PISTON_TABLE_SIZE + 1];   // 查表模式：a(j T / PISTON_TABLE_SIZE)，末项与首项相同
+} PistonAccel;
+
+/* 题设曲线的加速度 */
 f64     getPistonAcceleration(f64 time);
 
-void    initFlowField();
+/* profile 为 NULL 时使用题设曲线，source 为 CFD_PISTON_* */
+void    pistonAccelInit     (PistonAccel *pa, const PistonProfile *profile, f64 time, f64 dt, i32 source, i32 use_recurrence);
+f64     pistonAccelAdvance  (PistonAccel *pa);
+/* 修改后续推进使用的步长（递推模式下会重新计算旋转角并精确同步一次） */
+void    pistonAccelSetDt    (PistonAccel *pa, f64 dt);
+/* pa->time 时刻活塞的速度与位移；递推模式下复用递推的 (cos, sin)，不再调用三角函数 */
+void    pistonAccelKinematics(const PistonAccel *pa, f64 *vel, f64 *disp);
+/* 任意时刻的加速度（按 pa 的来源精确求值，不改变推进状态），供多级时间格式的中间级使用 */
+f64     pistonAccelAt       (const PistonAccel *pa, f64 time);
+
+#define CFD_PRECISION_DOUBLE    0   // 流场以 f64 存储
+#define CFD_PRECISION_MIXED     1   // 流场以 f32 存储（相对初值的偏差），以 f64 计算（见 cfd_mixed.h）
+
+/* 看门狗中止的原因（CfdWatch.tripped） */
+#define CFD_WATCH_OK            0
+#define CFD_WATCH_NONFINITE     1   // 流场出现 NaN 或 inf
+#define CFD_WATCH_DENSITY       2   // 密度不为正
+#define CFD_WATCH_CFL           3   // (max|v| + c) dt / dx 超过时间推进格式的稳定上限
+
+/*
+    一步新场的归约：融合核在写出 rho_next/vel_next 的同一遍中顺带求出，不再单独读一遍流场。
+    bad 累加每个点的 rho + vel：有限的场值相加不会溢出，和只在某点为 NaN 或 inf 时才不是有限值，
+    每点只多两次加法（NaN 在 max/min 的比较中会被丢掉，非有限值只能靠它发现）。
+*/
+typedef struct {
+    f64 vmax;                       // max|v|
+    f64 rmin;                       // min rho
+    f64 bad;                        // 非有限值标记
+} CfdWatchSums;
+
+/*
+    每步的稳定性看门狗（见 watchdog）。Taylor 格式在主机上的 f64 与混合精度路径（含常驻并行区、
+    拉伸网格与活动区）每步都在核内归约，其余路径（多级格式、时间分块、卸载）由调用者
+    隔若干步用 cfdSolverWatchScan 单独扫描一遍。
+*/
+typedef struct {
+    i32 enabled;                    // 是否在核内归约
+    f64 limit;                      // CFL 上限（格式的稳定上限乘以 WATCHDOG_CFL_MARGIN）
+    CfdWatchSums sums;              // 正在推进的这一步的归约
+    i32 fused;                      // 最近一步是否已在核内检查过
+    f64 vmax, rmin, cfl;            // 最近一次检查的 max|v|、min rho 与 CFL 数，中止后保持中止那一步的值
+    i32 tripped;                    // CFD_WATCH_*，非 0 后保持到求解器销毁
+    i64 trip_step;                  // 发现异常的步数
+    f64 trip_t;                     // 发现异常的时刻 (s)
+} CfdWatch;
+
+/*
+    求解器上下文：网格参数、双缓冲的流场数组以及推进状态。
+    数组在堆上按 nx 分配，同一进程内可以依次运行不同分辨率的算例。
+*/
+typedef struct CfdSolver {
+    i32 nx;                         // 仿真点数
+    f64 dx;                         // 空间步长 (m)；拉伸网格时为最小间距（活塞面处）
+    CfdGrid *grid;                  // 拉伸网格的坐标与差分系数（见 cfd_grid.h），均匀网格时为 NULL
+    f64 dt;                         // 时间步长 (s)
+    f64 half_dt2;                   // 二阶时间项系数 dt^2/2
+    i32 simd;                       // 融合核内部点的实现 CFD_SIMD_*（见 cfd_simd.h）
+    i32 stepper;                    // 时间推进格式 CFD_STEPPER_*（见 cfd_stepper.h）
+
+    f64 *vel;                       // 速度数组（当前步）
+    f64 *pres;                      // 压力数组（当前步）
+    f64 *rho;                       // 密度数组（当前步）
+    f64 *vel_next;                  // 下一步速度（更新函数的输出）
+    f64 *pres_next;                 // 下一步压力
+    f64 *rho_next;                  // 下一步密度
+    f64 *stage_rho[2], *stage_vel[2];   // 多级时间格式的阶段缓冲，按格式需要分配（Taylor 时均为 NULL）
+
+    /*
+        导出压力（derived_pressure 非 0）时不存储压力场：pres_next 不分配，也没有每步的压力循环。
+        压力滞后密度一步，由上一步的密度（交换后留在 rho_next 中）经状态方程求出；
+        pres 只在 cfdSolverSync 时填充，供输出读取。
+    */
+    i32 derived_pressure;
+    CfdEos eos;                     // 状态方程挂钩（见 cfd_eos.h）
+
+    /*
+        混合精度存储（precision 为 CFD_PRECISION_MIXED 时使用）。此时 *_next 的 f64 数组不分配，
+        vel/pres/rho 只在 cfdSolverSync 时由 f32 存储展开，供输出与进度显示读取。
+    */
+    i32 precision;                  // CFD_PRECISION_*
+    f32 *drho, *drho_next;          // rho - RHO_INIT
+    f32 *vel32, *vel32_next;        // vel
+    f32 *dpres, *dpres_next;        // pres - P_INIT
+    i32 synced;                     // vel/pres/rho 是否已按当前步展开（见 cfdSolverSync）
+    struct CfdSolver *shadow;       // 逐步同步推进的 f64 求解器，用于误差报告（可为 NULL）
+    i32 device;                     // 流场是否常驻在卸载设备上（见 cfd_offload.h），此时主机数组只在同步后有效
+    struct CfdActive *active;       // 活动区跟踪（见 cfd_active.h），为 NULL 时每步更新全部网格；段内数组只在同步后有效
+
+    f64 t;                          // 当前时刻
+    i64 step;                       // 已推进的步数
+    PistonProfile profile;          // 活塞加速度曲线（求解器持有的副本，pa.profile 指向它）
+    PistonAccel pa;                 // 当前时刻的活塞加速度
+    CfdTimers timers;               // 各阶段耗时统计
+    CfdWatch watch;                 // 稳定性看门狗
+} CfdSolver;
+
+/* 按配置分配求解器并初始化流场；失败返回 NULL */
+CfdSolver * cfdSolverCreate     (const CfdConfig *cfg);
+void        cfdSolverDestroy    (CfdSolver *s);
+
+/* 推进一个时间步：更新 rho/vel/pres、交换缓冲区、推进时间与活塞加速度（有 shadow 时一并推进） */
+void        cfdSolverStep       (CfdSolver *s);
+
+/*
+    在一个常驻的 OpenMP 并行区内连续推进至多 nsteps 步，结果与逐步调用 cfdSolverStep 相同。
+    线程组只创建一次，每个线程在整个过程中负责固定的一段网格，每步只有一个 barrier。
+    某一步结束时 t > t_stop 或看门狗中止则提前返回（已中止时不再推进）；返回实际推进的步数。
+*/
+i64         cfdSolverAdvance    (CfdSolver *s, i64 nsteps, f64 t_stop);
+
+/* 修改时间步长（自适应步长时使用），同步更新 half_dt2 与活塞加速度上下文 */
+void        cfdSolverSetDt      (CfdSolver *s, f64 dt);
+
+/* 换用另一条活塞加速度曲线（从当前时刻起生效，系数复制到 s->profile） */
+void        cfdSolverSetProfile (CfdSolver *s, const PistonProfile *profile);
+
+/*
+    把当前步的流场展开到 vel/pres/rho 三个 f64 数组，供输出与进度显示读取：
+    混合精度时由 f32 存储转换，跟踪活动区时写回均匀段，导出压力时按状态方程填充 pres。
+    都不是时什么也不做。
+*/
+void        cfdSolverSync       (CfdSolver *s);
+
+/*
+    网格点 i 当前步的 rho/vel/pres（out[0..2]），与 cfdSolverSync 展开后的值逐位相同，
+    但只读取这一个点：混合精度时由 f32 存储换算，导出压力时按状态方程求出。
+    流场在设备上时先对这些点调用 cfdSolverFetchPoints。
+*/
+void        cfdSolverPoint      (const CfdSolver *s, i32 i, f64 *out);
+
+/* 流场在设备上时把 idx[0..n) 这些点传回主机数组，否则什么也不做 */
+void        cfdSolverFetchPoints(const CfdSolver *s, const i32 *idx, i32 n);
+
+/* CFL 条件中的特征速度 max(|v| + c)，c = sqrt(K) */
+f64         cfdSolverMaxWaveSpeed(CfdSolver *s);
+
+/* 展开当前步的流场并检查 rho/vel 全部有限、rho 为正；返回第一个异常点的下标，全部正常时返回 -1 */
+i32         cfdSolverFindInvalid(CfdSolver *s);
+
+/*
+    对当前步的流场做一遍看门狗检查（用于核内不归约的推进路径），结果记入 s->watch；
+    返回 s->watch.tripped
+*/
+i32         cfdSolverWatchScan  (CfdSolver *s);
+
+/*
+    看门狗在核内发现异常的那一步之后，退回上一步（仍保存在 *_next 中）的状态，以便把它写入检查点。
+    只用于 f64 存储的压力、没有活动区与 shadow、流场在主机上的情形；不能退回时返回 -1。
+    活塞加速度在退回的时刻重新精确求值。
+*/
+i32         cfdSolverRewind     (CfdSolver *s);
+
+const char *cfdWatchReason      (i32 tripped);
+
+void    initFlowField   (CfdSolver *s);
+
+/* 更新函数读取当前场，内部点结果写入 *_next（边界见 updateBorders）；全部更新完成后调用 swapFlowField */
+void    updateVelocity  (CfdSolver *s, f64 acc);
+void    updatePressure  (CfdSolver *s);
+void    updateRho       (CfdSolver *s, f64 acc);
+
+/* 融合核：一次遍历同时写出 rho_next 与 vel_next 的内部点；看门狗开启时顺带归约到 s->watch.sums */
+void    updateFlowField (CfdSolver *s, f64 acc);
+/* 只更新内部点 [lo, hi)（1 <= lo, hi <= nx - 1）的融合核，以及只更新 [lo, hi) 的压力（见 cfd_active.h） */
+void    updateFlowFieldRange(CfdSolver *s, f64 acc, i32 lo, i32 hi);
+void    updatePressureRange (CfdSolver *s, i32 lo, i32 hi);
+
+/*
+    写出 rho_next 与 vel_next 的左右边界值。导出压力时要读取 rho_next 中上一步的密度，
+    因此必须在内部点的核之前调用。
+*/
+void    updateBorders   (CfdSolver *s, f64 acc);
 
-f64 *   updateVelocity  (f64 time);
-f64 *   updatePressure  (f64 time);
-f64 *   updateRho       (f64 time);
+void    swapFlowField   (CfdSolver *s);
 
-f64     rborderRho      ();
-f64     rborderVel      (f64 time);
+f64     rborderRho      (const CfdSolver *s);
+f64     rborderVel      (const CfdSolver *s, f64 acc);
 #endif /* CFD_UTIL_H */
\ No newline at end of file
@@ -6,6 +6,7 @@
 #ifndef __CONSTANTS_H
 #define __CONSTANTS_H
 
+#define u8 unsigned char
 #define i32 int
 #define u32 unsigned int
 #define i64 long long
@@ -22,14 +23,50 @@
 #define RHO_INIT (P_INIT * MU_STAR / (R * T_INIT)) // 初始密度 (kg/m^3)
 #define K (R * T_INIT) / MU_STAR
 
+/* 以下为运行参数的默认值，可通过命令行或配置文件覆盖（见 cfd_config.h） */
 #define NX 1000                         // X 方向的仿真点数（细网格）
 #define DX 5e-3                         // X 方向的空间步长 (m)
+#define GRID_STRETCH 0.0                // 网格向活塞面加密的拉伸系数（0 表示均匀网格）
 
 #define DT 1e-5                         // 时间步长 (s)
-#define HALF_DT2 (DT * DT) / 2          // 二阶时间项系数
 #define T_END 60.0                      // 结束时间 (s)
 
 #define TIMER 1e-1                      // 保存时间间隔 (s)
 #define PRINT_AFTER_STEPS 1000           // 每隔多少步更新一次终端输出
 
+#define OUTPUT_QUEUE 4                  // 后台写线程的快照队列深度（0 表示在求解线程中同步写出）
+
+#define CFL 0.0                         // 自适应时间步的 CFL 数（0 表示使用固定的 DT）
+#define CFL_INTERVAL 10                 // 自适应模式下每隔多少步重新估计 max(|v|+c)
+
+#define PISTON_RECURRENCE 0             // 活塞加速度使用递推求值（默认 0 为每步精确求和，与逐步调用三角函数逐位相同）
+
+#define STEPPER 0                       // 时间推进格式 CFD_STEPPER_*，0 为二阶 Taylor 展开
+#define PERSISTENT_REGION 0             // 固定步长时在常驻 OpenMP 并行区内连续推进多步
+#define TEMPORAL_DEPTH 0                // 时间分块每次载入 tile 推进的步数，0 表示不分块
+#define TEMPORAL_TILE 0                 // 时间分块的 tile 点数，0 表示按 L2 容量自动选取
+#define ACTIVE_REGION 0                 // 跟踪声波前沿，不逐点更新前沿之前仍未扰动的网格
+
+#define DERIVED_PRESSURE 0              // 不存储压力场，在边界与输出时由状态方程按密度求出
+
+#define CHECKPOINT_INTERVAL 0.0         // 检查点的墙钟时间间隔 (s)，0 表示不写检查点
+#define PROBE_EVERY 1                   // 探针时间序列的采样间隔（步）
+#define LIVE_EVERY 100                  // 实时发布流场的间隔（步）
+#define LIVE_SLOTS 8                    // 实时发布的环形缓冲区槽数
+#define NAN_CHECK 0                     // 核内不归约时扫描流场是否发散的间隔（步），0 表示开启看门狗时取 PRINT_AFTER_STEPS
+#define WATCHDOG 1                      // 每步检查 max|v|、min rho 与非有限值，发散时中止
+#define WATCHDOG_CFL_MARGIN 1.05        // CFL 数超过格式稳定上限的这一倍数才中止（自适应步长在两次估计之间会略有超出）
+#define SWEEP_SPLIT_NX 100000           // 参数扫描中用全部线程运行的作业的最小 nx
+
+/*
+    更新核的 OpenMP 调度方式，写在各个 schedule(...) 子句里，不改动进程的 OpenMP 设置
+    （求解器库与宿主程序共用 OpenMP 运行时）。static 与 initFlowField 首次写入的划分一致；
+    USE_RUNTIME_SCHEDULE 打开时为 runtime，由 OMP_SCHEDULE 或基准程序的 --schedule 选择。
+*/
+#ifdef CFD_RUNTIME_SCHEDULE
+#define CFD_OMP_SCHEDULE runtime
+#else
+#define CFD_OMP_SCHEDULE static
+#endif
+
 #endif /* __CONSTANTS_H */
\ No newline at end of file
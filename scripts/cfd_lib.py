@@ -0,0 +1,255 @@
+#!/usr/bin/env python3
+"""
+cfd_lib.py
+
+ctypes bindings for libcfd, the solver library built next to `sim`
+(build/libcfd.so; the C API is include/cfd_api.h). A Solver owns one
+solver handle, steps it in-process and exposes the current fields as NumPy
+arrays over the solver's own memory, so an optimization loop can run many
+cases without writing CSV or snapshot files or spawning processes.
+
+The solver double-buffers its fields: an array returned by field() (or
+rho/vel/pres) is only valid until the next step() or close(), so fetch it
+again after stepping (this is cheap, nothing is copied). Copy it with
+.copy() to keep it. The arrays are read-only. Each array holds a reference
+to its Solver, so the solver's memory is not freed while an array is alive:
+close() stops the solver at once but frees it only after the last array
+is gone.
+
+The library is looked up in $CFD_LIB, then build/ and _build/ next to
+this script's parent directory, then the system library path.
+
+Usage examples:
+  from cfd_lib import Solver
+  with Solver(nx=1000, dt=1e-6) as s:
+      s.set_profile(coef=[(a1, b1), (a2, b2)], period=60.0, dc=2/3)
+      s.step(10000)
+      s.t, s.pres[0], s.x
+
+  python scripts/cfd_lib.py nx=1000 dt=1e-6   # step to t=0.01 s and print a summary
+"""
+from __future__ import annotations
+
+import ctypes
+import ctypes.util
+import os
+import sys
+import weakref
+from typing import Iterable, Optional, Sequence, Tuple, Union
+
+import numpy as np
+
+API_VERSION = 1
+FIELDS = {'rho': 0, 'vel': 1, 'pres': 2, 'x': 3}
+# Period and a0/2 of the README's piecewise acceleration (see fourier_piston.py)
+README_PERIOD = 60.0
+README_DC = 2.0 / 3.0
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def _find_library() -> str:
+    path = os.environ.get('CFD_LIB')
+    if path:
+        return path
+    root = os.path.dirname(HERE)
+    for build in ('build', '_build'):
+        for name in ('libcfd.so', 'libcfd.dylib', 'cfd.dll'):
+            candidate = os.path.join(root, build, name)
+            if os.path.exists(candidate):
+                return candidate
+    found = ctypes.util.find_library('cfd')
+    if found is None:
+        raise OSError("libcfd not found; build it with cmake (target 'cfd') or set CFD_LIB")
+    return found
+
+
+def load(path: Optional[str] = None) -> ctypes.CDLL:
+    """Load libcfd and declare the C signatures; checks the API version."""
+    lib = ctypes.CDLL(path or _find_library())
+    handle = ctypes.c_void_p
+    lib.cfdLibVersion.restype = ctypes.c_int
+    lib.cfdLibVersion.argtypes = []
+    lib.cfdLibHarmonics.restype = ctypes.c_int
+    lib.cfdLibHarmonics.argtypes = []
+    lib.cfdLibCreate.restype = handle
+    lib.cfdLibCreate.argtypes = [ctypes.c_char_p]
+    lib.cfdLibDestroy.restype = None
+    lib.cfdLibDestroy.argtypes = [handle]
+    lib.cfdLibSetProfile.restype = ctypes.c_int
+    lib.cfdLibSetProfile.argtypes = [handle, ctypes.c_double, ctypes.c_double, ctypes.c_double,
+                                     ctypes.POINTER(ctypes.c_double), ctypes.c_int]
+    lib.cfdLibStep.restype = ctypes.c_longlong
+    lib.cfdLibStep.argtypes = [handle, ctypes.c_longlong]
+    lib.cfdLibField.restype = ctypes.c_int
+    lib.cfdLibField.argtypes = [handle, ctypes.c_int, ctypes.POINTER(ctypes.POINTER(ctypes.c_double))]
+    lib.cfdLibTime.restype = ctypes.c_double
+    lib.cfdLibTime.argtypes = [handle]
+    lib.cfdLibSteps.restype = ctypes.c_longlong
+    lib.cfdLibSteps.argtypes = [handle]
+    lib.cfdLibDt.restype = ctypes.c_double
+    lib.cfdLibDt.argtypes = [handle]
+    lib.cfdLibStatus.restype = ctypes.c_int
+    lib.cfdLibStatus.argtypes = [handle, ctypes.POINTER(ctypes.c_char_p)]
+    version = lib.cfdLibVersion()
+    if version != API_VERSION:
+        raise OSError(f"libcfd API version {version}, these bindings expect {API_VERSION}")
+    return lib
+
+
+_lib: Optional[ctypes.CDLL] = None
+
+
+def _default_lib() -> ctypes.CDLL:
+    global _lib
+    if _lib is None:
+        _lib = load()
+    return _lib
+
+
+def _options(options: Union[None, str, dict], kwargs: dict) -> bytes:
+    items = []
+    if isinstance(options, str):
+        items.append(options)
+    elif options:
+        items.extend(f"{k} = {v}" for k, v in options.items())
+    items.extend(f"{k} = {v}" for k, v in kwargs.items())
+    return '\n'.join(items).encode()
+
+
+class SolverError(RuntimeError):
+    pass
+
+
+class Solver:
+    """One in-process solver. Keyword arguments are config keys (nx=1000, dt=1e-6, stepper='rk4', ...)."""
+
+    def __init__(self, options: Union[None, str, dict] = None, lib: Optional[ctypes.CDLL] = None, **kwargs):
+        self._h = None
+        self._closed = False
+        self._views = 0
+        self._lib = lib or _default_lib()
+        self._h = self._lib.cfdLibCreate(_options(options, kwargs))
+        if not self._h:
+            raise SolverError("cfdLibCreate failed (see the [ERROR] lines above)")
+        data = ctypes.POINTER(ctypes.c_double)()
+        self.nx = self._lib.cfdLibField(self._h, FIELDS['x'], ctypes.byref(data))
+
+    def close(self):
+        """Stop using the solver; its memory is freed once no field() array refers to it."""
+        self._closed = True
+        if self._views == 0:
+            self._destroy()
+
+    def _destroy(self):
+        if self._h:
+            self._lib.cfdLibDestroy(self._h)
+            self._h = None
+
+    def _release_view(self):
+        self._views -= 1
+        if self._closed and self._views == 0:
+            self._destroy()
+
+    def __enter__(self) -> 'Solver':
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self._destroy()
+
+    def _handle(self):
+        if self._closed or not self._h:
+            raise SolverError("solver is closed")
+        return self._h
+
+    def set_profile(self, coef: Optional[Iterable[Tuple[float, float]]] = None, period: float = README_PERIOD,
+                    dc: float = README_DC, amplitude: float = 1.0):
+        """a(t) = amplitude * (dc + sum a_n cos(2 pi n t/period) + b_n sin(...)); coef=None keeps the README series."""
+        if coef is None:
+            ptr, n = None, 0
+        else:
+            flat = np.ascontiguousarray(np.asarray(coef, dtype=np.float64).reshape(-1))
+            n = len(flat) // 2
+            ptr = flat.ctypes.data_as(ctypes.POINTER(ctypes.c_double))
+        if self._lib.cfdLibSetProfile(self._handle(), period, dc, amplitude, ptr, n) != 0:
+            raise SolverError("cfdLibSetProfile failed (see the [ERROR] line above)")
+
+    def step(self, nsteps: int = 1) -> int:
+        """Advance nsteps steps; returns the steps actually taken (fewer once the watchdog trips)."""
+        done = self._lib.cfdLibStep(self._handle(), nsteps)
+        if done < 0:
+            raise SolverError("cfdLibStep failed")
+        return done
+
+    def run_until(self, t_end: float) -> int:
+        """Step until t >= t_end (or the watchdog trips); returns the steps taken."""
+        n = max(0, int(round((t_end - self.t) / self.dt)))
+        return self.step(n)
+
+    def field(self, name: str) -> np.ndarray:
+        """Read-only view of the current rho, vel, pres or x; holds the current step only until the next step()."""
+        if name not in FIELDS:
+            raise ValueError(f"field must be one of {tuple(FIELDS)}")
+        data = ctypes.POINTER(ctypes.c_double)()
+        n = self._lib.cfdLibField(self._handle(), FIELDS[name], ctypes.byref(data))
+        if n < 0:
+            raise SolverError("cfdLibField failed")
+        # The ctypes buffer becomes the array's base and keeps this Solver (and so the memory) alive
+        buf = (ctypes.c_double * n).from_address(ctypes.addressof(data.contents))
+        buf._solver = self
+        self._views += 1
+        weakref.finalize(buf, self._release_view)
+        view = np.frombuffer(buf, dtype=np.float64)
+        view.flags.writeable = False
+        return view
+
+    @property
+    def rho(self) -> np.ndarray:
+        return self.field('rho')
+
+    @property
+    def vel(self) -> np.ndarray:
+        return self.field('vel')
+
+    @property
+    def pres(self) -> np.ndarray:
+        return self.field('pres')
+
+    @property
+    def x(self) -> np.ndarray:
+        return self.field('x')
+
+    @property
+    def t(self) -> float:
+        return self._lib.cfdLibTime(self._handle())
+
+    @property
+    def steps(self) -> int:
+        return self._lib.cfdLibSteps(self._handle())
+
+    @property
+    def dt(self) -> float:
+        return self._lib.cfdLibDt(self._handle())
+
+    @property
+    def status(self) -> Tuple[int, str]:
+        """Watchdog state: (0, '') while stable, else (code, reason)."""
+        reason = ctypes.c_char_p()
+        code = self._lib.cfdLibStatus(self._handle(), ctypes.byref(reason))
+        return code, reason.value.decode()
+
+
+def main(argv: Sequence[str]):
+    options = '\n'.join(argv)
+    with Solver(options) as s:
+        taken = s.run_until(0.01)
+        code, reason = s.status
+        print(f"NX={s.nx} dt={s.dt:.3e}: {taken} steps to t={s.t:.6f} s"
+              + (f", stopped: {reason}" if code else ""))
+        print(f"pres[0]={s.pres[0]:.8f} vel[0]={s.vel[0]:.8f} max|vel|={np.abs(s.vel).max():.6f}")
+
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
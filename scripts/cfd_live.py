@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""
+cfd_live.py
+
+Reader for the live field ring buffer that main.c publishes with
+`sim --live NAME` (a POSIX shared-memory object, /dev/shm/NAME on Linux;
+see include/cfd_live.h for the layout).
+
+Shared-memory layout (native little-endian):
+  header:  magic "CFDLIVE1", u32 version, u32 header_bytes, u32 slots,
+           u32 closed, u64 slot_bytes, u64 published, i64 pid,
+           then a snapshot header (see cfd_snapshots.py) describing the samples
+  slots:   at header_bytes + k*slot_bytes: u64 seq, u64 frame, i64 step, f64 time,
+           f64 rho[npoints], f64 vel[npoints], f64 pres[npoints]
+
+Frame k lives in slot k % slots. The solver sets seq to 2k+1 while it writes
+the slot and to 2k+2 once the slot is complete, then sets published = k+1.
+A reader copies the newest slot and keeps the copy only if seq read 2k+2
+both before and after the copy (a seqlock), so the solver never waits for
+the viewer; a slow viewer just skips frames. The check relies on the loads
+not being reordered around the copy, which holds on x86 (TSO); elsewhere a
+torn frame is still caught whenever the solver has started to rewrite it.
+
+The solver re-creates the object at start-up and unlinks it on exit; a
+reader that has the previous object mapped notices the new run through
+stale() and re-opens it.
+
+Usage examples:
+  from cfd_live import LiveField
+  live = LiveField('cfd')
+  frame = live.latest()    # LiveFrame or None when nothing new was published
+  frame.time, frame.field('pres'), live.x
+
+  python scripts/cfd_live.py cfd   # print frames as they arrive
+"""
+from __future__ import annotations
+
+import mmap
+import os
+import struct
+import sys
+import time
+from dataclasses import dataclass
+from typing import Optional
+
+import numpy as np
+
+from cfd_snapshots import FIELDS, HEADER_MAX_SIZE, SnapshotHeader, parse_header, sample_idx, sample_x
+
+MAGIC = b'CFDLIVE1'
+HEADER = struct.Struct('<8sIIIIQQq')
+SLOT = struct.Struct('<QQqd')
+PUBLISHED_OFFSET = 32
+CLOSED_OFFSET = 20
+SHM_DIR = '/dev/shm'
+
+
+@dataclass
+class LiveFrame:
+    frame: int
+    step: int
+    time: float
+    rho: np.ndarray
+    vel: np.ndarray
+    pres: np.ndarray
+
+    def field(self, name: str) -> np.ndarray:
+        if name not in FIELDS:
+            raise ValueError(f"field must be one of {FIELDS}")
+        return getattr(self, name)
+
+
+def _open_shm(name: str):
+    """Map the shared-memory object read-only; returns (mmap, inode or None)."""
+    path = os.path.join(SHM_DIR, name.lstrip('/'))
+    if os.path.isdir(SHM_DIR):
+        fd = os.open(path, os.O_RDONLY)
+        try:
+            return mmap.mmap(fd, 0, prot=mmap.PROT_READ), os.fstat(fd).st_ino
+        finally:
+            os.close(fd)
+    # No /dev/shm (e.g. macOS): go through shm_open, without letting the
+    # resource tracker unlink the solver's object when this process exits
+    from multiprocessing import resource_tracker, shared_memory
+    shm = shared_memory.SharedMemory(name=name.lstrip('/'), create=False)
+    resource_tracker.unregister(shm._name, 'shared_memory')
+    return shm.buf, None
+
+
+class LiveField:
+    """Read-only view of the live ring buffer published by `sim --live NAME`."""
+
+    def __init__(self, name: str):
+        self.name = name
+        self.buf, self._inode = _open_shm(name)
+        magic, version, header_bytes, slots, _, slot_bytes, _, pid = HEADER.unpack_from(self.buf, 0)
+        if magic != MAGIC:
+            raise ValueError(f"{name}: not a CFD live buffer (magic={magic!r}); the solver may still be starting")
+        self.version = version
+        self.header_bytes = header_bytes
+        self.slots = slots
+        self.slot_bytes = slot_bytes
+        self.pid = pid
+        self.header: SnapshotHeader = parse_header(bytes(self.buf[HEADER.size:HEADER.size + HEADER_MAX_SIZE]), name)
+        self.last = 0
+
+    @property
+    def published(self) -> int:
+        return struct.unpack_from('<Q', self.buf, PUBLISHED_OFFSET)[0]
+
+    @property
+    def closed(self) -> bool:
+        return struct.unpack_from('<I', self.buf, CLOSED_OFFSET)[0] != 0
+
+    @property
+    def idx(self) -> np.ndarray:
+        return sample_idx(self.header)
+
+    @property
+    def x(self) -> np.ndarray:
+        return sample_x(self.header)
+
+    def stale(self) -> bool:
+        """True when a newer run has replaced the object this reader has mapped."""
+        if self._inode is None:
+            return False
+        try:
+            return os.stat(os.path.join(SHM_DIR, self.name.lstrip('/'))).st_ino != self._inode
+        except FileNotFoundError:
+            return False
+
+    def read(self, k: int) -> Optional[LiveFrame]:
+        """Copy frame k if its slot still holds it intact; None if it is being (or has been) overwritten."""
+        n = self.header.npoints
+        base = self.header_bytes + (k % self.slots) * self.slot_bytes
+        seq = struct.unpack_from('<Q', self.buf, base)[0]
+        if seq != 2 * k + 2:
+            return None
+        data = np.frombuffer(self.buf, dtype='<f8', count=3 * n, offset=base + SLOT.size).copy()
+        seq_after, frame, step, t = SLOT.unpack_from(self.buf, base)
+        if seq_after != seq:
+            return None
+        return LiveFrame(frame, step, t, data[:n], data[n:2 * n], data[2 * n:])
+
+    def latest(self) -> Optional[LiveFrame]:
+        """The newest complete frame, or None when nothing new was published since the last call."""
+        for _ in range(self.slots):
+            published = self.published
+            if published == 0 or published == self.last:
+                return None
+            frame = self.read(published - 1)
+            if frame is not None:
+                self.last = published
+                return frame
+        return None
+
+
+def main():
+    if len(sys.argv) != 2:
+        raise SystemExit("usage: cfd_live.py <shared-memory name>")
+    live = LiveField(sys.argv[1])
+    h = live.header
+    print(f"NX={h.nx} npoints={h.npoints} slots={live.slots} writer pid={live.pid}")
+    while not live.closed:
+        frame = live.latest()
+        if frame is not None:
+            print(f"frame {frame.frame}: step {frame.step} t={frame.time:.6f} "
+                  f"pres[0]={frame.pres[0]:.8f} max|vel|={np.abs(frame.vel).max():.6f}")
+        time.sleep(0.05)
+
+
+if __name__ == '__main__':
+    main()
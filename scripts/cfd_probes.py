@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+cfd_probes.py
+
+Zero-parse reader for the probe time series written by main.c
+(build/probes.bin, see include/cfd_probe.h for the layout).
+
+File layout (native little-endian):
+  header:  magic "CFDPROB1", u32 version, u32 header_bytes,
+           i64 nx, i64 nprobes, i64 every, f64 dx, f64 dt,
+           f64 grid_stretch, f64 grid_length (version >= 2),
+           i64 idx[nprobes]
+  records: f64 time, f64 piston_acc, f64 piston_vel, f64 piston_disp,
+           then f64 rho, vel, pres for every probe
+
+Records are exposed through numpy.memmap, so every column is a strided view
+into the mapped file; nothing is parsed or copied up front.
+
+Usage examples:
+  from cfd_probes import ProbeFile
+  probes = ProbeFile('build/probes.bin')
+  probes.times              # (nrecords,)
+  probes.piston('vel')      # piston velocity, (nrecords,)
+  probes.field('pres')      # (nrecords, nprobes) view, columns follow probes.idx
+  probes.series(0, 'pres')  # pres at grid index 0, (nrecords,)
+
+  python scripts/cfd_probes.py build/probes.bin   # print a summary
+"""
+from __future__ import annotations
+
+import os
+import struct
+import sys
+from dataclasses import dataclass
+from typing import Optional, Tuple
+
+import numpy as np
+
+MAGIC = b'CFDPROB1'
+HEADER_FORMAT = '<8sIIqqqdd'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+HEADER_V2_EXTRA = '<dd'
+DEFAULT_NAME = 'probes.bin'
+FIELDS = ('rho', 'vel', 'pres')
+PISTON = ('acc', 'vel', 'disp')
+
+
+@dataclass
+class ProbeHeader:
+    version: int
+    header_bytes: int
+    nx: int
+    nprobes: int
+    every: int
+    dx: float
+    dt: float
+    idx: Tuple[int, ...]
+    grid_stretch: float = 0.0
+    grid_length: float = 0.0
+
+
+def read_header(path: str) -> ProbeHeader:
+    with open(path, 'rb') as f:
+        raw = f.read(HEADER_SIZE)
+        if len(raw) < HEADER_SIZE:
+            raise ValueError(f"{path}: file too short for a probe header")
+        magic, version, header_bytes, nx, nprobes, every, dx, dt = struct.unpack(HEADER_FORMAT, raw)
+        if magic != MAGIC:
+            raise ValueError(f"{path}: not a CFD probe file (magic={magic!r})")
+        stretch = length = 0.0
+        if version >= 2:
+            stretch, length = struct.unpack(HEADER_V2_EXTRA, f.read(struct.calcsize(HEADER_V2_EXTRA)))
+        idx = struct.unpack(f'<{nprobes}q', f.read(8 * nprobes))
+    return ProbeHeader(version, header_bytes, nx, nprobes, every, dx, dt, idx, stretch, length)
+
+
+class ProbeFile:
+    """Memory-mapped view over all complete records of a probe file."""
+
+    def __init__(self, path: str):
+        self.path = path
+        self.header = read_header(path)
+        n = self.header.nprobes
+        self.record_dtype = np.dtype([('time', '<f8'), ('piston_acc', '<f8'), ('piston_vel', '<f8'),
+                                      ('piston_disp', '<f8'), ('probe', '<f8', (n, 3))])
+        self.records = self._map()
+
+    def _map(self) -> np.ndarray:
+        size = os.path.getsize(self.path) - self.header.header_bytes
+        count = max(0, size // self.record_dtype.itemsize)
+        if count == 0:
+            return np.zeros(0, dtype=self.record_dtype)
+        # Only map complete records; a record still being written is ignored
+        return np.memmap(self.path, dtype=self.record_dtype, mode='r',
+                         offset=self.header.header_bytes, shape=(count,))
+
+    def refresh(self) -> int:
+        """Re-map the file to pick up records appended since opening. Returns the record count."""
+        self.records = self._map()
+        return len(self.records)
+
+    def __len__(self) -> int:
+        return len(self.records)
+
+    @property
+    def times(self) -> np.ndarray:
+        return self.records['time']
+
+    @property
+    def idx(self) -> np.ndarray:
+        return np.array(self.header.idx, dtype=int)
+
+    @property
+    def x(self) -> np.ndarray:
+        h = self.header
+        if h.grid_stretch > 0:
+            # Same tanh mapping as cfdGridMap (source/cfd_grid.c)
+            xi = self.idx / (h.nx - 1)
+            return h.grid_length * (1.0 - np.tanh(h.grid_stretch * (1.0 - xi)) / np.tanh(h.grid_stretch))
+        return self.idx * h.dx
+
+    def piston(self, name: str) -> np.ndarray:
+        if name not in PISTON:
+            raise ValueError(f"piston quantity must be one of {PISTON}")
+        return self.records['piston_' + name]
+
+    def field(self, name: str) -> np.ndarray:
+        if name not in FIELDS:
+            raise ValueError(f"field must be one of {FIELDS}")
+        return self.records['probe'][:, :, FIELDS.index(name)]
+
+    def column(self, grid_index: int) -> Optional[int]:
+        """Column of the probe at grid_index, or None if there is no probe there."""
+        hits = np.nonzero(self.idx == grid_index)[0]
+        return int(hits[0]) if len(hits) else None
+
+    def series(self, grid_index: int, name: str) -> np.ndarray:
+        col = self.column(grid_index)
+        if col is None:
+            raise ValueError(f"no probe at grid index {grid_index} (probes: {list(self.header.idx)})")
+        return self.field(name)[:, col]
+
+
+def find_probe_file(build_dir: str) -> Optional[str]:
+    """Return build_dir/probes.bin if present, else None."""
+    path = os.path.join(build_dir, DEFAULT_NAME)
+    return path if os.path.isfile(path) else None
+
+
+def main():
+    if len(sys.argv) != 2:
+        raise SystemExit("usage: cfd_probes.py <probes.bin>")
+    probes = ProbeFile(sys.argv[1])
+    h = probes.header
+    print(f"NX={h.nx} probes={list(h.idx)} every={h.every} step(s) DX={h.dx} DT={h.dt}")
+    print(f"records={len(probes)}", end='')
+    if len(probes):
+        print(f" t=[{probes.times[0]:.6f}, {probes.times[-1]:.6f}]"
+              f" piston disp={probes.piston('disp')[-1]:.6f} m vel={probes.piston('vel')[-1]:.6f} m/s")
+    else:
+        print()
+
+
+if __name__ == '__main__':
+    main()
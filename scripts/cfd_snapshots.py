@@ -0,0 +1,337 @@
+#!/usr/bin/env python3
+"""
+cfd_snapshots.py
+
+Zero-parse reader for the binary snapshot container written by main.c
+(build/snapshots.bin, see include/cfd_output.h for the layout).
+
+File layout (native little-endian):
+  header:  magic "CFDSNAP1", u32 version, u32 header_bytes,
+           i64 nx, i64 npoints, i64 idx_start, i64 idx_stride,
+           f64 dx, f64 dt, u32 sampling (version >= 2), u32 reserved,
+           f64 grid_stretch, f64 grid_length (version >= 3),
+           i64 idx_end (version >= 4; end of the sampled window, nx before)
+  frames:  f64 time, f64 rho[npoints], f64 vel[npoints], f64 pres[npoints]
+
+sampling 0 (point): sample k sits at grid index idx_start + k*idx_stride.
+sampling 1 (min/max): each idx_stride-wide bucket stores its min and max in
+order of occurrence; sample k is placed at the start (even k) or end (odd k)
+of bucket k//2, the last bucket ending at idx_end - 1. Each field is
+reduced independently.
+
+Grid index i sits at x = i*dx. When grid_stretch > 0 the grid is clustered
+at the piston (include/cfd_grid.h): x = grid_length * grid_map(i/(nx-1), grid_stretch).
+
+The frames are exposed through numpy.memmap, so opening a file costs only
+the header read; field arrays are views into the mapped file.
+
+Compressed container (build/snapshots.cfz, `sim --output-format compressed`):
+  header:  as above with magic "CFDSNAPZ"
+  frames:  u64 frame_bytes, f64 time, then for rho, vel, pres:
+           f64 quantum, u32 predictor, u32 reserved, u64 bytes, data[bytes]
+Each field is a vector of u64 keys (quantum > 0: round(x/quantum) as int64;
+quantum == 0: an order-preserving map of the IEEE bits) coded as a Lorenzo
+residual (predictor 1: change since the previous frame minus the change of
+the left neighbour; predictor 0: difference of neighbouring keys), zigzag
+mapped and split into 8 byte planes, each stored as zero, sparse (bitmap +
+nonzero bytes) or raw (see include/cfd_codec.h). CompressedSnapshotFile
+decodes the frames with a handful of vectorized numpy passes per plane and
+exposes the same `frames` array as SnapshotFile; refresh() only decodes the
+frames appended since the last call.
+
+Usage examples:
+  from cfd_snapshots import SnapshotFile
+  snaps = SnapshotFile('build/snapshots.bin')
+  snaps.times          # (nframes,)
+  snaps.field('pres')  # (nframes, npoints) view
+  snaps.x              # sample positions in meters
+
+  snaps = open_snapshots('build/snapshots.cfz')   # either container by magic
+
+  python scripts/cfd_snapshots.py build/snapshots.bin   # print a summary
+"""
+from __future__ import annotations
+
+import os
+import struct
+import sys
+from dataclasses import dataclass
+from typing import Optional
+
+import numpy as np
+
+MAGIC = b'CFDSNAP1'
+MAGIC_Z = b'CFDSNAPZ'
+HEADER_FORMAT = '<8sIIqqqqdd'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+HEADER_V2_EXTRA = '<II'
+HEADER_V3_EXTRA = '<dd'
+HEADER_V4_EXTRA = '<q'
+SAMPLE_POINT = 0
+SAMPLE_MINMAX = 1
+DEFAULT_NAME = 'snapshots.bin'
+DEFAULT_Z_NAME = 'snapshots.cfz'
+FIELDS = ('rho', 'vel', 'pres')
+
+
+@dataclass
+class SnapshotHeader:
+    version: int
+    header_bytes: int
+    nx: int
+    npoints: int
+    idx_start: int
+    idx_stride: int
+    dx: float
+    dt: float
+    sampling: int = SAMPLE_POINT
+    grid_stretch: float = 0.0
+    grid_length: float = 0.0
+    compressed: bool = False
+    idx_end: int = 0  # end of the sampled window (exclusive); nx for version < 4
+
+
+def grid_map(xi: np.ndarray, stretch: float) -> np.ndarray:
+    """x/L of the stretched grid at xi in [0, 1] (cfdGridMap in source/cfd_grid.c)."""
+    if stretch <= 0:
+        return xi
+    return 1.0 - np.tanh(stretch * (1.0 - xi)) / np.tanh(stretch)
+
+
+HEADER_MAX_SIZE = (HEADER_SIZE + struct.calcsize(HEADER_V2_EXTRA) + struct.calcsize(HEADER_V3_EXTRA)
+                   + struct.calcsize(HEADER_V4_EXTRA))
+
+
+def parse_header(raw: bytes, path: str) -> SnapshotHeader:
+    """Parse a snapshot header from the first HEADER_MAX_SIZE bytes (path is only used in messages)."""
+    if len(raw) < HEADER_SIZE:
+        raise ValueError(f"{path}: file too short for a snapshot header")
+    magic, version, header_bytes, nx, npoints, idx_start, idx_stride, dx, dt = struct.unpack(HEADER_FORMAT, raw[:HEADER_SIZE])
+    if magic not in (MAGIC, MAGIC_Z):
+        raise ValueError(f"{path}: not a CFD snapshot file (magic={magic!r})")
+    sampling = SAMPLE_POINT
+    stretch = length = 0.0
+    idx_end = nx
+    v2_end = HEADER_SIZE + struct.calcsize(HEADER_V2_EXTRA)
+    v3_end = v2_end + struct.calcsize(HEADER_V3_EXTRA)
+    if version >= 2:
+        sampling, _ = struct.unpack(HEADER_V2_EXTRA, raw[HEADER_SIZE:v2_end])
+    if version >= 3:
+        stretch, length = struct.unpack(HEADER_V3_EXTRA, raw[v2_end:v3_end])
+    if version >= 4:
+        idx_end, = struct.unpack(HEADER_V4_EXTRA, raw[v3_end:HEADER_MAX_SIZE])
+    return SnapshotHeader(version, header_bytes, nx, npoints, idx_start, idx_stride, dx, dt, sampling, stretch, length,
+                          magic == MAGIC_Z, idx_end)
+
+
+def read_header(path: str) -> SnapshotHeader:
+    with open(path, 'rb') as f:
+        return parse_header(f.read(HEADER_MAX_SIZE), path)
+
+
+def sample_idx(h: SnapshotHeader) -> np.ndarray:
+    """Grid index of every sample described by the header."""
+    k = np.arange(h.npoints, dtype=int)
+    if h.sampling == SAMPLE_MINMAX:
+        begin = h.idx_start + (k // 2) * h.idx_stride
+        last = np.minimum(begin + h.idx_stride - 1, h.idx_end - 1)
+        return np.where(k % 2 == 0, begin, last)
+    return h.idx_start + h.idx_stride * k
+
+
+def sample_x(h: SnapshotHeader) -> np.ndarray:
+    """Position (m) of every sample described by the header."""
+    idx = sample_idx(h)
+    if h.grid_stretch > 0:
+        return h.grid_length * grid_map(idx / (h.nx - 1), h.grid_stretch)
+    return idx * h.dx
+
+
+class SnapshotFile:
+    """Memory-mapped view over all complete frames of a snapshot container."""
+
+    def __init__(self, path: str):
+        self.path = path
+        self.header = read_header(path)
+        if self.header.compressed and type(self) is SnapshotFile:
+            raise ValueError(f"{path}: compressed container, open it with CompressedSnapshotFile")
+        n = self.header.npoints
+        self.frame_dtype = np.dtype([('time', '<f8'), ('rho', '<f8', (n,)),
+                                     ('vel', '<f8', (n,)), ('pres', '<f8', (n,))])
+        self.frames = self._map()
+
+    def _map(self) -> np.ndarray:
+        size = os.path.getsize(self.path) - self.header.header_bytes
+        count = max(0, size // self.frame_dtype.itemsize)
+        if count == 0:
+            return np.zeros(0, dtype=self.frame_dtype)
+        # Only map complete frames; a frame still being written is ignored
+        return np.memmap(self.path, dtype=self.frame_dtype, mode='r',
+                         offset=self.header.header_bytes, shape=(count,))
+
+    def refresh(self) -> int:
+        """Re-map the file to pick up frames appended since opening. Returns the frame count."""
+        self.frames = self._map()
+        return len(self.frames)
+
+    def __len__(self) -> int:
+        return len(self.frames)
+
+    @property
+    def times(self) -> np.ndarray:
+        return self.frames['time']
+
+    @property
+    def idx(self) -> np.ndarray:
+        return sample_idx(self.header)
+
+    @property
+    def x(self) -> np.ndarray:
+        return sample_x(self.header)
+
+    def field(self, name: str) -> np.ndarray:
+        if name not in FIELDS:
+            raise ValueError(f"field must be one of {FIELDS}")
+        return self.frames[name]
+
+
+Z_FRAME_HEADER = struct.Struct('<Qd')
+Z_FIELD_HEADER = struct.Struct('<dIIQ')
+PREDICT_TEMPORAL = 1
+PLANE_ZERO, PLANE_SPARSE, PLANE_RAW = 0, 1, 2
+SIGN_BIT = np.uint64(1 << 63)
+
+
+def decode_keys(buf: bytes, offset: int, size: int, n: int, prev: Optional[np.ndarray]) -> np.ndarray:
+    """Decode n u64 keys from buf[offset:offset+size] (cfdCodecDecode in source/cfd_codec.c)."""
+    z = np.zeros(n, dtype=np.uint64)
+    p, end = offset, offset + size
+    bitmap = (n + 7) // 8
+    for k in range(8):
+        if p >= end:
+            raise ValueError("truncated field data")
+        mode = buf[p]
+        p += 1
+        if mode == PLANE_ZERO:
+            continue
+        if mode == PLANE_RAW:
+            plane = np.frombuffer(buf, dtype=np.uint8, count=n, offset=p)
+            p += n
+        elif mode == PLANE_SPARSE:
+            mask = np.unpackbits(np.frombuffer(buf, dtype=np.uint8, count=bitmap, offset=p),
+                                 bitorder='little')[:n].astype(bool)
+            p += bitmap
+            nnz = int(np.count_nonzero(mask))
+            plane = np.zeros(n, dtype=np.uint8)
+            plane[mask] = np.frombuffer(buf, dtype=np.uint8, count=nnz, offset=p)
+            p += nnz
+        else:
+            raise ValueError(f"unknown plane mode {mode}")
+        z |= plane.astype(np.uint64) << np.uint64(8 * k)
+    if p != end:
+        raise ValueError("field data size mismatch")
+    # Inverse zigzag, then the running sum along x (uint64 arithmetic wraps like the C code)
+    r = (z >> np.uint64(1)) ^ (np.uint64(0) - (z & np.uint64(1)))
+    key = np.cumsum(r, dtype=np.uint64)
+    if prev is not None:
+        key += prev
+    return key
+
+
+def key_values(key: np.ndarray, quantum: float) -> np.ndarray:
+    """Field values from decoded keys (cfdCodecValues in source/cfd_codec.c)."""
+    if quantum > 0:
+        return key.view(np.int64).astype(np.float64) * quantum
+    bits = np.where(key & SIGN_BIT, key ^ SIGN_BIT, ~key)
+    return bits.view(np.float64)
+
+
+class CompressedSnapshotFile(SnapshotFile):
+    """Decoded frames of a compressed container; same interface as SnapshotFile."""
+
+    def __init__(self, path: str):
+        self._offset = 0
+        self._keys: list = [None, None, None]
+        self._decoded: list = []
+        self._frames: Optional[np.ndarray] = None
+        super().__init__(path)
+        if not self.header.compressed:
+            raise ValueError(f"{path}: not a compressed snapshot container")
+
+    def _map(self) -> np.ndarray:
+        h = self.header
+        n = h.npoints
+        with open(self.path, 'rb') as f:
+            if self._offset == 0:
+                self._offset = h.header_bytes
+            f.seek(self._offset)
+            buf = f.read()
+        p = 0
+        new = []
+        while p + Z_FRAME_HEADER.size <= len(buf):
+            frame_bytes, t = Z_FRAME_HEADER.unpack_from(buf, p)
+            # A frame still being written is ignored until the next refresh
+            if p + frame_bytes > len(buf):
+                break
+            rec = np.zeros(1, dtype=self.frame_dtype)
+            rec['time'] = t
+            q = p + Z_FRAME_HEADER.size
+            for f_idx, name in enumerate(FIELDS):
+                quantum, predictor, _, size = Z_FIELD_HEADER.unpack_from(buf, q)
+                q += Z_FIELD_HEADER.size
+                prev = self._keys[f_idx] if predictor == PREDICT_TEMPORAL else None
+                if predictor == PREDICT_TEMPORAL and prev is None:
+                    raise ValueError(f"{self.path}: temporal frame without a preceding keyframe")
+                key = decode_keys(buf, q, size, n, prev)
+                q += size
+                self._keys[f_idx] = key
+                rec[name][0] = key_values(key, quantum)
+            if q != p + frame_bytes:
+                raise ValueError(f"{self.path}: frame size mismatch at offset {self._offset + p}")
+            new.append(rec)
+            p += frame_bytes
+        self._offset += p
+        if new or self._frames is None:
+            self._decoded.extend(new)
+            self._frames = (np.concatenate(self._decoded) if self._decoded
+                            else np.zeros(0, dtype=self.frame_dtype))
+        return self._frames
+
+
+def open_snapshots(path: str) -> SnapshotFile:
+    """Open either container, choosing the reader by the magic in the header."""
+    if read_header(path).compressed:
+        return CompressedSnapshotFile(path)
+    return SnapshotFile(path)
+
+
+def find_snapshot_file(build_dir: str) -> Optional[str]:
+    """Return build_dir/snapshots.bin, else build_dir/snapshots.cfz if present, else None."""
+    for name in (DEFAULT_NAME, DEFAULT_Z_NAME):
+        path = os.path.join(build_dir, name)
+        if os.path.isfile(path):
+            return path
+    return None
+
+
+def main():
+    if len(sys.argv) != 2:
+        raise SystemExit("usage: cfd_snapshots.py <snapshots.bin|snapshots.cfz>")
+    snaps = open_snapshots(sys.argv[1])
+    h = snaps.header
+    mode = 'minmax' if h.sampling == SAMPLE_MINMAX else 'point'
+    if h.compressed:
+        print(f"compressed: {os.path.getsize(snaps.path)} bytes for "
+              f"{len(snaps) * snaps.frame_dtype.itemsize} uncompressed")
+    print(f"NX={h.nx} npoints={h.npoints} idx={h.idx_start}:{h.idx_end}:{h.idx_stride} ({mode}) DX={h.dx} DT={h.dt}")
+    if h.grid_stretch > 0:
+        print(f"stretched grid: beta={h.grid_stretch} length={h.grid_length} m")
+    print(f"frames={len(snaps)}", end='')
+    if len(snaps):
+        print(f" t=[{snaps.times[0]:.6f}, {snaps.times[-1]:.6f}]")
+    else:
+        print()
+
+
+if __name__ == '__main__':
+    main()
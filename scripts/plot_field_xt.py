@@ -2,8 +2,10 @@
 """
 plot_field_xt.py
 
-从 build/ 目录下的所有快照 CSV（snapshot_*.csv）中读取流场数据，
-绘制流速 vel、密度 rho、压强 pres 随时间 t 和位置 x 的分布曲面。
+从 build/ 目录下的二进制快照文件（snapshots.bin，优先）或所有快照 CSV（snapshot_*.csv）
+中读取流场数据，绘制流速 vel、密度 rho、压强 pres 随时间 t 和位置 x 的分布曲面。
+二进制文件通过 numpy.memmap 直接映射（见 cfd_snapshots.py），采样点的位置取自文件头（拉伸网格时不均匀）；
+没有 snapshots.bin 时读取压缩快照 snapshots.cfz（载入时解码）。
 
 每个 CSV 的列格式为：time,idx,rho,vel,pres
 - time: 当前快照时刻（对文件内所有行相同）
@@ -14,7 +16,7 @@ plot_field_xt.py
 1. 扫描 build/ 下所有 snapshot_*.csv，按 time 排序
 2. 构建二维数组：
    - t 轴：所有快照时刻
-   - x 轴：通过 idx * DX（从 include/constants.h 中读取）得到
+   - x 轴：通过 idx * DX（从 include/constants.h 中读取）得到；CSV 不记录网格，拉伸网格请用二进制文件
    - 每个物理量形成一个 (nt, nx) 的二维矩阵
 3. 使用 imshow 绘制三个 x-t 色彩图（rho/vel/pres），可选插值和保存
 
@@ -38,6 +40,8 @@ import numpy as np
 import matplotlib.pyplot as plt
 from mpl_toolkits.mplot3d import Axes3D  # noqa: F401  # 激活 3D 投影
 
+from cfd_snapshots import find_snapshot_file, open_snapshots
+
 ROOT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
 DEFAULT_BUILD_DIR = os.path.join(ROOT_DIR, 'build')
 DEFAULT_CONSTANTS = os.path.join(ROOT_DIR, 'include', 'constants.h')
@@ -148,12 +152,10 @@ def build_xt_field(build_dir: str, field: str, NX: int) -> Tuple[np.ndarray, np.
     return times, x_idx, F
 
 
-def plot_xt_heatmap(times: np.ndarray, x_idx: np.ndarray, F: np.ndarray, field: str, DX: float,
+def plot_xt_heatmap(times: np.ndarray, x: np.ndarray, F: np.ndarray, field: str,
                      save: Optional[str] = None, show: bool = True,
-                     interpolate: bool = False) -> None:
-    """绘制 x-t 色彩图（将值视为 z 维度）。"""
-    # 转为物理坐标
-    x = x_idx * DX
+                     interpolate: bool = False, stretched: bool = False) -> None:
+    """绘制 x-t 色彩图（将值视为 z 维度）。x 为采样点的物理坐标，stretched 时间距不均匀。"""
     T_min, T_max = float(times.min()), float(times.max())
 
     # 构造网格
@@ -170,7 +172,10 @@ def plot_xt_heatmap(times: np.ndarray, x_idx: np.ndarray, F: np.ndarray, field:
 
     fig, ax = plt.subplots(figsize=(8, 5))
     # 注意 imshow 默认 y 轴向下，这里 origin='lower' 让时间向上增长
-    if interpolate:
+    if stretched:
+        # imshow 按等间距排列各列，拉伸网格改用 pcolormesh 放到实际位置
+        im = ax.pcolormesh(x, times, F, cmap='viridis', shading='gouraud' if interpolate else 'nearest')
+    elif interpolate:
         # 使用双线性插值（默认）
         im = ax.imshow(F, aspect='auto', origin='lower', extent=extent, cmap='viridis')
     else:
@@ -193,11 +198,9 @@ def plot_xt_heatmap(times: np.ndarray, x_idx: np.ndarray, F: np.ndarray, field:
     else:
         plt.close(fig)
 
-def plot_xt_surface3d(times: np.ndarray, x_idx: np.ndarray, F: np.ndarray, field: str, DX: float,
+def plot_xt_surface3d(times: np.ndarray, x: np.ndarray, F: np.ndarray, field: str,
                       save: Optional[str] = None, show: bool = True) -> None:
-    """绘制真正的 3D 曲面：横轴 x，纵轴 time，高度为 field 值。"""
-    # 物理坐标
-    x = x_idx * DX
+    """绘制真正的 3D 曲面：横轴 x（采样点的物理坐标），纵轴 time，高度为 field 值。"""
     t = times
 
     # 构造网格：F 形状是 (nt, nx)，所以用 ij 索引保证对齐
@@ -255,6 +258,8 @@ def parse_args():
                    help='Do not show window (useful on servers or when saving only)')
     p.add_argument('--interpolate', action='store_true',
                    help='Use bilinear interpolation for smoother 2D heatmap (ignored for 3D surface)')
+    p.add_argument('--csv', action='store_true',
+                   help='Read snapshot CSVs even if build/snapshots.bin exists')
     p.add_argument('--mode', type=str, choices=['heatmap', 'surface'], default='surface',
                    help="Visualization mode: 'heatmap' for 2D x-t colormap, 'surface' for 3D surface (default).")
     return p.parse_args()
@@ -262,24 +267,33 @@ def parse_args():
 
 def main():
     args = parse_args()
-    NX, DX = parse_constants(args.constants)
-    times, x_idx, F = build_xt_field(args.build_dir, args.field, NX)
+    bin_path = None if args.csv else find_snapshot_file(args.build_dir)
+    if bin_path:
+        snaps = open_snapshots(bin_path)
+        if len(snaps) == 0:
+            raise SystemExit(f"No complete frames in {bin_path}")
+        # 拉伸网格与 min/max 采样的位置都由文件头给出（cfd_snapshots.sample_x）
+        times, x, F = snaps.times, snaps.x, snaps.field(args.field)
+        stretched = snaps.header.grid_stretch > 0
+    else:
+        NX, DX = parse_constants(args.constants)
+        times, x_idx, F = build_xt_field(args.build_dir, args.field, NX)
+        x, stretched = x_idx * DX, False
 
     if args.mode == 'heatmap':
         # 2D 色彩图
-        plot_xt_heatmap(times, x_idx, F,
+        plot_xt_heatmap(times, x, F,
                         field=args.field,
-                        DX=DX,
                         save=args.save,
                         show=not args.no_show,
-                        interpolate=args.interpolate)
+                        interpolate=args.interpolate,
+                        stretched=stretched)
     else:
         # 3D 曲面
         if args.interpolate:
             print("[WARN] --interpolate is ignored in 3D surface mode.")
-        plot_xt_surface3d(times, x_idx, F,
+        plot_xt_surface3d(times, x, F,
                           field=args.field,
-                          DX=DX,
                           save=args.save,
                           show=not args.no_show)
 
@@ -2,9 +2,13 @@
 """
 plot_pres0.py
 
-Plot pres[0] vs time using all snapshot CSVs under build/.
-Each CSV produced by main.c has columns: time,idx,rho,vel,pres.
-We extract the row with idx==0 from each file and collect (time, pres).
+Plot pres[0] vs time using the output under build/.
+If build/probes.bin exists and has a probe at idx 0 (e.g. `sim --probes 0`),
+its per-step time series is used (see cfd_probes.py). Otherwise, if
+build/snapshots.bin (or the compressed build/snapshots.cfz) exists, pres[0] is
+read as one column of the frames (see cfd_snapshots.py), one sample per TIMER. Failing both, each CSV
+produced by main.c (columns: time,idx,rho,vel,pres) is scanned for the row
+with idx==0.
 
 Usage examples:
   python scripts/plot_pres0.py
@@ -24,6 +28,9 @@ from typing import List, Tuple, Optional
 import numpy as np
 import matplotlib.pyplot as plt
 
+from cfd_snapshots import find_snapshot_file, open_snapshots
+from cfd_probes import ProbeFile, find_probe_file
+
 DEFAULT_BUILD_DIR = os.path.join(os.path.dirname(os.path.dirname(os.path.abspath(__file__))), 'build')
 
 
@@ -51,6 +58,20 @@ def read_pres0_from_csv(path: str) -> Optional[Tuple[float, float]]:
     return None
 
 
+def collect_series_binary(path: str) -> Tuple[np.ndarray, np.ndarray]:
+    snaps = open_snapshots(path)
+    if snaps.header.idx_start != 0 or len(snaps) == 0:
+        raise SystemExit(f"No pres[0] data found in {path}.")
+    return np.array(snaps.times), np.array(snaps.field('pres')[:, 0])
+
+
+def collect_series_probes(path: str) -> Optional[Tuple[np.ndarray, np.ndarray]]:
+    probes = ProbeFile(path)
+    if probes.column(0) is None or len(probes) == 0:
+        return None
+    return np.array(probes.times), np.array(probes.series(0, 'pres'))
+
+
 def collect_series(build_dir: str) -> Tuple[np.ndarray, np.ndarray]:
     ts: List[float] = []
     ps: List[float] = []
@@ -73,7 +94,9 @@ def collect_series(build_dir: str) -> Tuple[np.ndarray, np.ndarray]:
 def plot_series(t: np.ndarray, p: np.ndarray, save: Optional[str] = None, show: bool = True,
                 title: Optional[str] = None, ylim_min: Optional[float] = None, ylim_max: Optional[float] = None) -> None:
     fig, ax = plt.subplots(figsize=(9, 4))
-    ax.plot(t, p, marker='o', markersize=2, linewidth=1.2, color='C3', label='pres[0]')
+    # Per-step probe series have far too many points for markers
+    marker = 'o' if len(t) <= 2000 else None
+    ax.plot(t, p, marker=marker, markersize=2, linewidth=1.2, color='C3', label='pres[0]')
     ax.set_xlabel('time (s)')
     ax.set_ylabel('pressure at x=0 (Pa)')
     if title:
@@ -97,19 +120,29 @@ def plot_series(t: np.ndarray, p: np.ndarray, save: Optional[str] = None, show:
 
 
 def parse_args():
-    p = argparse.ArgumentParser(description='Plot pres[0] vs time from snapshot CSVs under build/.')
+    p = argparse.ArgumentParser(description='Plot pres[0] vs time from the probe or snapshot files under build/.')
     p.add_argument('--build-dir', type=str, default=DEFAULT_BUILD_DIR, help='Directory containing snapshot CSVs (default: ./build)')
     p.add_argument('--save', type=str, default=None, help='Path to save the figure (PNG)')
     p.add_argument('--no-show', action='store_true', help='Do not display the window (use with --save)')
     p.add_argument('--title', type=str, default=None, help='Custom plot title')
     p.add_argument('--ylim-min', type=float, default=None, help='Lower limit for y-axis')
+    p.add_argument('--csv', action='store_true', help='Read snapshot CSVs even if snapshots.bin or probes.bin exists')
+    p.add_argument('--snapshots', action='store_true', help='Read snapshots.bin even if probes.bin exists')
     p.add_argument('--ylim-max', type=float, default=None, help='Upper limit for y-axis')
     return p.parse_args()
 
 
 def main():
     args = parse_args()
-    t, p0 = collect_series(args.build_dir)
+    probe_path = None if args.csv or args.snapshots else find_probe_file(args.build_dir)
+    series = collect_series_probes(probe_path) if probe_path else None
+    bin_path = None if args.csv or series else find_snapshot_file(args.build_dir)
+    if series:
+        t, p0 = series
+    elif bin_path:
+        t, p0 = collect_series_binary(bin_path)
+    else:
+        t, p0 = collect_series(args.build_dir)
     plot_series(t, p0, save=args.save, show=not args.no_show, title=args.title,
                 ylim_min=args.ylim_min, ylim_max=args.ylim_max)
 
@@ -0,0 +1,177 @@
+/*
+    source/cfd_active.c
+    活动区跟踪：均匀段的识别、代表值的推进与段两端的逐位比较
+*/
+#include "cfd_active.h"
+#include "cfd_stencil.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CFD_ACTIVE_MIN_CELLS 2      // 均匀段短于这么多点时结束跟踪
+
+/* 逐位比较（区分 +0 与 -0），保证段内各点此后的推进与代表值完全相同 */
+static inline i32 sameBits(f64 a, f64 b)
+{
+    return memcmp(&a, &b, sizeof(f64)) == 0;
+}
+
+/* 与点 j 的状态逐位相同：当前 rho/vel，以及下一步会读到的 pres（存储压力）或 rho_next（导出压力） */
+static i32 sameCell(const CfdSolver *s, i32 i, i32 j)
+{
+    if (!sameBits(s->rho[i], s->rho[j]) || !sameBits(s->vel[i], s->vel[j])) return 0;
+    if (s->derived_pressure) return sameBits(s->rho_next[i], s->rho_next[j]);
+    return sameBits(s->pres[i], s->pres[j]);
+}
+
+/* 把均匀段与 [lo, hi) 的交集按代表值写入数组 */
+static void fillRange(CfdSolver *s, const CfdActive *u, i32 lo, i32 hi)
+{
+    if (lo < u->lo) lo = u->lo;
+    if (hi > u->hi) hi = u->hi;
+    for (i32 i = lo; i < hi; i++)
+    {
+        s->rho[i] = u->rho;
+        s->vel[i] = u->vel;
+        if (s->derived_pressure) s->rho_next[i] = u->rho_prev;
+        else s->pres[i] = u->pres;
+    }
+}
+
+void cfdActiveStart(CfdSolver *s)
+{
+    free(s->active);
+    s->active = NULL;
+    const i32 nx = s->nx;
+    i32 lo = nx - 1;
+    while (lo > 1 && sameCell(s, lo - 1, nx - 1)) lo--;
+    if (nx - lo < CFD_ACTIVE_MIN_CELLS)
+    {
+        printf("[INFO] Active-region tracking: no quiescent cells left; updating every cell\n");
+        return;
+    }
+    CfdActive *u = (CfdActive *)malloc(sizeof(CfdActive));
+    if (!u)
+    {
+        printf("[WARN] Memory allocation failed for active-region tracking; updating every cell\n");
+        return;
+    }
+    u->lo = lo;
+    u->hi = nx;
+    u->rho = s->rho[nx - 1];
+    u->vel = s->vel[nx - 1];
+    u->pres = s->derived_pressure ? 0.0 : s->pres[nx - 1];
+    u->rho_prev = s->derived_pressure ? s->rho_next[nx - 1] : u->rho;
+    s->active = u;
+    printf("[INFO] Active-region tracking: cells [%d, %d) are quiescent\n", lo, nx);
+}
+
+void cfdActiveStop(CfdSolver *s)
+{
+    if (!s->active) return;
+    fillRange(s, s->active, 0, s->nx);
+    free(s->active);
+    s->active = NULL;
+}
+
+i32 cfdActiveStep(CfdSolver *s, f64 acc)
+{
+    CfdActive *u = s->active;
+    const i32 nx = s->nx;
+    i32 lo = u->lo, hi = u->hi;
+    if (hi - lo < CFD_ACTIVE_MIN_CELLS)
+    {
+        /* 两侧的扰动已经相遇：写回剩下的点，这一步起更新全部网格 */
+        cfdActiveStop(s);
+        u = NULL;
+        lo = hi = 1;
+    }
+    else
+    {
+        /* 段两端各两个点会被逐点更新的模板（以及右边界）读到 */
+        fillRange(s, u, lo, lo + 2);
+        fillRange(s, u, hi - 2, hi);
+    }
+
+    /* 逐点更新：左段 [0, lo]，右段 [hi - 1, nx)；两段相接时即全部网格 */
+    const i32 left = lo + 1 < nx - 1 ? lo + 1 : nx - 1;
+    const i32 right = hi - 1 > lo + 1 ? hi - 1 : lo + 1;
+    updateBorders(s, acc);
+    updateFlowFieldRange(s, acc, 1, left);
+    updateFlowFieldRange(s, acc, right < nx - 1 ? right : nx - 1, nx - 1);
+    if (!s->derived_pressure)
+    {
+        updatePressureRange(s, 0, lo + 1);
+        updatePressureRange(s, right, nx);
+    }
+    const i32 updated = (lo + 1) + (nx - right);
+    if (!u) return nx;
+
+    /* 代表值用与段内各点相同的核推进（拉伸网格取 lo 点的系数） */
+    f64 r3[3] = {u->rho, u->rho, u->rho}, v3[3] = {u->vel, u->vel, u->vel};
+    f64 nr3[3], nv3[3];
+    if (s->grid)
+    {
+        const CfdGrid *g = s->grid;
+        const i32 o = lo - 1;
+        fusedPointStretched(r3, v3, nr3, nv3, g->d1 + o, g->d1s + o, g->d2 + o, g->d2s + o,
+                            s->dt, s->half_dt2, acc, 1);
+    }
+    else
+    {
+        const f64 inv_2dx = 1.0 / (2 * s->dx);
+        const f64 inv_dx2 = 1.0 / (s->dx * s->dx);
+        fusedPoint(r3, v3, nr3, nv3, s->dt, s->half_dt2, inv_2dx, inv_dx2, acc, 1);
+    }
+
+    /* 段内各点的新值即代表值，看门狗只需多检查这一个点 */
+    if (s->watch.enabled)
+    {
+        watchPoint(nr3[1], nv3[1], &s->watch.sums.vmax, &s->watch.sums.rmin, &s->watch.sums.bad);
+    }
+
+    /* 模板半径为 1，只有段两端的点可能与代表值不同（右端为 nx - 1 时即右边界） */
+    if (!sameBits(s->rho_next[lo], nr3[1]) || !sameBits(s->vel_next[lo], nv3[1])) lo++;
+    if (lo < hi && (!sameBits(s->rho_next[hi - 1], nr3[1]) || !sameBits(s->vel_next[hi - 1], nv3[1]))) hi--;
+
+    u->lo = lo;
+    u->hi = hi;
+    u->pres = R / MU_STAR * u->rho * T_INIT;
+    u->rho_prev = u->rho;
+    u->rho = nr3[1];
+    u->vel = nv3[1];
+    return updated;
+}
+
+void cfdActiveFill(CfdSolver *s)
+{
+    if (s->active) fillRange(s, s->active, 0, s->nx);
+}
+
+i32 cfdActivePoint(const CfdSolver *s, i32 i, f64 *out)
+{
+    const CfdActive *u = s->active;
+    if (!u || i < u->lo || i >= u->hi) return 0;
+    out[0] = u->rho;
+    out[1] = u->vel;
+    out[2] = s->derived_pressure ? cfdEosPressure(&s->eos, u->rho_prev) : u->pres;
+    return 1;
+}
+
+f64 cfdActiveMaxSpeed(const CfdSolver *s)
+{
+    const CfdActive *u = s->active;
+    const f64 *vel = s->vel;
+    const i32 lo = u->lo, hi = u->hi, nx = s->nx;
+    f64 vmax = fabs(u->vel);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(max:vmax)
+#endif
+    for (int i = 0; i < nx - (hi - lo); i++)
+    {
+        f64 v = fabs(vel[i < lo ? i : i + (hi - lo)]);
+        if (v > vmax) vmax = v;
+    }
+    return vmax;
+}
@@ -0,0 +1,187 @@
+/*
+    source/cfd_api.c
+    求解器库的 C 接口：句柄持有一组参数与一个求解器，各函数只是对 CfdSolver 的薄封装
+*/
+#include "cfd_api.h"
+#include "cfd_util.h"
+#include "cfd_config.h"
+#include "cfd_offload.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* cfdLibStatus 直接返回看门狗的原因码，接口文档中的取值与 CFD_WATCH_* 必须一致 */
+#if CFD_WATCH_OK != 0 || CFD_WATCH_NONFINITE != 1 || CFD_WATCH_DENSITY != 2 || CFD_WATCH_CFL != 3
+#error "cfdLibStatus codes in cfd_api.h no longer match CFD_WATCH_*"
+#endif
+
+struct CfdHandle {
+    CfdConfig cfg;
+    CfdSolver *s;
+    f64 *x;                         // 网格点坐标，均匀网格时按 i * dx 填充，拉伸网格时为 NULL（用 grid->x）
+    i32 scan_every;                 // 核内不归约的路径隔多少步扫描一次，与 sim 相同；0 表示不扫描
+    i64 last_scan;                  // 上一次扫描时的步数
+};
+
+/* 主程序管理的功能，库里不做；设置了就提示一次，免得调用方以为它们生效了 */
+static void warnDriverOptions(const CfdConfig *cfg)
+{
+    if (cfg->cfl > 0)
+        printf("[WARN] libcfd advances with the fixed dt; cfl is ignored (call cfdLibStep with your own step counts).\n");
+    if (cfg->temporal_depth > 0)
+        printf("[WARN] libcfd does not use temporal blocking; advancing step by step.\n");
+    if (cfg->restart || cfg->ensemble[0] != '\0' || cfg->sweep[0] != '\0' || cfg->live[0] != '\0')
+        printf("[WARN] libcfd ignores restart, ensemble, sweep and live; they belong to the sim driver.\n");
+}
+
+int cfdLibVersion(void)
+{
+    return CFD_API_VERSION;
+}
+
+int cfdLibHarmonics(void)
+{
+    return PISTON_HARMONICS;
+}
+
+CfdHandle *cfdLibCreate(const char *options)
+{
+    CfdHandle *h = (CfdHandle *)calloc(1, sizeof(CfdHandle));
+    if (!h)
+    {
+        printf("[ERROR] Memory allocation failed while creating solver\n");
+        return NULL;
+    }
+    cfdConfigDefaults(&h->cfg);
+    if ((options && cfdConfigSetString(&h->cfg, options) != 0) || cfdConfigValidate(&h->cfg) != 0)
+    {
+        free(h);
+        return NULL;
+    }
+    warnDriverOptions(&h->cfg);
+    h->scan_every = h->cfg.nan_check > 0 ? h->cfg.nan_check : h->cfg.watchdog ? h->cfg.print_after_steps : 0;
+
+    h->s = cfdSolverCreate(&h->cfg);
+    if (!h->s || cfdOffloadAttach(h->s) != 0)
+    {
+        cfdSolverDestroy(h->s);
+        free(h);
+        return NULL;
+    }
+    if (!h->s->grid)
+    {
+        h->x = (f64 *)malloc(sizeof(f64) * h->s->nx);
+        if (!h->x)
+        {
+            printf("[ERROR] Memory allocation failed while creating solver\n");
+            cfdLibDestroy(h);
+            return NULL;
+        }
+        for (i32 i = 0; i < h->s->nx; i++) h->x[i] = i * h->s->dx;
+    }
+    return h;
+}
+
+void cfdLibDestroy(CfdHandle *h)
+{
+    if (!h) return;
+    cfdSolverDestroy(h->s);
+    free(h->x);
+    free(h);
+}
+
+int cfdLibSetProfile(CfdHandle *h, double period, double dc, double amplitude, const double *coef, int n)
+{
+    if (!h || !(period > 0) || !isfinite(dc) || !isfinite(amplitude) || n < 0 || n > PISTON_HARMONICS ||
+        (n > 0 && !coef))
+    {
+        printf("[ERROR] Invalid piston profile (period must be positive, at most %d harmonics)\n", PISTON_HARMONICS);
+        return -1;
+    }
+    PistonProfile p;
+    pistonProfileDefault(&p);
+    p.period = period;
+    p.dc = dc;
+    p.amplitude = amplitude;
+    if (coef)
+    {
+        for (i32 k = 0; k < PISTON_HARMONICS; k++)
+        {
+            p.coef[k][0] = k < n ? coef[2 * k] : 0.0;
+            p.coef[k][1] = k < n ? coef[2 * k + 1] : 0.0;
+        }
+    }
+    cfdSolverSetProfile(h->s, &p);
+    return 0;
+}
+
+long long cfdLibStep(CfdHandle *h, long long nsteps)
+{
+    if (!h || nsteps < 0) return -1;
+    CfdSolver *s = h->s;
+    /* 核内不归约的路径（多级格式、卸载等，第一步之前也按这种情形）分段推进，每 scan_every 步扫描一次，发散时及早停下 */
+    i64 done = 0;
+    while (done < nsteps && !s->watch.tripped)
+    {
+        i64 chunk = nsteps - done;
+        const i64 to_scan = h->scan_every - (s->step - h->last_scan);
+        if (!s->watch.fused && h->scan_every > 0 && chunk > to_scan) chunk = to_scan > 1 ? to_scan : 1;
+        if (h->cfg.persistent_region)
+        {
+            done += cfdSolverAdvance(s, chunk, INFINITY);
+        }
+        else
+        {
+            for (i64 k = 0; k < chunk && !s->watch.tripped; k++)
+            {
+                cfdSolverStep(s);
+                done++;
+            }
+        }
+        if (!s->watch.fused && h->scan_every > 0 && !s->watch.tripped && s->step - h->last_scan >= h->scan_every)
+        {
+            h->last_scan = s->step;
+            cfdSolverWatchScan(s);
+        }
+    }
+    return done;
+}
+
+int cfdLibField(CfdHandle *h, int field, const double **data)
+{
+    if (!h || !data) return -1;
+    CfdSolver *s = h->s;
+    switch (field)
+    {
+    case CFD_LIB_RHO:  cfdSolverSync(s); *data = s->rho; break;
+    case CFD_LIB_VEL:  cfdSolverSync(s); *data = s->vel; break;
+    case CFD_LIB_PRES: cfdSolverSync(s); *data = s->pres; break;
+    case CFD_LIB_X:    *data = s->grid ? s->grid->x : h->x; break;
+    default:
+        printf("[ERROR] Unknown field %d\n", field);
+        return -1;
+    }
+    return s->nx;
+}
+
+double cfdLibTime(const CfdHandle *h)
+{
+    return h->s->t;
+}
+
+long long cfdLibSteps(const CfdHandle *h)
+{
+    return h->s->step;
+}
+
+double cfdLibDt(const CfdHandle *h)
+{
+    return h->s->dt;
+}
+
+int cfdLibStatus(const CfdHandle *h, const char **reason)
+{
+    const i32 tripped = h->s->watch.tripped;
+    if (reason) *reason = tripped ? cfdWatchReason(tripped) : "";
+    return tripped;
+}
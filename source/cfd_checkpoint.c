@@ -0,0 +1,380 @@
+/*
+    source/cfd_checkpoint.c
+    检查点与断点续算：状态序列化、后台原子写出与读回校验
+*/
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "cfd_checkpoint.h"
+#include "cfd_report.h"
+#include "cfd_active.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+#define CFD_CHECKPOINT_MAX_ARRAYS 4
+
+/* 下一步真正要读的流场数组（见 cfd_checkpoint.h 中的格式说明），返回数组个数 */
+static i32 stateArrays(const CfdSolver *s, void **ptr, size_t *bytes)
+{
+    const size_t n = (size_t)s->nx;
+    i32 k = 0;
+    if (s->precision == CFD_PRECISION_MIXED)
+    {
+        ptr[k] = s->drho;       bytes[k++] = sizeof(f32) * n;
+        ptr[k] = s->vel32;      bytes[k++] = sizeof(f32) * n;
+        ptr[k] = s->drho_next;  bytes[k++] = sizeof(f32) * n;
+        if (!s->derived_pressure)
+        {
+            ptr[k] = s->dpres;  bytes[k++] = sizeof(f32) * n;
+        }
+        return k;
+    }
+    ptr[k] = s->rho;            bytes[k++] = sizeof(f64) * n;
+    ptr[k] = s->vel;            bytes[k++] = sizeof(f64) * n;
+    if (s->derived_pressure)
+    {
+        ptr[k] = s->rho_next;   bytes[k++] = sizeof(f64) * n;
+    }
+    else
+    {
+        ptr[k] = s->pres;       bytes[k++] = sizeof(f64) * n;
+    }
+    return k;
+}
+
+static size_t solverBytes(const CfdSolver *s)
+{
+    void *ptr[CFD_CHECKPOINT_MAX_ARRAYS];
+    size_t bytes[CFD_CHECKPOINT_MAX_ARRAYS];
+    size_t total = sizeof(CfdCheckpointSolver);
+    i32 n = stateArrays(s, ptr, bytes);
+    for (i32 k = 0; k < n; k++) total += bytes[k];
+    return total;
+}
+
+/* FNV-1a，按 8 字节一组散列以免逐字节处理几十 MB 的数据；尾部不足 8 字节的逐字节处理 */
+static u64 checksum(const char *data, size_t bytes)
+{
+    u64 h = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + sizeof(u64) <= bytes; i += sizeof(u64))
+    {
+        u64 w;
+        memcpy(&w, data + i, sizeof(w));
+        h = (h ^ w) * 1099511628211ULL;
+    }
+    for (; i < bytes; i++)
+    {
+        h = (h ^ (u64)(unsigned char)data[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static char *packSolver(char *dst, const CfdSolver *s)
+{
+    CfdCheckpointSolver st;
+    memset(&st, 0, sizeof(st));
+    st.dx = s->dx;
+    st.dt = s->dt;
+    st.half_dt2 = s->half_dt2;
+    st.t = s->t;
+    st.step = s->step;
+    st.profile = s->profile;
+    st.pa = s->pa;
+    st.pa.profile = NULL;
+    memcpy(dst, &st, sizeof(st));
+    dst += sizeof(st);
+
+    void *ptr[CFD_CHECKPOINT_MAX_ARRAYS];
+    size_t bytes[CFD_CHECKPOINT_MAX_ARRAYS];
+    i32 n = stateArrays(s, ptr, bytes);
+    for (i32 k = 0; k < n; k++)
+    {
+        memcpy(dst, ptr[k], bytes[k]);
+        dst += bytes[k];
+    }
+    return dst;
+}
+
+static const char *unpackSolver(const char *src, CfdSolver *s)
+{
+    CfdCheckpointSolver st;
+    memcpy(&st, src, sizeof(st));
+    src += sizeof(st);
+    s->dx = st.dx;
+    s->dt = st.dt;
+    s->half_dt2 = st.half_dt2;
+    s->t = st.t;
+    s->step = st.step;
+    s->profile = st.profile;
+    s->pa = st.pa;
+    s->pa.profile = &s->profile;
+
+    void *ptr[CFD_CHECKPOINT_MAX_ARRAYS];
+    size_t bytes[CFD_CHECKPOINT_MAX_ARRAYS];
+    i32 n = stateArrays(s, ptr, bytes);
+    for (i32 k = 0; k < n; k++)
+    {
+        memcpy(ptr[k], src, bytes[k]);
+        src += bytes[k];
+    }
+    /* vel/pres/rho 的 f64 副本（混合精度）与导出的压力场（导出压力）需要重新展开 */
+    s->synced = 0;
+    return src;
+}
+
+/* 写 tmp 文件并 fsync，成功后 rename 覆盖正式文件 */
+static i32 writeAtomically(const CfdCheckpoint *ck, const char *data, size_t bytes)
+{
+    FILE *fp = fopen(ck->tmp_path, "wb");
+    if (fp == NULL)
+    {
+        printf("[WARN] Cannot open %s for writing; checkpoint skipped.\n", ck->tmp_path);
+        return -1;
+    }
+    i32 ok = fwrite(data, 1, bytes, fp) == bytes;
+    ok = ok && fflush(fp) == 0;
+    ok = ok && fsync(fileno(fp)) == 0;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(ck->tmp_path, ck->path) != 0)
+    {
+        printf("[WARN] Failed to write checkpoint %s; the previous checkpoint is kept.\n", ck->path);
+        remove(ck->tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+static void *writerThread(void *arg)
+{
+    CfdCheckpoint *ck = (CfdCheckpoint *)arg;
+    pthread_mutex_lock(&ck->lock);
+    for (;;)
+    {
+        while (!ck->pending && !ck->stop)
+        {
+            pthread_cond_wait(&ck->cond, &ck->lock);
+        }
+        if (!ck->pending) break;    /* stop 且没有待写出的检查点 */
+
+        /* pending 期间求解线程不会改写缓冲区，散列与写出的过程中无需持锁 */
+        pthread_mutex_unlock(&ck->lock);
+        f64 t0 = cfdWallTime();
+        CfdCheckpointHeader *hdr = (CfdCheckpointHeader *)ck->buffer;
+        hdr->checksum = checksum(ck->buffer + sizeof(*hdr), (size_t)hdr->payload_bytes);
+        i32 status = writeAtomically(ck, ck->buffer, ck->bytes);
+        f64 elapsed = cfdWallTime() - t0;
+        pthread_mutex_lock(&ck->lock);
+
+        if (status == 0) ck->written++;
+        ck->write_seconds += elapsed;
+        ck->pending = 0;
+        pthread_cond_broadcast(&ck->cond);
+    }
+    pthread_mutex_unlock(&ck->lock);
+    return NULL;
+}
+
+CfdCheckpoint *cfdCheckpointOpen(const CfdConfig *cfg)
+{
+    CfdCheckpoint *ck = (CfdCheckpoint *)calloc(1, sizeof(CfdCheckpoint));
+    if (!ck)
+    {
+        printf("[ERROR] Memory allocation failed for checkpoint writer\n");
+        return NULL;
+    }
+    if (cfg->checkpoint[0] != '\0')
+    {
+        snprintf(ck->path, sizeof(ck->path), "%s", cfg->checkpoint);
+    }
+    else if (snprintf(ck->path, sizeof(ck->path), "%s/%s", cfg->output_dir, CFD_CHECKPOINT_FILE) >= (i32)sizeof(ck->path))
+    {
+        printf("[ERROR] Checkpoint path is too long\n");
+        free(ck);
+        return NULL;
+    }
+    snprintf(ck->tmp_path, sizeof(ck->tmp_path), "%s.tmp", ck->path);
+
+    pthread_mutex_init(&ck->lock, NULL);
+    pthread_cond_init(&ck->cond, NULL);
+    if (pthread_create(&ck->thread, NULL, writerThread, ck) != 0)
+    {
+        printf("[ERROR] Cannot start checkpoint writer thread\n");
+        pthread_mutex_destroy(&ck->lock);
+        pthread_cond_destroy(&ck->cond);
+        free(ck);
+        return NULL;
+    }
+    printf("[INFO] Writing checkpoints to %s every %g s of wall time\n", ck->path, cfg->checkpoint_interval);
+    return ck;
+}
+
+i32 cfdCheckpointSave(CfdCheckpoint *ck, const CfdSolver *s, const CfdRunState *rs)
+{
+    pthread_mutex_lock(&ck->lock);
+    i32 busy = ck->pending;
+    if (busy) ck->skipped++;
+    pthread_mutex_unlock(&ck->lock);
+    if (busy) return 1;
+
+    /* 写线程空闲，缓冲区此时只属于求解线程 */
+    size_t payload = sizeof(CfdRunState) + solverBytes(s);
+    if (s->shadow) payload += solverBytes(s->shadow);
+    size_t total = sizeof(CfdCheckpointHeader) + payload;
+    if (total > ck->capacity)
+    {
+        char *buffer = (char *)realloc(ck->buffer, total);
+        if (!buffer)
+        {
+            printf("[WARN] Memory allocation failed for checkpoint buffer; checkpoint skipped.\n");
+            return -1;
+        }
+        ck->buffer = buffer;
+        ck->capacity = total;
+    }
+
+    char *body = ck->buffer + sizeof(CfdCheckpointHeader);
+    char *dst = body;
+    memcpy(dst, rs, sizeof(*rs));
+    dst += sizeof(*rs);
+    dst = packSolver(dst, s);
+    if (s->shadow) packSolver(dst, s->shadow);
+
+    CfdCheckpointHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CFD_CHECKPOINT_MAGIC, sizeof(hdr.magic));
+    hdr.version = CFD_CHECKPOINT_VERSION;
+    hdr.header_bytes = (u32)sizeof(hdr);
+    hdr.nx = s->nx;
+    hdr.precision = s->precision;
+    hdr.derived_pressure = s->derived_pressure;
+    hdr.solvers = s->shadow ? 2 : 1;
+    hdr.payload_bytes = (u64)payload;
+    memcpy(ck->buffer, &hdr, sizeof(hdr));      /* checksum 由写线程填写 */
+
+    pthread_mutex_lock(&ck->lock);
+    ck->bytes = total;
+    ck->pending = 1;
+    pthread_cond_broadcast(&ck->cond);
+    pthread_mutex_unlock(&ck->lock);
+    return 0;
+}
+
+void cfdCheckpointWait(CfdCheckpoint *ck)
+{
+    pthread_mutex_lock(&ck->lock);
+    while (ck->pending) pthread_cond_wait(&ck->cond, &ck->lock);
+    pthread_mutex_unlock(&ck->lock);
+}
+
+void cfdCheckpointClose(CfdCheckpoint *ck)
+{
+    if (ck == NULL) return;
+    pthread_mutex_lock(&ck->lock);
+    ck->stop = 1;
+    pthread_cond_signal(&ck->cond);
+    pthread_mutex_unlock(&ck->lock);
+    pthread_join(ck->thread, NULL);
+    pthread_mutex_destroy(&ck->lock);
+    pthread_cond_destroy(&ck->cond);
+
+    printf("[INFO] Wrote %lld checkpoint(s) to %s (%.3f s in the background", ck->written, ck->path, ck->write_seconds);
+    if (ck->skipped > 0) printf(", %lld skipped while the previous one was being written", ck->skipped);
+    printf(")\n");
+    free(ck->buffer);
+    free(ck);
+}
+
+/* 检查点中的一个求解器段是否与按当前配置创建的求解器一致 */
+static i32 checkSolver(const char *src, const CfdSolver *s, const char *path)
+{
+    CfdCheckpointSolver st;
+    memcpy(&st, src, sizeof(st));
+    if (st.dx != s->dx)
+    {
+        printf("[ERROR] %s was written with dx=%g, but this run uses dx=%g\n", path, st.dx, s->dx);
+        return -1;
+    }
+    return 0;
+}
+
+i32 cfdCheckpointLoad(const CfdConfig *cfg, CfdSolver *s, CfdRunState *rs)
+{
+    char path[CFD_PATH_MAX + 64];
+    if (cfg->checkpoint[0] != '\0') snprintf(path, sizeof(path), "%s", cfg->checkpoint);
+    else snprintf(path, sizeof(path), "%s/%s", cfg->output_dir, CFD_CHECKPOINT_FILE);
+
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        printf("[ERROR] Cannot open checkpoint %s\n", path);
+        return -1;
+    }
+    CfdCheckpointHeader hdr;
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || memcmp(hdr.magic, CFD_CHECKPOINT_MAGIC, sizeof(hdr.magic)) != 0
+        || hdr.version != CFD_CHECKPOINT_VERSION || hdr.header_bytes != sizeof(hdr))
+    {
+        printf("[ERROR] %s is not a checkpoint written by this program\n", path);
+        fclose(fp);
+        return -1;
+    }
+    if (hdr.nx != s->nx || hdr.precision != s->precision || hdr.derived_pressure != s->derived_pressure
+        || hdr.solvers != (s->shadow ? 2 : 1))
+    {
+        printf("[ERROR] %s was written with nx=%d precision=%s derived_pressure=%d%s; "
+               "restart with the same settings\n", path, hdr.nx,
+               hdr.precision == CFD_PRECISION_MIXED ? "mixed" : "double", hdr.derived_pressure,
+               hdr.solvers > 1 ? " precision_check=1" : "");
+        fclose(fp);
+        return -1;
+    }
+    size_t payload = sizeof(CfdRunState) + solverBytes(s);
+    if (s->shadow) payload += solverBytes(s->shadow);
+    if (hdr.payload_bytes != (u64)payload)
+    {
+        printf("[ERROR] %s has an unexpected size; it was not written by this build\n", path);
+        fclose(fp);
+        return -1;
+    }
+
+    char *body = (char *)malloc(payload);
+    if (!body)
+    {
+        printf("[ERROR] Memory allocation failed while reading checkpoint\n");
+        fclose(fp);
+        return -1;
+    }
+    i32 ok = fread(body, 1, payload, fp) == payload;
+    fclose(fp);
+    if (!ok || checksum(body, payload) != hdr.checksum)
+    {
+        printf("[ERROR] %s is truncated or corrupted (checksum mismatch)\n", path);
+        free(body);
+        return -1;
+    }
+
+    const char *src = body + sizeof(CfdRunState);
+    if (checkSolver(src, s, path) != 0)
+    {
+        free(body);
+        return -1;
+    }
+    memcpy(rs, body, sizeof(*rs));
+    src = unpackSolver(src, s);
+    if (s->shadow) unpackSolver(src, s->shadow);
+    free(body);
+    /* 检查点保存的是展开后的完整流场，均匀段按恢复的数组重新识别 */
+    if (s->active) cfdActiveStart(s);
+
+    printf("[INFO] Restarted from %s at t=%.6f (step %lld)\n", path, s->t, s->step);
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+    source/cfd_codec.c
+    压缩快照的字段编码与解码
+*/
+#include "cfd_codec.h"
+#include <string.h>
+#include <math.h>
+
+#define SIGN_BIT 0x8000000000000000ULL
+
+size_t cfdCodecBound(i32 n)
+{
+    /* 最坏情况下 8 个平面都原样存储 */
+    return 8 * (1 + (size_t)n);
+}
+
+void cfdCodecKeys(const f64 *x, i32 n, u64 *key)
+{
+    for (i32 i = 0; i < n; i++)
+    {
+        u64 u;
+        memcpy(&u, &x[i], sizeof(u));
+        key[i] = (u & SIGN_BIT) ? ~u : (u | SIGN_BIT);
+    }
+}
+
+i32 cfdCodecQuantize(const f64 *x, i32 n, f64 quantum, u64 *key)
+{
+    const f64 half = 0.5 * quantum;
+    const f64 limit = 4503599627370496.0;      /* 2^52 */
+    for (i32 i = 0; i < n; i++)
+    {
+        const f64 s = x[i] / quantum;
+        if (!(fabs(s) < limit)) return -1;
+        i64 q = (i64)llround(s);
+        /* 除法与乘法各有一次舍入，按还原时的运算校验并修正一格 */
+        f64 err = (f64)q * quantum - x[i];
+        if (err > half) q--;
+        else if (err < -half) q++;
+        key[i] = (u64)q;
+    }
+    return 0;
+}
+
+void cfdCodecValues(const u64 *key, i32 n, f64 quantum, f64 *x)
+{
+    if (quantum > 0)
+    {
+        for (i32 i = 0; i < n; i++) x[i] = (f64)(i64)key[i] * quantum;
+        return;
+    }
+    for (i32 i = 0; i < n; i++)
+    {
+        const u64 k = key[i];
+        const u64 u = (k & SIGN_BIT) ? (k ^ SIGN_BIT) : ~k;
+        memcpy(&x[i], &u, sizeof(u));
+    }
+}
+
+size_t cfdCodecEncode(const u64 *key, const u64 *prev, i32 n, u64 *scratch, u8 *dst)
+{
+    /* Lorenzo 残差，zigzag 映射：0, -1, 1, -2, ... -> 0, 1, 2, 3, ... */
+    u64 last = 0;
+    for (i32 i = 0; i < n; i++)
+    {
+        const u64 d = key[i] - (prev ? prev[i] : 0);
+        const u64 r = d - last;
+        scratch[i] = (r << 1) ^ (u64)((i64)r >> 63);
+        last = d;
+    }
+
+    u8 *p = dst;
+    const size_t bitmap = ((size_t)n + 7) / 8;
+    for (i32 k = 0; k < 8; k++)
+    {
+        const i32 shift = 8 * k;
+        size_t nnz = 0;
+        for (i32 i = 0; i < n; i++) nnz += ((scratch[i] >> shift) & 0xff) != 0;
+        if (nnz == 0)
+        {
+            *p++ = CFD_CODEC_PLANE_ZERO;
+        }
+        else if (bitmap + nnz < (size_t)n)
+        {
+            *p++ = CFD_CODEC_PLANE_SPARSE;
+            u8 *bits = p, *bytes = p + bitmap;
+            memset(bits, 0, bitmap);
+            for (i32 i = 0; i < n; i++)
+            {
+                const u8 b = (u8)(scratch[i] >> shift);
+                if (b)
+                {
+                    bits[i >> 3] |= (u8)(1u << (i & 7));
+                    *bytes++ = b;
+                }
+            }
+            p = bytes;
+        }
+        else
+        {
+            *p++ = CFD_CODEC_PLANE_RAW;
+            for (i32 i = 0; i < n; i++) p[i] = (u8)(scratch[i] >> shift);
+            p += n;
+        }
+    }
+    return (size_t)(p - dst);
+}
+
+i32 cfdCodecDecode(const u8 *src, size_t bytes, const u64 *prev, i32 n, u64 *key)
+{
+    const u8 *p = src, *end = src + bytes;
+    const size_t bitmap = ((size_t)n + 7) / 8;
+    memset(key, 0, sizeof(u64) * (size_t)n);
+    for (i32 k = 0; k < 8; k++)
+    {
+        const i32 shift = 8 * k;
+        if (p >= end) return -1;
+        const u8 mode = *p++;
+        if (mode == CFD_CODEC_PLANE_ZERO) continue;
+        if (mode == CFD_CODEC_PLANE_RAW)
+        {
+            if ((size_t)(end - p) < (size_t)n) return -1;
+            for (i32 i = 0; i < n; i++) key[i] |= (u64)p[i] << shift;
+            p += n;
+        }
+        else if (mode == CFD_CODEC_PLANE_SPARSE)
+        {
+            if ((size_t)(end - p) < bitmap) return -1;
+            const u8 *bits = p;
+            p += bitmap;
+            for (i32 i = 0; i < n; i++)
+            {
+                if (!(bits[i >> 3] & (1u << (i & 7)))) continue;
+                if (p >= end) return -1;
+                key[i] |= (u64)*p++ << shift;
+            }
+        }
+        else
+        {
+            return -1;
+        }
+    }
+    if (p != end) return -1;
+
+    /* 逆 zigzag、沿空间累加得到各点的变化，再加回上一帧的键 */
+    u64 last = 0;
+    for (i32 i = 0; i < n; i++)
+    {
+        const u64 z = key[i];
+        last += (z >> 1) ^ (0 - (z & 1));
+        key[i] = last + (prev ? prev[i] : 0);
+    }
+    return 0;
+}
@@ -0,0 +1,722 @@
+/*
+    source/cfd_config.c
+    运行参数的默认值、命令行与配置文件解析
+*/
+#include "cfd_config.h"
+#include "cfd_output.h"
+#include "cfd_simd.h"
+#include "cfd_stepper.h"
+#include "cfd_ensemble.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/* 命令行选项与配置键的对应关系；value 非空时该选项不带参数 */
+typedef struct {
+    const char *flag;
+    const char *key;
+    const char *value;
+    const char *help;
+} CfdOption;
+
+static const CfdOption cfd_options[] = {
+    {"--nx",          "nx",                NULL, "number of grid points"},
+    {"--dx",          "dx",                NULL, "grid spacing (m)"},
+    {"--grid-stretch","grid_stretch",      NULL, "cluster points at the piston with a tanh mapping of this strength (0 = uniform)"},
+    {"--grid-length", "grid_length",       NULL, "tube length of the stretched grid (m, 0 = (nx-1)*dx)"},
+    {"--dt",          "dt",                NULL, "time step (s)"},
+    {"--t-end",       "t_end",             NULL, "end time (s)"},
+    {"--timer",       "timer",             NULL, "snapshot interval (s)"},
+    {"--print-every", "print_after_steps", NULL, "progress output interval (steps)"},
+    {"--output-dir",  "output_dir",        NULL, "directory for snapshot files"},
+    {"--output-format","output_format",    NULL, "snapshot format: binary, csv, both or compressed (snapshots.cfz)"},
+    {"--output-error","output_error",      NULL, "compressed snapshots: velocity error bound (m/s, 0 = lossless)"},
+    {"--output-queue","output_queue",      NULL, "snapshot writer queue depth (0 = write synchronously)"},
+    {"--output-stride","output_stride",    NULL, "spatial sampling stride for snapshots (grid points)"},
+    {"--output-window","output_window",    NULL, "grid index window START:END written to snapshots"},
+    {"--output-every","output_every",      NULL, "write every N-th snapshot"},
+    {"--output-sampling","output_sampling",NULL, "point (every stride-th value) or minmax (min/max per stride bucket)"},
+    {"--cfl",         "cfl",               NULL, "adaptive time step with this CFL number (0 = fixed dt)"},
+    {"--cfl-interval","cfl_interval",      NULL, "steps between CFL re-estimates in adaptive mode"},
+    {"--piston",      "piston",            NULL, "piston acceleration: fourier, table (interpolated lookup) or piecewise (exact 3/0/1/0)"},
+    {"--piston-recurrence","piston_recurrence","1","evaluate the piston Fourier series by rotating recurrence (faster, ~1e-9 drift)"},
+    {"--exact-piston","piston_recurrence", "0",  "evaluate the piston Fourier series exactly every step (default)"},
+    {"--simd",        "simd",              NULL, "interior kernel: auto, scalar, generic, avx2, avx512"},
+    {"--stepper",     "stepper",           NULL, "time integrator: taylor, ssprk3, rk4 or maccormack (RK steppers allow larger CFL)"},
+    {"--persistent",  "persistent_region", "1",  "advance fixed-step runs inside one persistent OpenMP parallel region"},
+    {"--temporal-block","temporal_depth",  NULL, "advance fixed-step runs N steps per cache-resident tile (0 = off)"},
+    {"--temporal-tile","temporal_tile",    NULL, "grid points per temporal-blocking tile (0 = size to the L2 cache)"},
+    {"--active-region","active_region",    "1",  "skip the quiescent cells ahead of the acoustic front (exact)"},
+    {"--precision",   "precision",         NULL, "field storage: double, or mixed (float32 storage, float64 arithmetic)"},
+    {"--precision-check","precision_check","1",  "with mixed precision, also run in double and report the error"},
+    {"--derived-pressure","derived_pressure","1", "derive pressure from the equation of state instead of storing it"},
+    {"--ensemble",    "ensemble",          NULL, "run every piston profile listed in FILE together (see cfd_ensemble.h)"},
+    {"--ensemble-layout","ensemble_layout",NULL, "interleaved (members innermost, SIMD across members) or member (one per thread)"},
+    {"--checkpoint-interval","checkpoint_interval",NULL, "write a restart checkpoint every N seconds of wall time (0 = never)"},
+    {"--checkpoint",  "checkpoint",        NULL, "checkpoint file (default <output-dir>/checkpoint.bin)"},
+    {"--restart",     "restart",           "1",  "resume bit-for-bit from the checkpoint file"},
+    {"--probes",      "probes",            NULL, "comma-separated grid indices sampled into probes.bin (negative counts from the end)"},
+    {"--probe-every", "probe_every",       NULL, "probe sampling interval (steps)"},
+    {"--live",        "live",              NULL, "publish the field to this POSIX shared-memory name for the live viewer"},
+    {"--live-every",  "live_every",        NULL, "live publishing interval (steps)"},
+    {"--live-slots",  "live_slots",        NULL, "frames kept in the live ring buffer"},
+    {"--no-watchdog", "watchdog",          "0",  "do not check max|v|, min rho and finiteness every step"},
+    {"--nan-check",   "nan_check",         NULL, "scan the field every N steps where the kernels cannot check it (0 = print interval with the watchdog, else never)"},
+    {"--sweep",       "sweep",             NULL, "run every job listed in FILE with work stealing across runs (see cfd_sweep.h)"},
+    {"--sweep-split-nx","sweep_split_nx",  NULL, "sweep jobs with at least this many points use all threads"},
+    {"--quiet",       "quiet",             "1",  "do not print progress (batch jobs)"},
+    {"--perf-json",   "perf_json",         NULL, "performance summary file (default <output-dir>/perf.json)"},
+};
+#define CFD_OPTION_COUNT ((i32)(sizeof(cfd_options) / sizeof(cfd_options[0])))
+
+void cfdConfigDefaults(CfdConfig *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->nx = NX;
+    cfg->dx = DX;
+    cfg->grid_stretch = GRID_STRETCH;
+    cfg->grid_length = 0.0;
+    cfg->dt = DT;
+    cfg->t_end = T_END;
+    cfg->timer = TIMER;
+    cfg->print_after_steps = PRINT_AFTER_STEPS;
+    cfg->quiet = 0;
+    cfg->piston_source = CFD_PISTON_FOURIER;
+    cfg->piston_recurrence = PISTON_RECURRENCE;
+    cfg->simd = CFD_SIMD_AUTO;
+    cfg->stepper = STEPPER;
+    cfg->persistent_region = PERSISTENT_REGION;
+    cfg->temporal_depth = TEMPORAL_DEPTH;
+    cfg->temporal_tile = TEMPORAL_TILE;
+    cfg->active_region = ACTIVE_REGION;
+    cfg->precision = CFD_PRECISION_DOUBLE;
+    cfg->precision_check = 0;
+    cfg->derived_pressure = DERIVED_PRESSURE;
+    cfg->cfl = CFL;
+    cfg->cfl_interval = CFL_INTERVAL;
+    strcpy(cfg->output_dir, "build");
+    cfg->output_format = CFD_OUTPUT_BINARY;
+    cfg->output_queue = OUTPUT_QUEUE;
+    cfg->output_stride = 1;
+    cfg->output_window_start = 0;
+    cfg->output_window_end = -1;
+    cfg->output_every = 1;
+    cfg->output_sampling = CFD_SAMPLE_POINT;
+    cfg->output_error = 0.0;
+    cfg->ensemble_layout = CFD_ENSEMBLE_INTERLEAVED;
+    cfg->checkpoint_interval = CHECKPOINT_INTERVAL;
+    cfg->restart = 0;
+    cfg->probe_count = 0;
+    cfg->probe_every = PROBE_EVERY;
+    cfg->live_every = LIVE_EVERY;
+    cfg->live_slots = LIVE_SLOTS;
+    cfg->watchdog = WATCHDOG;
+    cfg->nan_check = NAN_CHECK;
+    cfg->sweep_split_nx = SWEEP_SPLIT_NX;
+}
+
+static i32 parseI32(const char *key, const char *value, i32 *out)
+{
+    char *end;
+    long v = strtol(value, &end, 10);
+    if (end == value || *end != '\0')
+    {
+        printf("[ERROR] Invalid integer for %s: '%s'\n", key, value);
+        return -1;
+    }
+    *out = (i32)v;
+    return 0;
+}
+
+static i32 parseF64(const char *key, const char *value, f64 *out)
+{
+    char *end;
+    f64 v = strtod(value, &end);
+    if (end == value || *end != '\0')
+    {
+        printf("[ERROR] Invalid number for %s: '%s'\n", key, value);
+        return -1;
+    }
+    *out = v;
+    return 0;
+}
+
+i32 cfdConfigSet(CfdConfig *cfg, const char *key, const char *value)
+{
+    if (strcmp(key, "nx") == 0)                 return parseI32(key, value, &cfg->nx);
+    if (strcmp(key, "dx") == 0)                 return parseF64(key, value, &cfg->dx);
+    if (strcmp(key, "grid_stretch") == 0)       return parseF64(key, value, &cfg->grid_stretch);
+    if (strcmp(key, "grid_length") == 0)        return parseF64(key, value, &cfg->grid_length);
+    if (strcmp(key, "dt") == 0)                 return parseF64(key, value, &cfg->dt);
+    if (strcmp(key, "t_end") == 0)              return parseF64(key, value, &cfg->t_end);
+    if (strcmp(key, "timer") == 0)              return parseF64(key, value, &cfg->timer);
+    if (strcmp(key, "print_after_steps") == 0)  return parseI32(key, value, &cfg->print_after_steps);
+    if (strcmp(key, "piston_recurrence") == 0)  return parseI32(key, value, &cfg->piston_recurrence);
+    if (strcmp(key, "piston") == 0)
+    {
+        if (strcmp(value, "fourier") == 0)          cfg->piston_source = CFD_PISTON_FOURIER;
+        else if (strcmp(value, "table") == 0)       cfg->piston_source = CFD_PISTON_TABLE;
+        else if (strcmp(value, "piecewise") == 0)   cfg->piston_source = CFD_PISTON_PIECEWISE;
+        else
+        {
+            printf("[ERROR] piston must be fourier, table or piecewise (got '%s')\n", value);
+            return -1;
+        }
+        return 0;
+    }
+    if (strcmp(key, "simd") == 0)
+    {
+        i32 level = cfdSimdParse(value);
+        if (level == -2)
+        {
+            printf("[ERROR] simd must be auto, scalar, generic, avx2 or avx512 (got '%s')\n", value);
+            return -1;
+        }
+        cfg->simd = level;
+        return 0;
+    }
+    if (strcmp(key, "stepper") == 0)
+    {
+        i32 stepper = cfdStepperParse(value);
+        if (stepper < 0)
+        {
+            printf("[ERROR] stepper must be taylor, ssprk3, rk4 or maccormack (got '%s')\n", value);
+            return -1;
+        }
+        cfg->stepper = stepper;
+        return 0;
+    }
+    if (strcmp(key, "persistent_region") == 0)  return parseI32(key, value, &cfg->persistent_region);
+    if (strcmp(key, "temporal_depth") == 0)     return parseI32(key, value, &cfg->temporal_depth);
+    if (strcmp(key, "temporal_tile") == 0)      return parseI32(key, value, &cfg->temporal_tile);
+    if (strcmp(key, "active_region") == 0)      return parseI32(key, value, &cfg->active_region);
+    if (strcmp(key, "precision") == 0)
+    {
+        if (strcmp(value, "double") == 0)       cfg->precision = CFD_PRECISION_DOUBLE;
+        else if (strcmp(value, "mixed") == 0)   cfg->precision = CFD_PRECISION_MIXED;
+        else
+        {
+            printf("[ERROR] precision must be double or mixed (got '%s')\n", value);
+            return -1;
+        }
+        return 0;
+    }
+    if (strcmp(key, "precision_check") == 0)    return parseI32(key, value, &cfg->precision_check);
+    if (strcmp(key, "derived_pressure") == 0)   return parseI32(key, value, &cfg->derived_pressure);
+    if (strcmp(key, "quiet") == 0)              return parseI32(key, value, &cfg->quiet);
+    if (strcmp(key, "output_queue") == 0)       return parseI32(key, value, &cfg->output_queue);
+    if (strcmp(key, "output_stride") == 0)      return parseI32(key, value, &cfg->output_stride);
+    if (strcmp(key, "output_every") == 0)       return parseI32(key, value, &cfg->output_every);
+    if (strcmp(key, "output_error") == 0)       return parseF64(key, value, &cfg->output_error);
+    if (strcmp(key, "output_window") == 0)
+    {
+        /* START:END，END 为空表示到末端 */
+        char *end;
+        long a = strtol(value, &end, 10);
+        if (end == value || *end != ':')
+        {
+            printf("[ERROR] output_window must be START:END (got '%s')\n", value);
+            return -1;
+        }
+        const char *rest = end + 1;
+        long b = -1;
+        if (*rest != '\0')
+        {
+            b = strtol(rest, &end, 10);
+            if (end == rest || *end != '\0')
+            {
+                printf("[ERROR] output_window must be START:END (got '%s')\n", value);
+                return -1;
+            }
+        }
+        cfg->output_window_start = (i32)a;
+        cfg->output_window_end = (i32)b;
+        return 0;
+    }
+    if (strcmp(key, "output_sampling") == 0)
+    {
+        if (strcmp(value, "point") == 0)        cfg->output_sampling = CFD_SAMPLE_POINT;
+        else if (strcmp(value, "minmax") == 0)  cfg->output_sampling = CFD_SAMPLE_MINMAX;
+        else
+        {
+            printf("[ERROR] output_sampling must be point or minmax (got '%s')\n", value);
+            return -1;
+        }
+        return 0;
+    }
+    if (strcmp(key, "cfl") == 0)                return parseF64(key, value, &cfg->cfl);
+    if (strcmp(key, "cfl_interval") == 0)       return parseI32(key, value, &cfg->cfl_interval);
+    if (strcmp(key, "output_dir") == 0)
+    {
+        if (strlen(value) >= CFD_PATH_MAX)
+        {
+            printf("[ERROR] output_dir is too long\n");
+            return -1;
+        }
+        strcpy(cfg->output_dir, value);
+        return 0;
+    }
+    if (strcmp(key, "perf_json") == 0)
+    {
+        if (strlen(value) >= CFD_PATH_MAX)
+        {
+            printf("[ERROR] perf_json is too long\n");
+            return -1;
+        }
+        strcpy(cfg->perf_json, value);
+        return 0;
+    }
+    if (strcmp(key, "ensemble") == 0)
+    {
+        if (strlen(value) >= CFD_PATH_MAX)
+        {
+            printf("[ERROR] ensemble is too long\n");
+            return -1;
+        }
+        strcpy(cfg->ensemble, value);
+        return 0;
+    }
+    if (strcmp(key, "sweep") == 0)
+    {
+        if (strlen(value) >= CFD_PATH_MAX)
+        {
+            printf("[ERROR] sweep is too long\n");
+            return -1;
+        }
+        strcpy(cfg->sweep, value);
+        return 0;
+    }
+    if (strcmp(key, "sweep_split_nx") == 0)     return parseI32(key, value, &cfg->sweep_split_nx);
+    if (strcmp(key, "nan_check") == 0)          return parseI32(key, value, &cfg->nan_check);
+    if (strcmp(key, "watchdog") == 0)           return parseI32(key, value, &cfg->watchdog);
+    if (strcmp(key, "probe_every") == 0)        return parseI32(key, value, &cfg->probe_every);
+    if (strcmp(key, "live_every") == 0)         return parseI32(key, value, &cfg->live_every);
+    if (strcmp(key, "live_slots") == 0)         return parseI32(key, value, &cfg->live_slots);
+    if (strcmp(key, "live") == 0)
+    {
+        if (strlen(value) + 1 >= CFD_PATH_MAX)
+        {
+            printf("[ERROR] live is too long\n");
+            return -1;
+        }
+        strcpy(cfg->live, value);
+        return 0;
+    }
+    if (strcmp(key, "probes") == 0)
+    {
+        /* 逗号分隔的下标列表，空串或 none 表示关闭 */
+        i32 count = 0;
+        const char *p = value;
+        if (*p != '\0' && strcmp(p, "none") != 0)
+        {
+            for (;;)
+            {
+                char *end;
+                long v = strtol(p, &end, 10);
+                if (end == p || (*end != ',' && *end != '\0'))
+                {
+                    printf("[ERROR] probes must be comma-separated grid indices (got '%s')\n", value);
+                    return -1;
+                }
+                if (count == CFD_PROBE_MAX)
+                {
+                    printf("[ERROR] At most %d probes are supported\n", CFD_PROBE_MAX);
+                    return -1;
+                }
+                cfg->probe_idx[count++] = (i32)v;
+                if (*end == '\0') break;
+                p = end + 1;
+            }
+        }
+        cfg->probe_count = count;
+        return 0;
+    }
+    if (strcmp(key, "checkpoint_interval") == 0) return parseF64(key, value, &cfg->checkpoint_interval);
+    if (strcmp(key, "restart") == 0)            return parseI32(key, value, &cfg->restart);
+    if (strcmp(key, "checkpoint") == 0)
+    {
+        if (strlen(value) >= CFD_PATH_MAX)
+        {
+            printf("[ERROR] checkpoint is too long\n");
+            return -1;
+        }
+        strcpy(cfg->checkpoint, value);
+        return 0;
+    }
+    if (strcmp(key, "ensemble_layout") == 0)
+    {
+        if (strcmp(value, "interleaved") == 0)  cfg->ensemble_layout = CFD_ENSEMBLE_INTERLEAVED;
+        else if (strcmp(value, "member") == 0)  cfg->ensemble_layout = CFD_ENSEMBLE_MEMBER;
+        else
+        {
+            printf("[ERROR] ensemble_layout must be interleaved or member (got '%s')\n", value);
+            return -1;
+        }
+        return 0;
+    }
+    if (strcmp(key, "output_format") == 0)
+    {
+        if (strcmp(value, "binary") == 0)     cfg->output_format = CFD_OUTPUT_BINARY;
+        else if (strcmp(value, "csv") == 0)   cfg->output_format = CFD_OUTPUT_CSV;
+        else if (strcmp(value, "both") == 0)  cfg->output_format = CFD_OUTPUT_BINARY | CFD_OUTPUT_CSV;
+        else if (strcmp(value, "compressed") == 0) cfg->output_format = CFD_OUTPUT_COMPRESSED;
+        else
+        {
+            printf("[ERROR] output_format must be binary, csv, both or compressed (got '%s')\n", value);
+            return -1;
+        }
+        return 0;
+    }
+    printf("[ERROR] Unknown parameter '%s'\n", key);
+    return -1;
+}
+
+i32 cfdConfigValidate(const CfdConfig *cfg)
+{
+    /* 边界二阶单边差分用到第 4 个点 */
+    if (cfg->nx < 4)
+    {
+        printf("[ERROR] nx must be at least 4 (got %d)\n", cfg->nx);
+        return -1;
+    }
+    if (!(cfg->dx > 0) || !(cfg->dt > 0))
+    {
+        printf("[ERROR] dx and dt must be positive (dx=%g, dt=%g)\n", cfg->dx, cfg->dt);
+        return -1;
+    }
+    if (!(cfg->grid_stretch >= 0) || !(cfg->grid_length >= 0))
+    {
+        printf("[ERROR] grid_stretch and grid_length must be non-negative (got %g, %g)\n", cfg->grid_stretch, cfg->grid_length);
+        return -1;
+    }
+    if (!(cfg->t_end >= 0) || !(cfg->timer > 0))
+    {
+        printf("[ERROR] t_end must be non-negative and timer positive (t_end=%g, timer=%g)\n", cfg->t_end, cfg->timer);
+        return -1;
+    }
+    if (cfg->print_after_steps <= 0)
+    {
+        printf("[ERROR] print_after_steps must be positive (got %d)\n", cfg->print_after_steps);
+        return -1;
+    }
+    if (cfg->temporal_depth < 0 || cfg->temporal_tile < 0)
+    {
+        printf("[ERROR] temporal_depth and temporal_tile must be non-negative (got %d, %d)\n",
+               cfg->temporal_depth, cfg->temporal_tile);
+        return -1;
+    }
+    if (cfg->output_queue < 0)
+    {
+        printf("[ERROR] output_queue must be non-negative (got %d)\n", cfg->output_queue);
+        return -1;
+    }
+    if (!(cfg->output_error >= 0))
+    {
+        printf("[ERROR] output_error must be non-negative (got %g)\n", cfg->output_error);
+        return -1;
+    }
+    if (cfg->output_stride <= 0 || cfg->output_every <= 0)
+    {
+        printf("[ERROR] output_stride and output_every must be positive (got %d, %d)\n", cfg->output_stride, cfg->output_every);
+        return -1;
+    }
+    {
+        i32 w1 = cfg->output_window_end < 0 || cfg->output_window_end > cfg->nx ? cfg->nx : cfg->output_window_end;
+        if (cfg->output_window_start < 0 || cfg->output_window_start >= w1)
+        {
+            printf("[ERROR] output_window %d:%d is empty for nx=%d\n", cfg->output_window_start, cfg->output_window_end, cfg->nx);
+            return -1;
+        }
+    }
+    if (!(cfg->cfl >= 0) || cfg->cfl_interval <= 0)
+    {
+        printf("[ERROR] cfl must be non-negative and cfl_interval positive (cfl=%g, cfl_interval=%d)\n", cfg->cfl, cfg->cfl_interval);
+        return -1;
+    }
+    if (cfg->probe_every <= 0)
+    {
+        printf("[ERROR] probe_every must be positive (got %d)\n", cfg->probe_every);
+        return -1;
+    }
+    if (cfg->live_every <= 0 || cfg->live_slots < 2)
+    {
+        printf("[ERROR] live_every must be positive and live_slots at least 2 (live_every=%d, live_slots=%d)\n",
+               cfg->live_every, cfg->live_slots);
+        return -1;
+    }
+    if (cfg->nan_check < 0 || cfg->sweep_split_nx <= 0)
+    {
+        printf("[ERROR] nan_check must be non-negative and sweep_split_nx positive (nan_check=%d, sweep_split_nx=%d)\n",
+               cfg->nan_check, cfg->sweep_split_nx);
+        return -1;
+    }
+    if (cfg->sweep[0] != '\0' && cfg->ensemble[0] != '\0')
+    {
+        printf("[ERROR] sweep and ensemble cannot be combined\n");
+        return -1;
+    }
+    for (i32 k = 0; k < cfg->probe_count; k++)
+    {
+        if (cfg->probe_idx[k] < -cfg->nx || cfg->probe_idx[k] >= cfg->nx)
+        {
+            printf("[ERROR] probe index %d is outside the grid (nx=%d)\n", cfg->probe_idx[k], cfg->nx);
+            return -1;
+        }
+    }
+    if (!(cfg->checkpoint_interval >= 0))
+    {
+        printf("[ERROR] checkpoint_interval must be non-negative (got %g)\n", cfg->checkpoint_interval);
+        return -1;
+    }
+    if (cfg->cfl > cfdStepperCflLimit(cfg->stepper))
+    {
+        printf("[WARN] cfl=%g exceeds %g; the %s stepper is likely to diverge\n", cfg->cfl,
+               cfdStepperCflLimit(cfg->stepper), cfdStepperName(cfg->stepper));
+    }
+    return 0;
+}
+
+/* 去掉首尾空白，返回指向原缓冲区内的起始位置 */
+static char *trim(char *s)
+{
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+i32 cfdConfigSetString(CfdConfig *cfg, const char *text)
+{
+    char *copy = (char *)malloc(strlen(text) + 1);
+    if (!copy)
+    {
+        printf("[ERROR] Memory allocation failed while parsing parameters\n");
+        return -1;
+    }
+    strcpy(copy, text);
+
+    i32 status = 0;
+    char *next = copy;
+    while (next && status == 0)
+    {
+        char *item = next;
+        next = strpbrk(item, ";\n");
+        if (next) *next++ = '\0';
+        char *hash = strchr(item, '#');
+        if (hash) *hash = '\0';
+        item = trim(item);
+        if (*item == '\0') continue;
+
+        char *eq = strchr(item, '=');
+        if (eq == NULL)
+        {
+            printf("[ERROR] Expected 'key = value', got '%s'\n", item);
+            status = -1;
+            break;
+        }
+        *eq = '\0';
+        status = cfdConfigSet(cfg, trim(item), trim(eq + 1));
+    }
+    free(copy);
+    return status;
+}
+
+i32 cfdConfigLoadFile(const char *path, const CfdConfig *base, CfdConfig **runs, i32 *count)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL)
+    {
+        printf("[ERROR] Cannot open config file %s\n", path);
+        return -1;
+    }
+
+    CfdConfig common = *base;
+    CfdConfig *list = NULL;
+    i32 n = 0;
+    CfdConfig *current = &common;
+    char line[1024];
+    i32 lineno = 0;
+    i32 status = 0;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *text = trim(line);
+        if (*text == '\0') continue;
+
+        if (strcmp(text, "[run]") == 0)
+        {
+            CfdConfig *grown = (CfdConfig *)realloc(list, sizeof(CfdConfig) * (n + 1));
+            if (!grown)
+            {
+                printf("[ERROR] Memory allocation failed while reading %s\n", path);
+                status = -1;
+                break;
+            }
+            list = grown;
+            list[n] = common;
+            current = &list[n];
+            n++;
+            continue;
+        }
+
+        char *eq = strchr(text, '=');
+        if (eq == NULL)
+        {
+            printf("[ERROR] %s:%d: expected 'key = value'\n", path, lineno);
+            status = -1;
+            break;
+        }
+        *eq = '\0';
+        if (cfdConfigSet(current, trim(text), trim(eq + 1)) != 0)
+        {
+            printf("[ERROR] %s:%d: invalid entry\n", path, lineno);
+            status = -1;
+            break;
+        }
+    }
+    fclose(in);
+
+    if (status != 0)
+    {
+        free(list);
+        return status;
+    }
+    /* 没有 [run] 段时，整个文件就是一组参数 */
+    if (n == 0)
+    {
+        list = (CfdConfig *)malloc(sizeof(CfdConfig));
+        if (!list)
+        {
+            printf("[ERROR] Memory allocation failed while reading %s\n", path);
+            return -1;
+        }
+        list[0] = common;
+        n = 1;
+    }
+    *runs = list;
+    *count = n;
+    return 0;
+}
+
+void cfdConfigPrintUsage(const char *prog)
+{
+    printf("Usage: %s [options]\n\n", prog);
+    printf("  %-16s %s\n", "--config FILE", "read parameters from FILE ([run] sections define a batch)");
+    for (i32 k = 0; k < CFD_OPTION_COUNT; k++)
+    {
+        char flag[64];
+        if (cfd_options[k].value)
+            snprintf(flag, sizeof(flag), "%s", cfd_options[k].flag);
+        else
+            snprintf(flag, sizeof(flag), "%s V", cfd_options[k].flag);
+        printf("  %-16s %s (config key: %s)\n", flag, cfd_options[k].help, cfd_options[k].key);
+    }
+    printf("  %-16s %s\n", "--help", "show this message");
+}
+
+static const CfdOption *findOption(const char *flag)
+{
+    for (i32 k = 0; k < CFD_OPTION_COUNT; k++)
+    {
+        if (strcmp(cfd_options[k].flag, flag) == 0) return &cfd_options[k];
+    }
+    return NULL;
+}
+
+i32 cfdConfigParseArgs(i32 argc, char **argv, CfdConfig **runs, i32 *count)
+{
+    CfdConfig base;
+    cfdConfigDefaults(&base);
+
+    /* 第一遍：处理 --help 与 --config */
+    const char *config_path = NULL;
+    for (i32 i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+        {
+            cfdConfigPrintUsage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--config") == 0)
+        {
+            if (i + 1 >= argc)
+            {
+                printf("[ERROR] --config requires a file name\n");
+                return -1;
+            }
+            config_path = argv[++i];
+        }
+    }
+
+    CfdConfig *list = NULL;
+    i32 n = 0;
+    if (config_path)
+    {
+        if (cfdConfigLoadFile(config_path, &base, &list, &n) != 0) return -1;
+    }
+    else
+    {
+        list = (CfdConfig *)malloc(sizeof(CfdConfig));
+        if (!list)
+        {
+            printf("[ERROR] Memory allocation failed while parsing arguments\n");
+            return -1;
+        }
+        list[0] = base;
+        n = 1;
+    }
+
+    /* 第二遍：命令行选项覆盖到每一组参数 */
+    for (i32 i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--config") == 0)
+        {
+            i++;
+            continue;
+        }
+        const CfdOption *opt = findOption(argv[i]);
+        if (opt == NULL)
+        {
+            printf("[ERROR] Unknown option '%s' (see --help)\n", argv[i]);
+            free(list);
+            return -1;
+        }
+        const char *value = opt->value;
+        if (value == NULL)
+        {
+            if (i + 1 >= argc)
+            {
+                printf("[ERROR] %s requires a value\n", opt->flag);
+                free(list);
+                return -1;
+            }
+            value = argv[++i];
+        }
+        for (i32 r = 0; r < n; r++)
+        {
+            if (cfdConfigSet(&list[r], opt->key, value) != 0)
+            {
+                free(list);
+                return -1;
+            }
+        }
+    }
+
+    for (i32 r = 0; r < n; r++)
+    {
+        if (cfdConfigValidate(&list[r]) != 0)
+        {
+            if (n > 1) printf("[ERROR] Run #%d has invalid parameters\n", r + 1);
+            free(list);
+            return -1;
+        }
+    }
+    *runs = list;
+    *count = n;
+    return 0;
+}
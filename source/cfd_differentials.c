@@ -7,77 +7,120 @@
 #include "constants.h"
 #include <math.h>
 
-f64 prho_px(i32 idx){
+/*
+    拉伸网格（s->grid 非空）上的空间导数：内部点用 cfd_grid.h 中预先求出的逐点系数，
+    端点的一阶导数用实际间距做单边差分，二阶导数用过端点的三点抛物线（一阶精度）。
+*/
+static f64 gridFirst(const CfdGrid *g, const f64 *f, i32 idx)
+{
+    const i32 nx = g->nx;
+    if (idx == 0) return (f[1] - f[0]) / g->dx_min;
+    if (idx == nx - 1) return (f[nx - 1] - f[nx - 2]) / g->dx_max;
+    return (f[idx + 1] - f[idx - 1]) * g->d1[idx] + (f[idx + 1] - 2 * f[idx] + f[idx - 1]) * g->d1s[idx];
+}
+
+static f64 gridSecond(const CfdGrid *g, const f64 *f, i32 idx)
+{
+    const i32 nx = g->nx;
+    if (idx == 0 || idx == nx - 1)
+    {
+        const i32 a = idx == 0 ? 0 : nx - 3;
+        const f64 h1 = g->x[a + 1] - g->x[a], h2 = g->x[a + 2] - g->x[a + 1];
+        return 2 * (f[a] / (h1 * (h1 + h2)) - f[a + 1] / (h1 * h2) + f[a + 2] / (h2 * (h1 + h2)));
+    }
+    return (f[idx + 1] - 2 * f[idx] + f[idx - 1]) * g->d2[idx] + (f[idx + 1] - f[idx - 1]) * g->d2s[idx];
+}
+
+f64 prho_px(const CfdSolver *s, i32 idx){
+    const f64 *rho = s->rho;
+    if (s->grid) return gridFirst(s->grid, rho, idx);
+    const i32 nx = s->nx;
+    const f64 dx = s->dx;
     if (idx == 0){
-        return (rho[1] - rho[0]) / DX;
-    } else if (idx == NX - 1){
-        return (rho[NX - 1] - rho[NX - 2]) / DX;
+        return (rho[1] - rho[0]) / dx;
+    } else if (idx == nx - 1){
+        return (rho[nx - 1] - rho[nx - 2]) / dx;
     } else {
-        return (rho[idx + 1] - rho[idx - 1]) / (2 * DX);
+        return (rho[idx + 1] - rho[idx - 1]) / (2 * dx);
     }
 }
 
-f64 pvx_px(i32 idx){
+f64 pvx_px(const CfdSolver *s, i32 idx){
+    const f64 *vel = s->vel;
+    if (s->grid) return gridFirst(s->grid, vel, idx);
+    const i32 nx = s->nx;
+    const f64 dx = s->dx;
     if (idx == 0){
-        return (vel[1] - vel[0]) / DX;
-    } else if (idx == NX - 1){
-        return (vel[NX - 1] - vel[NX - 2]) / DX;
+        return (vel[1] - vel[0]) / dx;
+    } else if (idx == nx - 1){
+        return (vel[nx - 1] - vel[nx - 2]) / dx;
     } else {
-        return (vel[idx + 1] - vel[idx - 1]) / (2 * DX);
+        return (vel[idx + 1] - vel[idx - 1]) / (2 * dx);
     }
 }
 
-f64 prho_pt(i32 idx){
+f64 prho_pt(const CfdSolver *s, i32 idx){
+    const f64 *rho = s->rho, *vel = s->vel;
     return (
-        -vel[idx] * prho_px(idx) - rho[idx] * pvx_px(idx)
+        -vel[idx] * prho_px(s, idx) - rho[idx] * pvx_px(s, idx)
     );
 }
 
-f64 pprho_ppx(i32 idx){
+f64 pprho_ppx(const CfdSolver *s, i32 idx){
+    const f64 *rho = s->rho;
+    if (s->grid) return gridSecond(s->grid, rho, idx);
+    const i32 nx = s->nx;
+    const f64 dx = s->dx;
     if (idx == 0){
-        return (2*rho[0] - 5*rho[1] + 4*rho[2] - rho[3]) / (DX * DX);
-    } else if (idx == NX - 1){
-        return (2*rho[NX-1] - 5*rho[NX-2] + 4*rho[NX-3] - rho[NX-4]) / (DX * DX);
+        return (2*rho[0] - 5*rho[1] + 4*rho[2] - rho[3]) / (dx * dx);
+    } else if (idx == nx - 1){
+        return (2*rho[nx-1] - 5*rho[nx-2] + 4*rho[nx-3] - rho[nx-4]) / (dx * dx);
     } else {
-        return (rho[idx + 1] - 2 * rho[idx] + rho[idx - 1]) / (DX * DX);
+        return (rho[idx + 1] - 2 * rho[idx] + rho[idx - 1]) / (dx * dx);
     }
 }
 
-f64 ppvx_ppx(i32 idx){
+f64 ppvx_ppx(const CfdSolver *s, i32 idx){
+    const f64 *vel = s->vel;
+    if (s->grid) return gridSecond(s->grid, vel, idx);
+    const i32 nx = s->nx;
+    const f64 dx = s->dx;
     if (idx == 0){
         /* 左边界：二阶单边差分 (forward) */
-        return (2*vel[0] - 5*vel[1] + 4*vel[2] - vel[3]) / (DX * DX);
-    } else if (idx == NX - 1){
+        return (2*vel[0] - 5*vel[1] + 4*vel[2] - vel[3]) / (dx * dx);
+    } else if (idx == nx - 1){
         /* 右边界：二阶单边差分 (backward) */
-        return (2*vel[NX-1] - 5*vel[NX-2] + 4*vel[NX-3] - vel[NX-4]) / (DX * DX);
+        return (2*vel[nx-1] - 5*vel[nx-2] + 4*vel[nx-3] - vel[nx-4]) / (dx * dx);
     } else {
         /* 内部：二阶中心差分 */
-        return (vel[idx + 1] - 2 * vel[idx] + vel[idx - 1]) / (DX * DX);
+        return (vel[idx + 1] - 2 * vel[idx] + vel[idx - 1]) / (dx * dx);
     }
 }
 
-f64 ppvx_ppt(i32 idx, f64 time){
+f64 ppvx_ppt(const CfdSolver *s, i32 idx, f64 acc){
+    const f64 *rho = s->rho, *vel = s->vel;
     return (
-        -(-vel[idx] * pvx_px(idx) - K / rho[idx] * prho_px(idx) - getPistonAcceleration(time)) * pvx_px(idx)
-        -vel[idx] * (-pow(pvx_px(idx), 2) - vel[idx] * ppvx_ppx(idx) + K * pow(prho_px(idx) / rho[idx], 2) - K / rho[idx] * pprho_ppx(idx))
-        + K / pow(rho[idx], 2) * (-vel[idx] * prho_px(idx) - rho[idx] * pvx_px(idx)) * prho_px(idx)
-        - K / rho[idx] * (-pvx_px(idx) * prho_px(idx) - vel[idx] * pprho_ppx(idx) - prho_px(idx) * pvx_px(idx) - rho[idx] * ppvx_ppx(idx))
+        -(-vel[idx] * pvx_px(s, idx) - K / rho[idx] * prho_px(s, idx) - acc) * pvx_px(s, idx)
+        -vel[idx] * (-pow(pvx_px(s, idx), 2) - vel[idx] * ppvx_ppx(s, idx) + K * pow(prho_px(s, idx) / rho[idx], 2) - K / rho[idx] * pprho_ppx(s, idx))
+        + K / pow(rho[idx], 2) * (-vel[idx] * prho_px(s, idx) - rho[idx] * pvx_px(s, idx)) * prho_px(s, idx)
+        - K / rho[idx] * (-pvx_px(s, idx) * prho_px(s, idx) - vel[idx] * pprho_ppx(s, idx) - prho_px(s, idx) * pvx_px(s, idx) - rho[idx] * ppvx_ppx(s, idx))
     );
 }
 
-f64 pprho_ppt(i32 idx, f64 time){
-    f64 _pvx_px = pvx_px(idx);
-    f64 _prho_px = prho_px(idx);
-    f64 _getPistonAcc = getPistonAcceleration(time);
+f64 pprho_ppt(const CfdSolver *s, i32 idx, f64 acc){
+    const f64 *rho = s->rho, *vel = s->vel;
+    f64 _pvx_px = pvx_px(s, idx);
+    f64 _prho_px = prho_px(s, idx);
+    f64 _getPistonAcc = acc;
     f64 _vel = vel[idx];
     f64 _rho = rho[idx];
-    f64 _pprho_ppx = pprho_ppx(idx);
-    f64 _ppvx_ppx = ppvx_ppx(idx);
+    f64 _pprho_ppx = pprho_ppx(s, idx);
+    f64 _ppvx_ppx = ppvx_ppx(s, idx);
     
-    f64 _term1 = -(-vel[idx] * pvx_px(idx) - K / rho[idx] * prho_px(idx) - getPistonAcceleration(time)) * prho_px(idx);
-    f64 _term2 = -vel[idx] * (-pvx_px(idx) * prho_px(idx) - vel[idx] * pprho_ppx(idx) - prho_px(idx) * pvx_px(idx) - rho[idx] * ppvx_ppx(idx));
-    f64 _term3 = -(-vel[idx] * prho_px(idx) - rho[idx] * pvx_px(idx)) * pvx_px(idx);
-    f64 _term4 = -rho[idx] * (-pow(pvx_px(idx), 2) - vel[idx] * ppvx_ppx(idx) + K * pow(prho_px(idx) / rho[idx], 2) - K / rho[idx] * pprho_ppx(idx));
+    f64 _term1 = -(-vel[idx] * pvx_px(s, idx) - K / rho[idx] * prho_px(s, idx) - acc) * prho_px(s, idx);
+    f64 _term2 = -vel[idx] * (-pvx_px(s, idx) * prho_px(s, idx) - vel[idx] * pprho_ppx(s, idx) - prho_px(s, idx) * pvx_px(s, idx) - rho[idx] * ppvx_ppx(s, idx));
+    f64 _term3 = -(-vel[idx] * prho_px(s, idx) - rho[idx] * pvx_px(s, idx)) * pvx_px(s, idx);
+    f64 _term4 = -rho[idx] * (-pow(pvx_px(s, idx), 2) - vel[idx] * ppvx_ppx(s, idx) + K * pow(prho_px(s, idx) / rho[idx], 2) - K / rho[idx] * pprho_ppx(s, idx));
     return (
         _term1
         + _term2
@@ -86,6 +129,7 @@ f64 pprho_ppt(i32 idx, f64 time){
     );
 }
 
-f64 pvx_pt(i32 idx, f64 time){
-    return -vel[idx] * pvx_px(idx) - K / rho[idx] * prho_px(idx) - getPistonAcceleration(time);
+f64 pvx_pt(const CfdSolver *s, i32 idx, f64 acc){
+    const f64 *rho = s->rho, *vel = s->vel;
+    return -vel[idx] * pvx_px(s, idx) - K / rho[idx] * prho_px(s, idx) - acc;
 }
\ No newline at end of file
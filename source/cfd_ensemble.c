@@ -0,0 +1,583 @@
+/*
+    source/cfd_ensemble.c
+    集合运行：成员列表的读取、交错布局的集合求解器与两种运行方式
+*/
+#include "cfd_ensemble.h"
+#include "cfd_output.h"
+#include "cfd_simd.h"
+#include "cfd_stencil.h"
+#include "cfd_stepper.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* 去掉首尾空白，返回指向原缓冲区内的起始位置 */
+static char *trim(char *s)
+{
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+i32 cfdEnsembleMemberSet(CfdEnsembleMember *mb, const char *key, const char *value)
+{
+    char *end;
+    if (strcmp(key, "name") == 0)
+    {
+        if (value[0] == '\0' || strlen(value) >= CFD_ENSEMBLE_NAME_MAX || strpbrk(value, "/\\") != NULL)
+        {
+            printf("[ERROR] Invalid member name '%s'\n", value);
+            return -1;
+        }
+        strcpy(mb->name, value);
+        return 0;
+    }
+    if (strcmp(key, "harmonic") == 0)
+    {
+        long n = strtol(value, &end, 10);
+        char *rest = end;
+        f64 a = strtod(rest, &end);
+        if (end == rest) n = 0;
+        rest = end;
+        f64 b = strtod(rest, &end);
+        if (end == rest || *trim(end) != '\0' || n < 1 || n > PISTON_HARMONICS)
+        {
+            printf("[ERROR] harmonic must be 'n a_n b_n' with 1 <= n <= %d (got '%s')\n", PISTON_HARMONICS, value);
+            return -1;
+        }
+        mb->profile.coef[n - 1][0] = a;
+        mb->profile.coef[n - 1][1] = b;
+        return 0;
+    }
+    if (strcmp(key, "harmonics") == 0)
+    {
+        long n = strtol(value, &end, 10);
+        if (end == value || *end != '\0' || n < 0 || n > PISTON_HARMONICS)
+        {
+            printf("[ERROR] harmonics must be between 0 and %d (got '%s')\n", PISTON_HARMONICS, value);
+            return -1;
+        }
+        for (i32 k = (i32)n; k < PISTON_HARMONICS; k++)
+        {
+            mb->profile.coef[k][0] = 0.0;
+            mb->profile.coef[k][1] = 0.0;
+        }
+        return 0;
+    }
+
+    f64 *target = NULL;
+    if (strcmp(key, "period") == 0)         target = &mb->profile.period;
+    else if (strcmp(key, "dc") == 0)        target = &mb->profile.dc;
+    else if (strcmp(key, "amplitude") == 0) target = &mb->profile.amplitude;
+    if (target == NULL)
+    {
+        printf("[ERROR] Unknown member parameter '%s'\n", key);
+        return -1;
+    }
+    f64 v = strtod(value, &end);
+    if (end == value || *end != '\0')
+    {
+        printf("[ERROR] Invalid number for %s: '%s'\n", key, value);
+        return -1;
+    }
+    if (target == &mb->profile.period && !(v > 0))
+    {
+        printf("[ERROR] period must be positive (got '%s')\n", value);
+        return -1;
+    }
+    *target = v;
+    return 0;
+}
+
+i32 cfdEnsembleLoad(const char *path, CfdEnsembleMember **members, i32 *count)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL)
+    {
+        printf("[ERROR] Cannot open ensemble file %s\n", path);
+        return -1;
+    }
+
+    CfdEnsembleMember common;
+    memset(&common, 0, sizeof(common));
+    pistonProfileDefault(&common.profile);
+    CfdEnsembleMember *list = NULL;
+    i32 n = 0;
+    CfdEnsembleMember *current = &common;
+    char line[1024];
+    i32 lineno = 0;
+    i32 status = 0;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *text = trim(line);
+        if (*text == '\0') continue;
+
+        if (strcmp(text, "[member]") == 0)
+        {
+            CfdEnsembleMember *grown = (CfdEnsembleMember *)realloc(list, sizeof(CfdEnsembleMember) * (n + 1));
+            if (!grown)
+            {
+                printf("[ERROR] Memory allocation failed while reading %s\n", path);
+                status = -1;
+                break;
+            }
+            list = grown;
+            list[n] = common;
+            snprintf(list[n].name, sizeof(list[n].name), "member_%03d", n);
+            current = &list[n];
+            n++;
+            continue;
+        }
+
+        char *eq = strchr(text, '=');
+        if (eq == NULL)
+        {
+            printf("[ERROR] %s:%d: expected 'key = value'\n", path, lineno);
+            status = -1;
+            break;
+        }
+        *eq = '\0';
+        if (cfdEnsembleMemberSet(current, trim(text), trim(eq + 1)) != 0)
+        {
+            printf("[ERROR] %s:%d: invalid entry\n", path, lineno);
+            status = -1;
+            break;
+        }
+    }
+    fclose(in);
+
+    if (status == 0 && n == 0)
+    {
+        printf("[ERROR] %s defines no [member] sections\n", path);
+        status = -1;
+    }
+    for (i32 a = 0; status == 0 && a < n; a++)
+    {
+        for (i32 b = a + 1; b < n; b++)
+        {
+            if (strcmp(list[a].name, list[b].name) == 0)
+            {
+                printf("[ERROR] %s: duplicate member name '%s'\n", path, list[a].name);
+                status = -1;
+                break;
+            }
+        }
+    }
+    if (status != 0)
+    {
+        free(list);
+        return -1;
+    }
+    *members = list;
+    *count = n;
+    return 0;
+}
+
+CfdEnsemble *cfdEnsembleCreate(const CfdConfig *cfg, const CfdEnsembleMember *members, i32 count)
+{
+    CfdEnsemble *e = (CfdEnsemble *)calloc(1, sizeof(CfdEnsemble));
+    if (!e)
+    {
+        printf("[ERROR] Memory allocation failed while creating ensemble\n");
+        return NULL;
+    }
+    e->nx = cfg->nx;
+    e->members = count;
+    e->dx = cfg->dx;
+    e->dt = cfg->dt;
+    e->half_dt2 = cfg->dt * cfg->dt / 2;
+    e->simd = cfdSimdResolve(cfg->simd);
+    cfdEosIsothermal(&e->eos, T_INIT);
+
+    size_t bytes = sizeof(f64) * (size_t)cfg->nx * (size_t)count;
+    e->rho = (f64 *)malloc(bytes);
+    e->vel = (f64 *)malloc(bytes);
+    e->rho_next = (f64 *)malloc(bytes);
+    e->vel_next = (f64 *)malloc(bytes);
+    e->pa = (PistonAccel *)malloc(sizeof(PistonAccel) * (size_t)count);
+    e->acc = (f64 *)malloc(sizeof(f64) * (size_t)count);
+    if (!e->rho || !e->vel || !e->rho_next || !e->vel_next || !e->pa || !e->acc)
+    {
+        printf("[ERROR] Memory allocation failed for %d members of NX=%d\n", count, cfg->nx);
+        cfdEnsembleDestroy(e);
+        return NULL;
+    }
+
+    const i32 nx = e->nx, M = e->members;
+    /* 首次写入按网格点做 static 划分，与核的划分一致 */
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (i32 i = 0; i < nx; i++)
+    {
+        for (i32 m = 0; m < M; m++)
+        {
+            size_t k = (size_t)i * M + m;
+            e->rho[k] = e->rho_next[k] = RHO_INIT;
+            e->vel[k] = e->vel_next[k] = 0.0;
+        }
+    }
+    for (i32 m = 0; m < M; m++)
+    {
+        pistonAccelInit(&e->pa[m], &members[m].profile, 0.0, e->dt, cfg->piston_source, cfg->piston_recurrence);
+        e->acc[m] = e->pa[m].acc;
+    }
+    cfdTimersReset(&e->timers);
+    e->t = 0.0;
+    e->step = 0;
+    printf("[INFO] Ensemble of %d members initialized (interleaved layout, %s kernel)\n",
+           count, cfdSimdName(e->simd));
+    return e;
+}
+
+void cfdEnsembleDestroy(CfdEnsemble *e)
+{
+    if (!e) return;
+    free(e->rho);
+    free(e->vel);
+    free(e->rho_next);
+    free(e->vel_next);
+    free(e->pa);
+    free(e->acc);
+    free(e);
+}
+
+/* 网格点 i 上全部成员的更新，成员维连续，由 omp simd 按所在函数的指令集向量化 */
+static CFD_ALWAYS_INLINE void ensemblePoint(CfdEnsemble *e, i32 i)
+{
+    const size_t M = (size_t)e->members;
+    const f64 *restrict rl = e->rho + (i - 1) * M;
+    const f64 *restrict rc = rl + M;
+    const f64 *restrict rr = rc + M;
+    const f64 *restrict vl = e->vel + (i - 1) * M;
+    const f64 *restrict vc = vl + M;
+    const f64 *restrict vr = vc + M;
+    const f64 *restrict acc = e->acc;
+    f64 *restrict nr = e->rho_next + i * M;
+    f64 *restrict nv = e->vel_next + i * M;
+    const f64 dt = e->dt;
+    const f64 half_dt2 = e->half_dt2;
+    const f64 inv_2dx = 1.0 / (2 * e->dx);
+    const f64 inv_dx2 = 1.0 / (e->dx * e->dx);
+#pragma omp simd
+    for (size_t m = 0; m < M; m++)
+    {
+        f64 rho_t, rho_tt, vel_t, vel_tt;
+        fusedDerivs(rl[m], rc[m], rr[m], vl[m], vc[m], vr[m], inv_2dx, inv_dx2, acc[m],
+                    &rho_t, &rho_tt, &vel_t, &vel_tt);
+        nr[m] = rc[m] + dt * rho_t + half_dt2 * rho_tt;
+        nv[m] = vc[m] + dt * vel_t + half_dt2 * vel_tt;
+    }
+}
+
+static void ensembleGeneric(CfdEnsemble *e, i32 i) { ensemblePoint(e, i); }
+
+#ifdef CFD_SIMD_X86
+CFD_TARGET("avx2")
+static void ensembleAvx2(CfdEnsemble *e, i32 i) { ensemblePoint(e, i); }
+
+CFD_TARGET("avx512f")
+static void ensembleAvx512(CfdEnsemble *e, i32 i) { ensemblePoint(e, i); }
+#endif
+
+static void ensembleInterior(CfdEnsemble *e)
+{
+    void (*point)(CfdEnsemble *, i32) = ensembleGeneric;
+#ifdef CFD_SIMD_X86
+    if (e->simd == CFD_SIMD_AVX512)     point = ensembleAvx512;
+    else if (e->simd == CFD_SIMD_AVX2)  point = ensembleAvx2;
+#endif
+    const i32 nx = e->nx;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE)
+#endif
+    for (i32 i = 1; i < nx - 1; i++)
+    {
+        point(e, i);
+    }
+}
+
+/* 各成员的边界，与 updateBorders 相同；须在内部点之前，要读 rho_next 中上一步的密度 */
+static void ensembleBorders(CfdEnsemble *e)
+{
+    const i32 M = e->members;
+    const size_t c = (size_t)(e->nx - 1) * M, l = c - M;
+    for (i32 m = 0; m < M; m++)
+    {
+        const f64 p_diff = cfdEosPressure(&e->eos, e->rho_next[c + m]) - cfdEosPressure(&e->eos, e->rho_next[l + m]);
+        const f64 r_m = e->rho[l + m], r_c = e->rho[c + m];
+        const f64 v_m = e->vel[l + m], v_c = e->vel[c + m];
+        e->vel_next[c + m] = borderVelRight(r_c, v_m, v_c, p_diff, e->dx, e->dt, e->acc[m]);
+        e->vel_next[m] = 0.0;
+        e->rho_next[c + m] = borderRhoRight(r_m, r_c, v_m, v_c, e->dx, e->dt);
+        e->rho_next[m] = borderRhoLeft(e->rho[m], e->vel[m], e->vel[M + m], e->dx, e->dt);
+    }
+}
+
+void cfdEnsembleStep(CfdEnsemble *e)
+{
+    CfdTimers *tm = &e->timers;
+    const f64 points = (f64)e->nx * e->members;
+    f64 t0 = cfdWallTime();
+    ensembleBorders(e);
+    t0 = cfdTimersAdd(tm, CFD_PHASE_BORDER, t0, 0.0);
+    ensembleInterior(e);
+    t0 = cfdTimersAdd(tm, CFD_PHASE_FUSED, t0, 4 * sizeof(f64) * points);
+
+    f64 *tmp;
+    tmp = e->rho; e->rho = e->rho_next; e->rho_next = tmp;
+    tmp = e->vel; e->vel = e->vel_next; e->vel_next = tmp;
+    t0 = cfdTimersAdd(tm, CFD_PHASE_SWAP, t0, 0.0);
+
+    e->t += e->dt;
+    e->step++;
+    for (i32 m = 0; m < e->members; m++)
+    {
+        e->acc[m] = pistonAccelAdvance(&e->pa[m]);
+    }
+    cfdTimersAdd(tm, CFD_PHASE_PISTON, t0, 0.0);
+}
+
+void cfdEnsembleGather(const CfdEnsemble *e, i32 m, f64 *rho, f64 *vel, f64 *pres)
+{
+    const i32 nx = e->nx;
+    const size_t M = (size_t)e->members;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (i32 i = 0; i < nx; i++)
+    {
+        rho[i] = e->rho[i * M + m];
+        vel[i] = e->vel[i * M + m];
+        pres[i] = cfdEosPressure(&e->eos, e->rho_next[i * M + m]);
+    }
+}
+
+/* 成员的运行参数：快照写到 <output_dir>/<name>/，同步写出（成员很多时不为每个成员开写线程） */
+static i32 memberConfig(const CfdConfig *cfg, const CfdEnsembleMember *mb, CfdConfig *out)
+{
+    *out = *cfg;
+    out->output_queue = 0;
+    out->ensemble[0] = '\0';
+    i32 n = snprintf(out->output_dir, sizeof(out->output_dir), "%s/%s", cfg->output_dir, mb->name);
+    if (n < 0 || n >= (i32)sizeof(out->output_dir))
+    {
+        printf("[ERROR] Output path for member '%s' is too long\n", mb->name);
+        return -1;
+    }
+    if (mkdir(out->output_dir, 0755) != 0 && errno != EEXIST)
+    {
+        printf("[ERROR] Cannot create %s\n", out->output_dir);
+        return -1;
+    }
+    return 0;
+}
+
+static i32 runInterleaved(const CfdConfig *cfg, const CfdEnsembleMember *members, i32 count)
+{
+    CfdEnsemble *e = cfdEnsembleCreate(cfg, members, count);
+    if (e == NULL) return -1;
+
+    /* 输出模块读取 CfdSolver 中的网格参数与 rho/vel/pres，每个成员先取到这三个缓冲区 */
+    const size_t nx = (size_t)e->nx;
+    f64 *buffer = (f64 *)malloc(sizeof(f64) * 3 * nx);
+    CfdOutput **outputs = (CfdOutput **)calloc((size_t)count, sizeof(CfdOutput *));
+    CfdSolver view;
+    memset(&view, 0, sizeof(view));
+    view.nx = e->nx;
+    view.dx = e->dx;
+    view.dt = e->dt;
+    view.synced = 1;
+    i32 status = buffer && outputs ? 0 : -1;
+    if (status != 0) printf("[ERROR] Memory allocation failed for ensemble output\n");
+    if (buffer)
+    {
+        view.rho = buffer;
+        view.vel = buffer + nx;
+        view.pres = buffer + 2 * nx;
+    }
+    for (i32 m = 0; status == 0 && m < count; m++)
+    {
+        CfdConfig mcfg;
+        status = memberConfig(cfg, &members[m], &mcfg);
+        if (status == 0)
+        {
+            outputs[m] = cfdOutputOpen(&mcfg, &view);
+            if (outputs[m] == NULL) status = -1;
+        }
+    }
+
+    i64 maxSteps = (i64)(cfg->t_end / cfg->dt) + 1;
+    f64 total_timer = 0.0;
+    CfdProgress progress_report;
+    cfdProgressBegin(&progress_report, cfg->quiet, 0, 0.0);
+    i64 step;
+    for (step = 0; status == 0 && step < maxSteps; step++)
+    {
+        cfdEnsembleStep(e);
+        if (step % cfg->print_after_steps == 0 || step == maxSteps - 1)
+        {
+            cfdProgressUpdate(&progress_report, e->t, step, maxSteps, (f64)step / maxSteps, NULL);
+        }
+        if (e->t > total_timer)
+        {
+            f64 t0 = cfdWallTime();
+            total_timer += cfg->timer;
+            view.t = e->t;
+            for (i32 m = 0; m < count; m++)
+            {
+                cfdEnsembleGather(e, m, view.rho, view.vel, view.pres);
+                cfdOutputWrite(outputs[m], &view);
+            }
+            cfdTimersAdd(&e->timers, CFD_PHASE_OUTPUT, t0, 0.0);
+        }
+    }
+
+    f64 t0 = cfdWallTime();
+    for (i32 m = 0; outputs && m < count; m++) cfdOutputClose(outputs[m]);
+    cfdTimersAdd(&e->timers, CFD_PHASE_OUTPUT, t0, 0.0);
+    f64 wall = cfdWallTime() - progress_report.start;
+    cfdProgressEnd(&progress_report, step);
+
+    if (status == 0)
+    {
+        char perf_path[CFD_PATH_MAX + 64];
+        if (cfg->perf_json[0] != '\0')
+            snprintf(perf_path, sizeof(perf_path), "%s", cfg->perf_json);
+        else
+            snprintf(perf_path, sizeof(perf_path), "%s/perf.json", cfg->output_dir);
+        /* 点更新数按 nx * 成员数计 */
+        cfdReportSummary(&e->timers, e->nx * count, step, wall, perf_path);
+    }
+    free(outputs);
+    free(buffer);
+    cfdEnsembleDestroy(e);
+    return status;
+}
+
+/* 一个成员从头到尾的固定步长运行，与 sim 的逐步推进相同 */
+static i32 runMember(const CfdConfig *mcfg, const CfdEnsembleMember *mb)
+{
+    CfdSolver *s = cfdSolverCreate(mcfg);
+    if (s == NULL) return -1;
+    cfdSolverSetProfile(s, &mb->profile);
+    CfdOutput *output = cfdOutputOpen(mcfg, s);
+    if (output == NULL)
+    {
+        cfdSolverDestroy(s);
+        return -1;
+    }
+    i64 maxSteps = (i64)(mcfg->t_end / mcfg->dt) + 1;
+    f64 total_timer = 0.0;
+    for (i64 step = 0; step < maxSteps; step++)
+    {
+        cfdSolverStep(s);
+        if (s->t > total_timer)
+        {
+            total_timer += mcfg->timer;
+            cfdSolverSync(s);
+            cfdOutputWrite(output, s);
+        }
+    }
+    cfdOutputClose(output);
+    cfdSolverDestroy(s);
+    return 0;
+}
+
+static i32 runMembers(const CfdConfig *cfg, const CfdEnsembleMember *members, i32 count)
+{
+    i32 failed = 0;
+    i32 done = 0;
+    f64 start = cfdWallTime();
+#ifdef _OPENMP
+    /* 成员之间并行，每个成员内部的核不再嵌套并行 */
+    i32 levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:failed)
+#endif
+    for (i32 m = 0; m < count; m++)
+    {
+        CfdConfig mcfg;
+        i32 status = memberConfig(cfg, &members[m], &mcfg);
+        if (status == 0) status = runMember(&mcfg, &members[m]);
+        if (status != 0) failed++;
+        i32 finished;
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+        finished = ++done;
+        if (!cfg->quiet)
+        {
+            printf("[INFO] Member %s finished (%d/%d)%s\n", members[m].name, finished, count, status ? " with errors" : "");
+        }
+    }
+#ifdef _OPENMP
+    omp_set_max_active_levels(levels);
+#endif
+    f64 wall = cfdWallTime() - start;
+    i64 steps = (i64)(cfg->t_end / cfg->dt) + 1;
+    printf("[INFO] Ensemble of %d members: %.3f s wall, %.2f Mpoint-updates/s\n", count, wall,
+           wall > 0.0 ? (f64)cfg->nx * count * steps / wall * 1e-6 : 0.0);
+    return failed ? -1 : 0;
+}
+
+i32 cfdEnsembleRun(const CfdConfig *cfg)
+{
+    CfdEnsembleMember *members = NULL;
+    i32 count = 0;
+    if (cfdEnsembleLoad(cfg->ensemble, &members, &count) != 0) return -1;
+
+    printf("[INFO] Ensemble: %d members from %s, %s layout\n", count, cfg->ensemble,
+           cfg->ensemble_layout == CFD_ENSEMBLE_MEMBER ? "one member per thread" : "interleaved");
+    if (cfg->cfl > 0)
+    {
+        printf("[WARN] Ensemble runs use the fixed time step dt=%.3e; cfl is ignored.\n", cfg->dt);
+    }
+    CfdConfig run = *cfg;
+    run.cfl = 0.0;
+
+    i32 status;
+    if (cfg->ensemble_layout == CFD_ENSEMBLE_MEMBER)
+    {
+        status = runMembers(&run, members, count);
+    }
+    else
+    {
+        if (cfg->precision != CFD_PRECISION_DOUBLE)
+        {
+            printf("[WARN] The interleaved ensemble layout stores float64 fields; precision is ignored.\n");
+        }
+        if (cfg->stepper != CFD_STEPPER_TAYLOR)
+        {
+            printf("[WARN] The interleaved ensemble layout uses the taylor stepper; stepper %s is ignored.\n",
+                   cfdStepperName(cfg->stepper));
+        }
+        if (cfg->grid_stretch > 0)
+        {
+            printf("[WARN] The interleaved ensemble layout uses the uniform grid; grid_stretch is ignored.\n");
+        }
+        if (cfg->active_region)
+        {
+            printf("[WARN] The interleaved ensemble layout updates every cell; active_region is ignored.\n");
+        }
+        status = runInterleaved(&run, members, count);
+    }
+    free(members);
+    return status;
+}
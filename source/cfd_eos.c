@@ -0,0 +1,50 @@
+/*
+    source/cfd_eos.c
+    状态方程挂钩的实现
+*/
+#include "cfd_eos.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+static f64 isothermalPressure(const CfdEos *eos, f64 rho)
+{
+    return eos->gas_constant * rho * eos->temperature;
+}
+
+void cfdEosIsothermal(CfdEos *eos, f64 temperature)
+{
+    eos->name = "isothermal";
+    eos->pressure = isothermalPressure;
+    eos->gas_constant = R / MU_STAR;
+    eos->temperature = temperature;
+}
+
+i32 cfdEosIsIsothermal(const CfdEos *eos)
+{
+    return eos->pressure == isothermalPressure;
+}
+
+void cfdEosFill(const CfdEos *eos, const f64 *rho, f64 *pres, i32 n)
+{
+    /* 等温模型直接展开，循环可以向量化；其他模型逐点调用挂钩 */
+    if (eos->pressure == isothermalPressure)
+    {
+        const f64 c = eos->gas_constant, T = eos->temperature;
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(static)
+#endif
+        for (i32 i = 0; i < n; i++)
+        {
+            pres[i] = c * rho[i] * T;
+        }
+        return;
+    }
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (i32 i = 0; i < n; i++)
+    {
+        pres[i] = cfdEosPressure(eos, rho[i]);
+    }
+}
@@ -0,0 +1,70 @@
+/*
+    source/cfd_grid.c
+    拉伸网格的坐标与逐点差分系数
+*/
+#include "cfd_grid.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+f64 cfdGridMap(f64 xi, f64 stretch)
+{
+    if (!(stretch > 0)) return xi;
+    return 1.0 - tanh(stretch * (1.0 - xi)) / tanh(stretch);
+}
+
+CfdGrid *cfdGridCreate(i32 nx, f64 length, f64 stretch)
+{
+    CfdGrid *g = (CfdGrid *)calloc(1, sizeof(CfdGrid));
+    if (!g)
+    {
+        printf("[ERROR] Memory allocation failed for the stretched grid\n");
+        return NULL;
+    }
+    size_t bytes = sizeof(f64) * (size_t)nx;
+    g->nx = nx;
+    g->stretch = stretch;
+    g->length = length;
+    g->x = (f64 *)malloc(bytes);
+    g->d1 = (f64 *)malloc(bytes);
+    g->d1s = (f64 *)malloc(bytes);
+    g->d2 = (f64 *)malloc(bytes);
+    g->d2s = (f64 *)malloc(bytes);
+    if (!g->x || !g->d1 || !g->d1s || !g->d2 || !g->d2s)
+    {
+        printf("[ERROR] Memory allocation failed for the stretched grid\n");
+        cfdGridDestroy(g);
+        return NULL;
+    }
+
+    const f64 h = 1.0 / (nx - 1);
+    for (i32 i = 0; i < nx; i++) g->x[i] = length * cfdGridMap(i * h, stretch);
+    g->x[nx - 1] = length;
+    for (i32 i = 1; i < nx - 1; i++)
+    {
+        /* 过 (i-1, i, i+1) 三点的抛物线的一阶、二阶导数，写成中心差分加修正项 */
+        const f64 hm = g->x[i] - g->x[i - 1], hp = g->x[i + 1] - g->x[i];
+        const f64 ar = hm / (hp * (hm + hp)), al = hp / (hm * (hm + hp));
+        const f64 br = 2.0 / (hp * (hm + hp)), bl = 2.0 / (hm * (hm + hp));
+        g->d1[i] = 0.5 * (ar + al);
+        g->d1s[i] = 0.5 * (ar - al);
+        g->d2[i] = 0.5 * (br + bl);
+        g->d2s[i] = 0.5 * (br - bl);
+    }
+    g->d1[0] = g->d1s[0] = g->d2[0] = g->d2s[0] = 0.0;
+    g->d1[nx - 1] = g->d1s[nx - 1] = g->d2[nx - 1] = g->d2s[nx - 1] = 0.0;
+    g->dx_min = g->x[1] - g->x[0];
+    g->dx_max = g->x[nx - 1] - g->x[nx - 2];
+    return g;
+}
+
+void cfdGridDestroy(CfdGrid *g)
+{
+    if (!g) return;
+    free(g->x);
+    free(g->d1);
+    free(g->d1s);
+    free(g->d2);
+    free(g->d2s);
+    free(g);
+}
@@ -0,0 +1,252 @@
+/*
+    source/cfd_mixed.c
+    混合精度模式：f32 存储、f64 计算的推进步，以及相对 f64 解的误差报告
+*/
+#include "cfd_mixed.h"
+#include "cfd_simd.h"
+#include "cfd_stencil.h"
+#include <stdlib.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+i32 cfdMixedAlloc(CfdSolver *s)
+{
+    size_t bytes = sizeof(f32) * (size_t)s->nx;
+    s->drho = (f32 *)malloc(bytes);
+    s->drho_next = (f32 *)malloc(bytes);
+    s->vel32 = (f32 *)malloc(bytes);
+    s->vel32_next = (f32 *)malloc(bytes);
+    if (!s->drho || !s->drho_next || !s->vel32 || !s->vel32_next) return -1;
+    if (s->derived_pressure) return 0;
+    s->dpres = (f32 *)malloc(bytes);
+    s->dpres_next = (f32 *)malloc(bytes);
+    return s->dpres && s->dpres_next ? 0 : -1;
+}
+
+void cfdMixedFree(CfdSolver *s)
+{
+    free(s->drho);
+    free(s->drho_next);
+    free(s->vel32);
+    free(s->vel32_next);
+    free(s->dpres);
+    free(s->dpres_next);
+}
+
+void cfdMixedInit(CfdSolver *s)
+{
+    const i32 nx = s->nx;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < nx; i++)
+    {
+        s->drho[i] = s->drho_next[i] = 0.0f;
+        s->vel32[i] = s->vel32_next[i] = 0.0f;
+        if (s->dpres) s->dpres[i] = s->dpres_next[i] = 0.0f;
+        s->rho[i] = RHO_INIT;
+        s->vel[i] = 0.0;
+        s->pres[i] = P_INIT;
+    }
+    s->synced = 1;
+    printf("[INFO] FlowField Initialized (mixed precision: f32 storage, f64 arithmetic).\n");
+}
+
+/*
+    边界更新，须在内部点核之前调用。右边界的压力差不从 dpres 取：相邻点的压力差约为 dpres 本身的 1e-5，
+    f32 舍入会吃掉其中一两位有效数字。压力滞后密度一步，由上一步的密度（交换后在 drho_next 中）
+    经状态方程求出，与导出压力模式相同。
+*/
+static void mixedBorders(CfdSolver *s, f64 acc)
+{
+    const i32 i = s->nx - 1;
+    const f32 *drho = s->drho, *vel = s->vel32, *prev = s->drho_next;
+    const f64 r_m = RHO_INIT + (f64)drho[i - 1], r_c = RHO_INIT + (f64)drho[i];
+    const f64 v_m = (f64)vel[i - 1], v_c = (f64)vel[i];
+    const f64 p_diff = cfdEosPressure(&s->eos, RHO_INIT + (f64)prev[i])
+                     - cfdEosPressure(&s->eos, RHO_INIT + (f64)prev[i - 1]);
+
+    s->vel32_next[i] = (f32)borderVelRight(r_c, v_m, v_c, p_diff, s->dx, s->dt, acc);
+    s->vel32_next[0] = 0.0f;
+    s->drho_next[i] = (f32)(borderRhoRight(r_m, r_c, v_m, v_c, s->dx, s->dt) - RHO_INIT);
+    s->drho_next[0] = (f32)(borderRhoLeft(RHO_INIT + (f64)drho[0], (f64)vel[0], (f64)vel[1], s->dx, s->dt) - RHO_INIT);
+}
+
+void cfdMixedStep(CfdSolver *s)
+{
+    CfdTimers *tm = &s->timers;
+    const i32 nx = s->nx;
+    const f64 acc = s->pa.acc;
+    f64 t0 = cfdWallTime();
+
+    mixedBorders(s, acc);
+    t0 = cfdTimersAdd(tm, CFD_PHASE_BORDER, t0, 0.0);
+
+    /* 看门狗的归约与 f64 路径相同（见 cfdSolverStep），两端边界点也计入 */
+    CfdWatchSums *w = s->watch.enabled ? &s->watch.sums : NULL;
+    f64 vmax = 0.0, rmin = INFINITY, bad = 0.0;
+    if (w)
+    {
+        watchPoint(RHO_INIT + (f64)s->drho_next[0], (f64)s->vel32_next[0], &vmax, &rmin, &bad);
+        watchPoint(RHO_INIT + (f64)s->drho_next[nx - 1], (f64)s->vel32_next[nx - 1], &vmax, &rmin, &bad);
+    }
+    const i32 blocks = (nx - 2 + CFD_SIMD_BLOCK - 1) / CFD_SIMD_BLOCK;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE) reduction(max:vmax) reduction(min:rmin) reduction(+:bad)
+#endif
+    for (i32 b = 0; b < blocks; b++)
+    {
+        i32 lo = 1 + b * CFD_SIMD_BLOCK;
+        i32 hi = lo + CFD_SIMD_BLOCK < nx - 1 ? lo + CFD_SIMD_BLOCK : nx - 1;
+        CfdWatchSums part = {vmax, rmin, bad};
+        cfdSimdInteriorMixed(s->simd, s, acc, lo, hi, w ? &part : NULL);
+        vmax = part.vmax;
+        rmin = part.rmin;
+        bad = part.bad;
+    }
+    if (w)
+    {
+        w->vmax = vmax;
+        w->rmin = rmin;
+        w->bad = bad;
+    }
+    t0 = cfdTimersAdd(tm, CFD_PHASE_FUSED, t0, 4 * sizeof(f32) * (f64)nx);
+
+    f32 *tmp;
+    if (!s->derived_pressure)
+    {
+        /* 与 f64 路径相同，新压力由当前步的密度给出 */
+        const f32 *drho = s->drho;
+        f32 *new_dpres = s->dpres_next;
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(CFD_OMP_SCHEDULE)
+#endif
+        for (int i = 0; i < nx; i++)
+        {
+            new_dpres[i] = (f32)(R / MU_STAR * (RHO_INIT + (f64)drho[i]) * T_INIT - P_INIT);
+        }
+        t0 = cfdTimersAdd(tm, CFD_PHASE_PRESSURE, t0, 2 * sizeof(f32) * (f64)nx);
+        tmp = s->dpres; s->dpres = s->dpres_next; s->dpres_next = tmp;
+    }
+
+    tmp = s->drho;  s->drho = s->drho_next;   s->drho_next = tmp;
+    tmp = s->vel32; s->vel32 = s->vel32_next; s->vel32_next = tmp;
+    s->synced = 0;
+    cfdTimersAdd(tm, CFD_PHASE_SWAP, t0, 0.0);
+}
+
+f64 cfdMixedMaxSpeed(const CfdSolver *s)
+{
+    const i32 nx = s->nx;
+    const f32 *vel = s->vel32;
+    f64 vmax = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(max:vmax)
+#endif
+    for (int i = 0; i < nx; i++)
+    {
+        f64 v = fabs((f64)vel[i]);
+        if (v > vmax) vmax = v;
+    }
+    return vmax;
+}
+
+void cfdMixedExpand(CfdSolver *s)
+{
+    const i32 nx = s->nx;
+    const f32 *dpres = s->dpres;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+    for (int i = 0; i < nx; i++)
+    {
+        s->rho[i] = RHO_INIT + (f64)s->drho[i];
+        s->vel[i] = (f64)s->vel32[i];
+        if (dpres) s->pres[i] = P_INIT + (f64)dpres[i];
+    }
+}
+
+i32 cfdSolverPrecisionError(CfdSolver *s, CfdPrecisionError *err)
+{
+    CfdSolver *ref = s->shadow;
+    if (ref == NULL) return -1;
+    cfdSolverSync(s);
+    cfdSolverSync(ref);
+
+    const i32 nx = s->nx;
+    f64 e_rho = 0.0, e_vel = 0.0, e_pres = 0.0;
+    f64 m_rho = 0.0, m_vel = 0.0, m_pres = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(max:e_rho, e_vel, e_pres, m_rho, m_vel, m_pres)
+#endif
+    for (int i = 0; i < nx; i++)
+    {
+        f64 d;
+        d = fabs(s->rho[i] - ref->rho[i]);      if (d > e_rho) e_rho = d;
+        d = fabs(s->vel[i] - ref->vel[i]);      if (d > e_vel) e_vel = d;
+        d = fabs(s->pres[i] - ref->pres[i]);    if (d > e_pres) e_pres = d;
+        d = fabs(ref->rho[i] - RHO_INIT);       if (d > m_rho) m_rho = d;
+        d = fabs(ref->vel[i]);                  if (d > m_vel) m_vel = d;
+        d = fabs(ref->pres[i] - P_INIT);        if (d > m_pres) m_pres = d;
+    }
+    err->abs_err[0] = e_rho;
+    err->abs_err[1] = e_vel;
+    err->abs_err[2] = e_pres;
+    /* 流场尚未扰动时没有可比的幅度，相对误差记为 0 */
+    err->rel_err[0] = m_rho > 0.0 ? e_rho / m_rho : 0.0;
+    err->rel_err[1] = m_vel > 0.0 ? e_vel / m_vel : 0.0;
+    err->rel_err[2] = m_pres > 0.0 ? e_pres / m_pres : 0.0;
+    return 0;
+}
+
+i32 cfdPrecisionReportOpen(CfdPrecisionReport *rep, const char *dir)
+{
+    char filename[CFD_PATH_MAX + 64];
+    rep->samples = 0;
+    for (i32 k = 0; k < 3; k++)
+    {
+        rep->max.abs_err[k] = 0.0;
+        rep->max.rel_err[k] = 0.0;
+    }
+    snprintf(filename, sizeof(filename), "%s/precision.csv", dir);
+    rep->csv = fopen(filename, "w");
+    if (rep->csv == NULL)
+    {
+        printf("[WARN] Cannot open %s for writing; precision errors are only summarized.\n", filename);
+        return -1;
+    }
+    fprintf(rep->csv, "time,rho_abs,rho_rel,vel_abs,vel_rel,pres_abs,pres_rel\n");
+    printf("[INFO] Comparing against a float64 shadow run; errors go to %s\n", filename);
+    return 0;
+}
+
+void cfdPrecisionReportSample(CfdPrecisionReport *rep, CfdSolver *s)
+{
+    CfdPrecisionError err;
+    if (cfdSolverPrecisionError(s, &err) != 0) return;
+    for (i32 k = 0; k < 3; k++)
+    {
+        if (err.abs_err[k] > rep->max.abs_err[k]) rep->max.abs_err[k] = err.abs_err[k];
+        if (err.rel_err[k] > rep->max.rel_err[k]) rep->max.rel_err[k] = err.rel_err[k];
+    }
+    rep->samples++;
+    if (rep->csv)
+    {
+        fprintf(rep->csv, "%.6f,%.6e,%.6e,%.6e,%.6e,%.6e,%.6e\n", s->t,
+                err.abs_err[0], err.rel_err[0], err.abs_err[1], err.rel_err[1], err.abs_err[2], err.rel_err[2]);
+    }
+}
+
+void cfdPrecisionReportClose(CfdPrecisionReport *rep)
+{
+    if (rep->csv) fclose(rep->csv);
+    rep->csv = NULL;
+    const CfdPrecisionError *m = &rep->max;
+    printf("[INFO] Mixed precision vs float64 over %lld samples (max abs / relative to the f64 perturbation):\n",
+           rep->samples);
+    printf("    rho  %.3e / %.3e\n", m->abs_err[0], m->rel_err[0]);
+    printf("    vel  %.3e / %.3e\n", m->abs_err[1], m->rel_err[1]);
+    printf("    pres %.3e / %.3e\n", m->abs_err[2], m->rel_err[2]);
+}
@@ -0,0 +1,459 @@
+/*
+    source/cfd_mpi.c
+    MPI 区域分解：子区域的划分与推进、幽灵层交换与 MPI-IO 集合写出快照
+*/
+#include "cfd_mpi.h"
+#include "cfd_output.h"
+#include "cfd_report.h"
+#include "cfd_simd.h"
+#include "cfd_stencil.h"
+#include "cfd_differentials.h"
+#include "cfd_stepper.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CFD_MPI
+
+#define CFD_MPI_TAG_HALO    17
+
+void cfdMpiInit(i32 *argc, char ***argv)
+{
+    MPI_Init(argc, argv);
+}
+
+void cfdMpiFinalize(void)
+{
+    MPI_Finalize();
+}
+
+i32 cfdMpiRank(void)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    return rank;
+}
+
+i32 cfdMpiSize(void)
+{
+    int size;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    return size;
+}
+
+CfdMpiDomain *cfdMpiDomainCreate(const CfdConfig *cfg, MPI_Comm comm)
+{
+    CfdMpiDomain *d = (CfdMpiDomain *)calloc(1, sizeof(CfdMpiDomain));
+    if (!d)
+    {
+        printf("[ERROR] Memory allocation failed for the MPI domain\n");
+        return NULL;
+    }
+    d->comm = comm;
+    MPI_Comm_rank(comm, &d->rank);
+    MPI_Comm_size(comm, &d->size);
+    d->nx = cfg->nx;
+    /* 每段至少两个点，边界更新要读段内的邻点 */
+    if (cfg->nx < 2 * d->size)
+    {
+        if (d->rank == 0) printf("[ERROR] NX=%d is too small for %d MPI ranks\n", cfg->nx, d->size);
+        free(d);
+        return NULL;
+    }
+    const i32 q = cfg->nx / d->size, r = cfg->nx % d->size;
+    d->g0 = d->rank * q + (d->rank < r ? d->rank : r);
+    d->g1 = d->g0 + q + (d->rank < r ? 1 : 0);
+    d->left = d->rank > 0 ? d->rank - 1 : MPI_PROC_NULL;
+    d->right = d->rank < d->size - 1 ? d->rank + 1 : MPI_PROC_NULL;
+    d->offset = d->rank > 0 ? CFD_MPI_HALO : 0;
+
+    CfdConfig local = *cfg;
+    local.nx = d->g1 - d->g0 + (d->left != MPI_PROC_NULL ? CFD_MPI_HALO : 0)
+                             + (d->right != MPI_PROC_NULL ? CFD_MPI_HALO : 0);
+    local.precision = CFD_PRECISION_DOUBLE;
+    local.precision_check = 0;
+    local.stepper = CFD_STEPPER_TAYLOR;
+    local.grid_stretch = 0.0;
+    local.active_region = 0;
+    d->s = cfdSolverCreate(&local);
+    if (d->s == NULL)
+    {
+        free(d);
+        return NULL;
+    }
+    for (i32 k = 0; k < 4; k++) d->req[k] = MPI_REQUEST_NULL;
+    return d;
+}
+
+void cfdMpiDomainDestroy(CfdMpiDomain *d)
+{
+    if (!d) return;
+    cfdSolverDestroy(d->s);
+    free(d);
+}
+
+/* 本地内部点 [lo, hi)，分块方式与 updateFlowField 相同 */
+static void interiorRange(CfdSolver *s, f64 acc, i32 lo, i32 hi)
+{
+    if (lo >= hi) return;
+#ifdef CFD_REFERENCE_KERNEL
+    for (int i = lo; i < hi; i++)
+    {
+        s->vel_next[i] = s->vel[i] + s->dt * pvx_pt(s, i, acc) + s->half_dt2 * ppvx_ppt(s, i, acc);
+        s->rho_next[i] = s->rho[i] + s->dt * prho_pt(s, i) + s->half_dt2 * pprho_ppt(s, i, acc);
+    }
+#else
+    const i32 blocks = (hi - lo + CFD_SIMD_BLOCK - 1) / CFD_SIMD_BLOCK;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE)
+#endif
+    for (i32 b = 0; b < blocks; b++)
+    {
+        i32 blo = lo + b * CFD_SIMD_BLOCK;
+        i32 bhi = blo + CFD_SIMD_BLOCK < hi ? blo + CFD_SIMD_BLOCK : hi;
+        cfdSimdInterior(s->simd, s, acc, blo, bhi, NULL);
+    }
+#endif
+}
+
+void cfdMpiDomainStep(CfdMpiDomain *d)
+{
+    CfdSolver *s = d->s;
+    CfdTimers *tm = &s->timers;
+    const i32 nl = s->nx;
+    const f64 acc = s->pa.acc;
+    const i32 has_left = d->left != MPI_PROC_NULL, has_right = d->right != MPI_PROC_NULL;
+    f64 t0 = cfdWallTime();
+
+    /* 先挂上接收：邻段的新边缘值到达时直接落进 recv */
+    MPI_Irecv(d->recv, 2, MPI_DOUBLE, d->left, CFD_MPI_TAG_HALO, d->comm, &d->req[0]);
+    MPI_Irecv(d->recv + 2, 2, MPI_DOUBLE, d->right, CFD_MPI_TAG_HALO, d->comm, &d->req[1]);
+
+    /* 物理边界只在两端的进程上，且先于内部点（导出压力时右边界要读 rho_next 中上一步的密度） */
+    if (!has_right)
+    {
+        s->vel_next[nl - 1] = rborderVel(s, acc);
+        s->rho_next[nl - 1] = rborderRho(s);
+    }
+    if (!has_left)
+    {
+        s->vel_next[0] = 0.0;
+        s->rho_next[0] = borderRhoLeft(s->rho[0], s->vel[0], s->vel[1], s->dx, s->dt);
+    }
+    t0 = cfdTimersAdd(tm, CFD_PHASE_BORDER, t0, 0.0);
+
+    /* 邻段需要的两个边缘点先算出来并发出，其余内部点的计算与通信重叠 */
+    i32 lo = 1, hi = nl - 1;
+    if (has_left)
+    {
+        interiorRange(s, acc, 1, 2);
+        lo = 2;
+    }
+    if (has_right && lo < hi)
+    {
+        interiorRange(s, acc, nl - 2, nl - 1);
+        hi = nl - 2;
+    }
+    d->send[0] = s->rho_next[1];
+    d->send[1] = s->vel_next[1];
+    d->send[2] = s->rho_next[nl - 2];
+    d->send[3] = s->vel_next[nl - 2];
+    MPI_Isend(d->send, 2, MPI_DOUBLE, d->left, CFD_MPI_TAG_HALO, d->comm, &d->req[2]);
+    MPI_Isend(d->send + 2, 2, MPI_DOUBLE, d->right, CFD_MPI_TAG_HALO, d->comm, &d->req[3]);
+
+    interiorRange(s, acc, lo, hi);
+    t0 = cfdTimersAdd(tm, CFD_PHASE_FUSED, t0, 4 * sizeof(f64) * (f64)nl);
+    if (!s->derived_pressure)
+    {
+        /* 幽灵点的 rho 在上一步已经收到，压力可以在本地整段求出 */
+        updatePressure(s);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_PRESSURE, t0, 2 * sizeof(f64) * (f64)nl);
+    }
+
+    MPI_Waitall(4, d->req, MPI_STATUSES_IGNORE);
+    if (has_left)
+    {
+        s->rho_next[0] = d->recv[0];
+        s->vel_next[0] = d->recv[1];
+    }
+    if (has_right)
+    {
+        s->rho_next[nl - 1] = d->recv[2];
+        s->vel_next[nl - 1] = d->recv[3];
+    }
+    t0 = cfdTimersAdd(tm, CFD_PHASE_HALO, t0, 0.0);
+
+    swapFlowField(s);
+    t0 = cfdTimersAdd(tm, CFD_PHASE_SWAP, t0, 0.0);
+    s->t += s->dt;
+    s->step++;
+    s->synced = 0;
+    pistonAccelAdvance(&s->pa);
+    cfdTimersAdd(tm, CFD_PHASE_PISTON, t0, 0.0);
+}
+
+/*
+    集合写出的快照文件：与 cfd_output.c 的二进制格式相同，按点采样。
+    每帧的 rho/vel/pres 各是一段连续的全局数组，进程 r 写其中 [k_lo, k_hi) 的采样点。
+*/
+typedef struct {
+    MPI_File fh;
+    i32 active;
+    i32 window_start, window_end, stride, npoints, every;
+    i32 k_lo, k_hi;                 // 本进程拥有的采样点
+    i64 calls, frames;
+    MPI_Offset header_bytes;
+    f64 *buffer;                    // 3 * (k_hi - k_lo)
+} MpiOutput;
+
+static i32 mpiOutputOpen(MpiOutput *o, const CfdConfig *cfg, const CfdMpiDomain *d)
+{
+    memset(o, 0, sizeof(*o));
+    const i32 root = d->rank == 0;
+    if (root && (cfg->output_format & CFD_OUTPUT_CSV))
+    {
+        printf("[WARN] CSV snapshots are not written in MPI mode; use the binary container.\n");
+    }
+    if (root && (cfg->output_format & CFD_OUTPUT_COMPRESSED))
+    {
+        printf("[WARN] Compressed snapshots are not written in MPI mode; writing the binary container.\n");
+    }
+    if (!(cfg->output_format & (CFD_OUTPUT_BINARY | CFD_OUTPUT_COMPRESSED))) return 0;
+    if (root && cfg->output_sampling != CFD_SAMPLE_POINT)
+    {
+        printf("[WARN] min/max sampling is not available in MPI mode; using point sampling.\n");
+    }
+
+    o->window_start = cfg->output_window_start;
+    o->window_end = cfg->output_window_end < 0 || cfg->output_window_end > d->nx ? d->nx : cfg->output_window_end;
+    o->stride = cfg->output_stride;
+    o->every = cfg->output_every;
+    o->npoints = (o->window_end - o->window_start + o->stride - 1) / o->stride;
+    const i32 a = d->g0 > o->window_start ? d->g0 : o->window_start;
+    const i32 b = d->g1 < o->window_end ? d->g1 : o->window_end;
+    o->k_lo = (a - o->window_start + o->stride - 1) / o->stride;
+    o->k_hi = b > a ? (b - o->window_start + o->stride - 1) / o->stride : o->k_lo;
+    o->buffer = (f64 *)malloc(sizeof(f64) * 3 * (size_t)(o->k_hi - o->k_lo + 1));
+    if (!o->buffer)
+    {
+        printf("[ERROR] Memory allocation failed for MPI snapshot output\n");
+        return -1;
+    }
+
+    char filename[CFD_PATH_MAX + 64];
+    snprintf(filename, sizeof(filename), "%s/%s", cfg->output_dir, CFD_SNAPSHOT_FILE);
+    if (MPI_File_open(d->comm, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &o->fh) != MPI_SUCCESS)
+    {
+        if (root) printf("[WARN] Cannot open %s for writing; continuing without binary output.\n", filename);
+        free(o->buffer);
+        o->buffer = NULL;
+        return 0;
+    }
+    MPI_File_set_size(o->fh, 0);
+
+    CfdSnapshotHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CFD_SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    hdr.version = CFD_SNAPSHOT_VERSION;
+    hdr.header_bytes = (u32)sizeof(hdr);
+    hdr.nx = d->nx;
+    hdr.npoints = o->npoints;
+    hdr.idx_start = o->window_start;
+    hdr.idx_stride = o->stride;
+    hdr.idx_end = o->window_end;
+    hdr.dx = d->s->dx;
+    hdr.dt = d->s->dt;
+    hdr.sampling = CFD_SAMPLE_POINT;
+    if (root) MPI_File_write_at(o->fh, 0, &hdr, (int)sizeof(hdr), MPI_BYTE, MPI_STATUS_IGNORE);
+    o->header_bytes = (MPI_Offset)sizeof(hdr);
+    o->active = 1;
+    if (root && (o->stride != 1 || o->window_start != 0 || o->window_end != d->nx || o->every != 1))
+    {
+        printf("[INFO] Snapshot sampling: idx [%d, %d) stride %d (point), %d points, every %d snapshot(s)\n",
+               o->window_start, o->window_end, o->stride, o->npoints, o->every);
+    }
+    return 0;
+}
+
+/* 所有进程一起调用：0 号进程写时间，各进程把自己的采样点写到三个物理量各自的位置 */
+static void mpiOutputWrite(MpiOutput *o, const CfdMpiDomain *d)
+{
+    if (!o->active || o->calls++ % o->every != 0) return;
+    CfdSolver *s = d->s;
+    cfdSolverSync(s);
+    const i32 n = o->k_hi - o->k_lo;
+    for (i32 m = 0; m < n; m++)
+    {
+        const i32 j = o->window_start + (o->k_lo + m) * o->stride - d->g0 + d->offset;
+        o->buffer[m] = s->rho[j];
+        o->buffer[n + m] = s->vel[j];
+        o->buffer[2 * n + m] = s->pres[j];
+    }
+    const MPI_Offset base = o->header_bytes + (MPI_Offset)o->frames * (MPI_Offset)sizeof(f64) * (1 + 3 * (MPI_Offset)o->npoints);
+    if (d->rank == 0) MPI_File_write_at(o->fh, base, &s->t, 1, MPI_DOUBLE, MPI_STATUS_IGNORE);
+    for (i32 f = 0; f < 3; f++)
+    {
+        const MPI_Offset at = base + (MPI_Offset)sizeof(f64) * (1 + (MPI_Offset)f * o->npoints + o->k_lo);
+        MPI_File_write_at_all(o->fh, at, o->buffer + (size_t)f * n, n, MPI_DOUBLE, MPI_STATUS_IGNORE);
+    }
+    o->frames++;
+}
+
+static void mpiOutputClose(MpiOutput *o, const CfdConfig *cfg, i32 root)
+{
+    if (o->active)
+    {
+        MPI_File_close(&o->fh);
+        if (root) printf("[INFO] Wrote %lld binary snapshot frames to %s/%s\n", o->frames, cfg->output_dir, CFD_SNAPSHOT_FILE);
+    }
+    free(o->buffer);
+}
+
+/* 多进程模式不支持的设置：在 0 号进程上提示一次，按固定步长、f64 存储运行 */
+static void warnUnsupported(const CfdConfig *cfg)
+{
+    if (cfg->ensemble[0] != '\0')
+        printf("[WARN] Ensemble runs are not supported in MPI mode; running the base case.\n");
+    if (cfg->cfl > 0)
+        printf("[WARN] MPI mode uses the fixed time step dt=%.3e; cfl is ignored.\n", cfg->dt);
+    if (cfg->precision != CFD_PRECISION_DOUBLE)
+        printf("[WARN] MPI mode stores float64 fields; precision is ignored.\n");
+    if (cfg->stepper != CFD_STEPPER_TAYLOR)
+        printf("[WARN] MPI mode uses the taylor stepper; stepper %s is ignored.\n", cfdStepperName(cfg->stepper));
+    if (cfg->grid_stretch > 0)
+        printf("[WARN] MPI mode uses the uniform grid; grid_stretch is ignored.\n");
+    if (cfg->persistent_region)
+        printf("[WARN] persistent_region is not used in MPI mode; advancing step by step.\n");
+    if (cfg->active_region)
+        printf("[WARN] Active-region tracking is not used in MPI mode; updating every cell.\n");
+    if (cfg->checkpoint_interval > 0 || cfg->restart)
+        printf("[WARN] Checkpoints are not supported in MPI mode; ignoring checkpoint_interval/restart.\n");
+    if (cfg->probe_count > 0)
+        printf("[WARN] Probes are not supported in MPI mode; ignoring probes.\n");
+    if (cfg->live[0] != '\0')
+        printf("[WARN] Live publishing is not supported in MPI mode; ignoring live.\n");
+    if (cfg->output_queue > 0)
+        printf("[INFO] Snapshots are written collectively in MPI mode; output_queue is ignored.\n");
+}
+
+i32 cfdMpiRun(const CfdConfig *cfg)
+{
+    const i32 root = cfdMpiRank() == 0;
+    if (root) warnUnsupported(cfg);
+
+    /* 任何一个进程创建失败，所有进程一起退出 */
+    CfdMpiDomain *d = cfdMpiDomainCreate(cfg, MPI_COMM_WORLD);
+    MpiOutput output;
+    memset(&output, 0, sizeof(output));
+    int ok = d != NULL && mpiOutputOpen(&output, cfg, d) == 0;
+    MPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (!ok)
+    {
+        if (d) mpiOutputClose(&output, cfg, 0);
+        cfdMpiDomainDestroy(d);
+        return -1;
+    }
+    CfdSolver *s = d->s;
+    if (root)
+    {
+        printf("[INFO] MPI: NX=%d split over %d ranks (%d-%d points each, halo %d)\n", cfg->nx, d->size,
+               cfg->nx / d->size, (cfg->nx + d->size - 1) / d->size, CFD_MPI_HALO);
+        printf("[INFO] NX=%d DX=%.3e DT=%.3e T_END=%.3f\n", cfg->nx, cfg->dx, cfg->dt, cfg->t_end);
+    }
+
+    i64 maxSteps = (i64)(cfg->t_end / cfg->dt) + 1;
+    f64 total_timer = 0.0;
+    CfdProgress progress_report;
+    cfdProgressBegin(&progress_report, cfg->quiet || !root, 0, 0.0);
+    /* 多进程推进不经过带归约的融合核，看门狗按间隔扫描各段的流场，任何一段出错所有进程一起中止 */
+    const i32 scan_every = cfg->nan_check > 0 ? cfg->nan_check : cfg->watchdog ? cfg->print_after_steps : 0;
+    int tripped = CFD_WATCH_OK;
+    i64 step;
+    for (step = 0; step < maxSteps; step++)
+    {
+        cfdMpiDomainStep(d);
+        if (scan_every > 0 && s->step % scan_every == 0)
+        {
+            tripped = cfdSolverWatchScan(s);
+            MPI_Allreduce(MPI_IN_PLACE, &tripped, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+            if (tripped != CFD_WATCH_OK)
+            {
+                if (root)
+                    printf("[ERROR] Watchdog: %s at step %lld (t=%.6e s); aborting\n", cfdWatchReason(tripped),
+                           s->step, s->t);
+                step++;
+                break;
+            }
+        }
+        if (root && (step % cfg->print_after_steps == 0 || step == maxSteps - 1))
+        {
+            /* 活塞面（全局下标 0）在 0 号进程的本地下标 0 上 */
+            char line[128];
+            cfdSolverSync(s);
+            snprintf(line, sizeof(line), "rho[0]=%.8f vel[0]=%.8f pres[0]=%.8f", s->rho[0], s->vel[0], s->pres[0]);
+            cfdProgressUpdate(&progress_report, s->t, step, maxSteps, (f64)step / maxSteps, line);
+        }
+        if (s->t > total_timer)
+        {
+            f64 t0 = cfdWallTime();
+            total_timer += cfg->timer;
+            mpiOutputWrite(&output, d);
+            cfdTimersAdd(&s->timers, CFD_PHASE_OUTPUT, t0, 0.0);
+        }
+    }
+
+    f64 t0 = cfdWallTime();
+    mpiOutputClose(&output, cfg, root);
+    cfdTimersAdd(&s->timers, CFD_PHASE_OUTPUT, t0, 0.0);
+    f64 wall = cfdWallTime() - progress_report.start;
+    if (root) cfdProgressEnd(&progress_report, step);
+
+    /* 各阶段取最慢进程的耗时，字节数按全局累加 */
+    CfdTimers total;
+    MPI_Reduce(s->timers.seconds, total.seconds, CFD_PHASE_COUNT, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(s->timers.calls, total.calls, CFD_PHASE_COUNT, MPI_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(s->timers.bytes, total.bytes, CFD_PHASE_COUNT, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(root ? MPI_IN_PLACE : &wall, &wall, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (root)
+    {
+        char perf_path[CFD_PATH_MAX + 64];
+        if (cfg->perf_json[0] != '\0')
+            snprintf(perf_path, sizeof(perf_path), "%s", cfg->perf_json);
+        else
+            snprintf(perf_path, sizeof(perf_path), "%s/perf.json", cfg->output_dir);
+        cfdReportSummary(&total, cfg->nx, step, wall, perf_path);
+    }
+    cfdMpiDomainDestroy(d);
+    return tripped != CFD_WATCH_OK ? -1 : 0;
+}
+
+#else /* !CFD_MPI */
+
+void cfdMpiInit(i32 *argc, char ***argv)
+{
+    (void)argc;
+    (void)argv;
+}
+
+void cfdMpiFinalize(void)
+{
+}
+
+i32 cfdMpiRank(void)
+{
+    return 0;
+}
+
+i32 cfdMpiSize(void)
+{
+    return 1;
+}
+
+i32 cfdMpiRun(const CfdConfig *cfg)
+{
+    (void)cfg;
+    printf("[ERROR] This build has no MPI support; reconfigure with -DUSE_MPI=ON\n");
+    return -1;
+}
+
+#endif /* CFD_MPI */
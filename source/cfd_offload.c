@@ -0,0 +1,216 @@
+/*
+    source/cfd_offload.c
+    OpenMP target 卸载：设备上的常驻流场、单次启动的融合步与按需回传
+*/
+#include "cfd_offload.h"
+#include "cfd_eos.h"
+#include "cfd_stepper.h"
+#include "cfd_active.h"
+#include <stdio.h>
+#include <math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef CFD_OFFLOAD
+
+/* 核在设备上调用模板的逐点函数 */
+#pragma omp declare target
+#include "cfd_stencil.h"
+#pragma omp end declare target
+
+i32 cfdOffloadAttach(CfdSolver *s)
+{
+    if (s->precision == CFD_PRECISION_MIXED || s->shadow)
+    {
+        printf("[WARN] Offload only supports double-precision storage; running on the host.\n");
+        return 0;
+    }
+    if (s->stepper != CFD_STEPPER_TAYLOR)
+    {
+        printf("[WARN] Offload only runs the taylor stepper; running %s on the host.\n", cfdStepperName(s->stepper));
+        return 0;
+    }
+    if (s->grid)
+    {
+        printf("[WARN] Offload only supports the uniform grid; running on the host.\n");
+        return 0;
+    }
+    if (!cfdEosIsIsothermal(&s->eos))
+    {
+        printf("[WARN] Offload only supports the isothermal equation of state; running on the host.\n");
+        return 0;
+    }
+    if (s->nx < 3)
+    {
+        printf("[WARN] NX=%d is too small to offload; running on the host.\n", s->nx);
+        return 0;
+    }
+    if (s->active)
+    {
+        printf("[WARN] Active-region tracking is not used on the offload device; updating every cell.\n");
+        cfdActiveStop(s);
+    }
+    /* 映射子句直接写成员的数组段：只出现在独立指令里的局部指针会被 GCC 报为未使用 */
+    const i32 nx = s->nx;
+#pragma omp target enter data map(to: s->rho[0:nx], s->vel[0:nx], s->rho_next[0:nx], s->vel_next[0:nx])
+    if (!s->derived_pressure)
+    {
+#pragma omp target enter data map(to: s->pres[0:nx], s->pres_next[0:nx])
+    }
+    s->device = 1;
+    if (omp_get_num_devices() > 0)
+    {
+        printf("[INFO] Fields resident on offload device %d of %d\n", omp_get_default_device(), omp_get_num_devices());
+    }
+    else
+    {
+        printf("[INFO] No offload device available; target regions run on the host\n");
+    }
+    return 0;
+}
+
+void cfdOffloadDetach(CfdSolver *s)
+{
+    if (!s->device) return;
+#pragma omp taskwait
+    const i32 nx = s->nx;
+#pragma omp target exit data map(delete: s->rho[0:nx], s->vel[0:nx], s->rho_next[0:nx], s->vel_next[0:nx])
+    if (!s->derived_pressure)
+    {
+#pragma omp target exit data map(delete: s->pres[0:nx], s->pres_next[0:nx])
+    }
+    s->device = 0;
+}
+
+void cfdOffloadStep(CfdSolver *s)
+{
+    const i32 nx = s->nx;
+    const f64 *rho = s->rho, *vel = s->vel, *pres = s->pres;
+    f64 *rho_next = s->rho_next, *vel_next = s->vel_next, *pres_next = s->pres_next;
+    const f64 dt = s->dt, dx = s->dx;
+    const f64 half_dt2 = s->half_dt2;
+    const f64 inv_2dx = 1.0 / (2 * s->dx);
+    const f64 inv_dx2 = 1.0 / (s->dx * s->dx);
+    const f64 acc = s->pa.acc;
+    const f64 gas = s->eos.gas_constant, temp = s->eos.temperature;
+    const i32 derived = s->derived_pressure;
+
+    /*
+        一次启动完成整步。右边界要读 rho_next[nx - 2] 中上一步的密度（导出压力时），
+        所以由负责 nx - 2 的迭代在写出自己的点之前求出；左壁面由 i = 1 的迭代顺带完成。
+        依赖挂在 s->device 上，相邻两步的核与回传按提交顺序执行。
+    */
+#pragma omp target teams distribute parallel for nowait depend(inout: s->device)
+    for (i32 i = 1; i < nx - 1; i++)
+    {
+        if (i == nx - 2)
+        {
+            const i32 c = nx - 1;
+            f64 p_diff = derived ? gas * rho_next[c] * temp - gas * rho_next[c - 1] * temp
+                                 : pres[c] - pres[c - 1];
+            vel_next[c] = borderVelRight(rho[c], vel[c - 1], vel[c], p_diff, dx, dt, acc);
+            rho_next[c] = borderRhoRight(rho[c - 1], rho[c], vel[c - 1], vel[c], dx, dt);
+            if (!derived) pres_next[c] = R / MU_STAR * rho[c] * T_INIT;
+        }
+        if (i == 1)
+        {
+            vel_next[0] = 0.0;
+            rho_next[0] = borderRhoLeft(rho[0], vel[0], vel[1], dx, dt);
+            if (!derived) pres_next[0] = R / MU_STAR * rho[0] * T_INIT;
+        }
+        fusedPoint(rho, vel, rho_next, vel_next, dt, half_dt2, inv_2dx, inv_dx2, acc, i);
+        if (!derived) pres_next[i] = R / MU_STAR * rho[i] * T_INIT;
+    }
+    swapFlowField(s);
+}
+
+/*
+    回传是同步的：主机数组就是设备缓冲区的映像，随 swapFlowField 交替，传回的数据在下一步
+    写入这组缓冲区之前就要用完，所以不能与之后的步重叠。不带 nowait 的 update 按 depend
+    等前面排队的核完成，再等传输结束才返回。
+*/
+void cfdOffloadDownload(CfdSolver *s)
+{
+    const i32 nx = s->nx;
+    /* 导出压力时 pres 由主机按 rho_next 中上一步的密度求出（见 cfdSolverSync） */
+    if (s->derived_pressure)
+    {
+#pragma omp target update from(s->rho[0:nx], s->vel[0:nx], s->rho_next[0:nx]) depend(inout: s->device)
+    }
+    else
+    {
+#pragma omp target update from(s->rho[0:nx], s->vel[0:nx], s->pres[0:nx]) depend(inout: s->device)
+    }
+}
+
+void cfdOffloadFetchPoints(const CfdSolver *s, const i32 *idx, i32 n)
+{
+    /* 各点的小传输以 nowait 一起排队，彼此的延迟相互重叠，最后统一等待 */
+    const i32 derived = s->derived_pressure;
+    for (i32 k = 0; k < n; k++)
+    {
+        const i32 i = idx[k];
+        if (derived)
+        {
+#pragma omp target update from(s->rho[i:1], s->vel[i:1], s->rho_next[i:1]) nowait depend(inout: s->device)
+        }
+        else
+        {
+#pragma omp target update from(s->rho[i:1], s->vel[i:1], s->pres[i:1]) nowait depend(inout: s->device)
+        }
+    }
+#pragma omp taskwait
+}
+
+f64 cfdOffloadMaxSpeed(CfdSolver *s)
+{
+    const i32 nx = s->nx;
+    const f64 *vel = s->vel;
+    f64 vmax = 0.0;
+#pragma omp target teams distribute parallel for reduction(max: vmax) map(tofrom: vmax) depend(inout: s->device)
+    for (i32 i = 0; i < nx; i++)
+    {
+        f64 v = fabs(vel[i]);
+        if (v > vmax) vmax = v;
+    }
+    return vmax;
+}
+
+#else /* !CFD_OFFLOAD */
+
+i32 cfdOffloadAttach(CfdSolver *s)
+{
+    (void)s;
+    return 0;
+}
+
+void cfdOffloadDetach(CfdSolver *s)
+{
+    (void)s;
+}
+
+void cfdOffloadStep(CfdSolver *s)
+{
+    (void)s;
+}
+
+void cfdOffloadDownload(CfdSolver *s)
+{
+    (void)s;
+}
+
+void cfdOffloadFetchPoints(const CfdSolver *s, const i32 *idx, i32 n)
+{
+    (void)s;
+    (void)idx;
+    (void)n;
+}
+
+f64 cfdOffloadMaxSpeed(CfdSolver *s)
+{
+    (void)s;
+    return 0.0;
+}
+
+#endif /* CFD_OFFLOAD */
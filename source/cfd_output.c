@@ -0,0 +1,563 @@
+/*
+    source/cfd_output.c
+    快照输出：二进制容器与 CSV 导出，可选的后台写线程
+*/
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "cfd_output.h"
+#include "cfd_codec.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/*
+    压缩并写出一帧：各字段先量化（有损时）或取保序的位模式（无损时）得到键，
+    按 Lorenzo 预测编码（关键帧与量化步长改变的字段只做帧内预测，见 cfd_codec.h）。
+    超出量化范围（如出现非有限值）的字段在这一帧退回无损编码。
+*/
+static void writeCompressed(CfdOutput *out, const CfdFrame *frame)
+{
+    const i32 n = frame->npoints;
+    const f64 *fields[3] = {frame->rho, frame->vel, frame->pres};
+    const i32 keyframe = out->frames % CFD_SNAPSHOT_KEYFRAME == 0;
+    u8 *p = out->zbuf + sizeof(CfdZFrameHeader);
+    for (i32 f = 0; f < 3; f++)
+    {
+        CfdZFieldHeader fh;
+        memset(&fh, 0, sizeof(fh));
+        fh.quantum = out->zquantum[f];
+        if (fh.quantum > 0 && cfdCodecQuantize(fields[f], n, fh.quantum, out->zcur) != 0) fh.quantum = 0.0;
+        if (fh.quantum == 0) cfdCodecKeys(fields[f], n, out->zcur);
+        const i32 temporal = !keyframe && out->zlast[f] == fh.quantum;
+        fh.predictor = temporal ? CFD_CODEC_TEMPORAL : CFD_CODEC_SPATIAL;
+        fh.bytes = cfdCodecEncode(out->zcur, temporal ? out->zkey[f] : NULL, n, out->zres, p + sizeof(fh));
+        memcpy(p, &fh, sizeof(fh));
+        p += sizeof(fh) + fh.bytes;
+
+        /* 当前的键成为下一帧的预测值 */
+        u64 *tmp = out->zkey[f];
+        out->zkey[f] = out->zcur;
+        out->zcur = tmp;
+        out->zlast[f] = fh.quantum;
+    }
+    CfdZFrameHeader hdr = {(u64)(p - out->zbuf), frame->t};
+    memcpy(out->zbuf, &hdr, sizeof(hdr));
+    fwrite(out->zbuf, 1, (size_t)hdr.frame_bytes, out->zbin);
+    fflush(out->zbin);
+    out->zbytes += (i64)hdr.frame_bytes;
+    out->zraw += (i64)sizeof(f64) * (1 + 3 * (i64)n);
+}
+
+/* 编码并写出一帧（同步模式下在求解线程中调用，异步模式下在写线程中调用） */
+static void writeFrame(CfdOutput *out, const CfdFrame *frame)
+{
+    if (out->format & CFD_OUTPUT_BINARY)
+    {
+        const size_t n = (size_t)frame->npoints;
+        fwrite(&frame->t, sizeof(f64), 1, out->bin);
+        fwrite(frame->rho, sizeof(f64), n, out->bin);
+        fwrite(frame->vel, sizeof(f64), n, out->bin);
+        fwrite(frame->pres, sizeof(f64), n, out->bin);
+        /* 每帧刷新一次，读者可以在运行过程中直接 mmap 已完成的帧 */
+        fflush(out->bin);
+    }
+    if (out->format & CFD_OUTPUT_COMPRESSED)
+    {
+        writeCompressed(out, frame);
+    }
+    if (out->format & CFD_OUTPUT_CSV)
+    {
+        cfdWriteSnapshotCsv(out, frame);
+    }
+    out->frames++;
+}
+
+/* 采样是否为恒等映射（全分辨率、全窗口），此时同步模式可以直接写求解器的数组 */
+static i32 isIdentitySampling(const CfdOutput *out, i32 nx)
+{
+    return out->sampling == CFD_SAMPLE_POINT && out->stride == 1
+        && out->window_start == 0 && out->window_end == nx;
+}
+
+/* 在一个桶内按出现顺序取最小值与最大值 */
+static void minmaxBucket(const f64 *src, i32 begin, i32 end, f64 *dst)
+{
+    i32 imin = begin, imax = begin;
+    for (i32 i = begin + 1; i < end; i++)
+    {
+        if (src[i] < src[imin]) imin = i;
+        if (src[i] > src[imax]) imax = i;
+    }
+    if (imin <= imax)
+    {
+        dst[0] = src[imin];
+        dst[1] = src[imax];
+    }
+    else
+    {
+        dst[0] = src[imax];
+        dst[1] = src[imin];
+    }
+}
+
+static void sampleField(const CfdOutput *out, const f64 *src, f64 *dst)
+{
+    const i32 w0 = out->window_start, w1 = out->window_end, stride = out->stride;
+    if (out->sampling == CFD_SAMPLE_MINMAX)
+    {
+        const i32 buckets = out->npoints / 2;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (i32 b = 0; b < buckets; b++)
+        {
+            i32 begin = w0 + b * stride;
+            i32 end = begin + stride < w1 ? begin + stride : w1;
+            minmaxBucket(src, begin, end, dst + 2 * b);
+        }
+    }
+    else
+    {
+        const i32 n = out->npoints;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+        for (i32 k = 0; k < n; k++)
+        {
+            dst[k] = src[w0 + k * stride];
+        }
+    }
+}
+
+void cfdOutputSample(const CfdOutput *out, const CfdSolver *s, CfdFrame *frame)
+{
+    frame->t = s->t;
+    sampleField(out, s->rho, frame->rho);
+    sampleField(out, s->vel, frame->vel);
+    sampleField(out, s->pres, frame->pres);
+}
+
+i32 cfdOutputSampleIndex(const CfdOutput *out, i32 k)
+{
+    if (out->sampling == CFD_SAMPLE_MINMAX)
+    {
+        i32 begin = out->window_start + (k / 2) * out->stride;
+        i32 last = begin + out->stride - 1;
+        if (last > out->window_end - 1) last = out->window_end - 1;
+        return (k % 2 == 0) ? begin : last;
+    }
+    return out->window_start + k * out->stride;
+}
+
+static void *writerThread(void *arg)
+{
+    CfdOutput *out = (CfdOutput *)arg;
+    pthread_mutex_lock(&out->lock);
+    for (;;)
+    {
+        while (out->count == 0 && !out->stop)
+        {
+            pthread_cond_wait(&out->not_empty, &out->lock);
+        }
+        if (out->count == 0) break;     /* stop 且队列已清空 */
+
+        /* 队首帧在写完之前不会被求解线程复用，写的过程中无需持锁 */
+        CfdFrame *frame = &out->slots[out->head];
+        pthread_mutex_unlock(&out->lock);
+        writeFrame(out, frame);
+        pthread_mutex_lock(&out->lock);
+
+        out->head = (out->head + 1) % out->capacity;
+        out->count--;
+        pthread_cond_signal(&out->not_full);
+    }
+    pthread_mutex_unlock(&out->lock);
+    return NULL;
+}
+
+static i32 startWriter(CfdOutput *out, i32 capacity)
+{
+    const i32 n = out->npoints;
+    out->capacity = capacity;
+    out->slots = (CfdFrame *)calloc((size_t)capacity, sizeof(CfdFrame));
+    out->storage = (f64 *)malloc(sizeof(f64) * 3 * (size_t)n * (size_t)capacity);
+    if (!out->slots || !out->storage)
+    {
+        printf("[WARN] Cannot allocate snapshot queue; writing snapshots synchronously.\n");
+        free(out->slots);
+        free(out->storage);
+        out->slots = NULL;
+        out->storage = NULL;
+        return -1;
+    }
+    for (i32 k = 0; k < capacity; k++)
+    {
+        f64 *base = out->storage + (size_t)3 * n * k;
+        out->slots[k].npoints = n;
+        out->slots[k].rho = base;
+        out->slots[k].vel = base + n;
+        out->slots[k].pres = base + 2 * (size_t)n;
+    }
+    pthread_mutex_init(&out->lock, NULL);
+    pthread_cond_init(&out->not_empty, NULL);
+    pthread_cond_init(&out->not_full, NULL);
+    if (pthread_create(&out->thread, NULL, writerThread, out) != 0)
+    {
+        printf("[WARN] Cannot start snapshot writer thread; writing snapshots synchronously.\n");
+        pthread_mutex_destroy(&out->lock);
+        pthread_cond_destroy(&out->not_empty);
+        pthread_cond_destroy(&out->not_full);
+        free(out->slots);
+        free(out->storage);
+        out->slots = NULL;
+        out->storage = NULL;
+        return -1;
+    }
+    out->async = 1;
+    return 0;
+}
+
+/* 压缩文件中前 frames 帧之后的偏移；帧不足时返回 -1 */
+static i64 compressedOffset(FILE *bin, i64 size, i64 frames)
+{
+    i64 offset = (i64)sizeof(CfdSnapshotHeader);
+    for (i64 k = 0; k < frames; k++)
+    {
+        CfdZFrameHeader fh;
+        if (fseek(bin, (long)offset, SEEK_SET) != 0 || fread(&fh, sizeof(fh), 1, bin) != 1) return -1;
+        offset += (i64)fh.frame_bytes;
+        if (fh.frame_bytes < sizeof(fh) || offset > size) return -1;
+    }
+    return offset;
+}
+
+/*
+    续写已有的快照文件：核对文件头与当前的采样设置一致，
+    截掉 frames 帧之后的内容（检查点之后写出的帧将被重新写出）。
+    压缩文件的帧是变长的，逐帧读帧头找到截断位置。
+*/
+static FILE *resumeBinary(const char *filename, const CfdSnapshotHeader *hdr, i64 frames)
+{
+    FILE *bin = fopen(filename, "r+b");
+    if (bin == NULL)
+    {
+        printf("[ERROR] Cannot reopen %s to resume snapshot output\n", filename);
+        return NULL;
+    }
+    CfdSnapshotHeader old;
+    const i32 compressed = memcmp(hdr->magic, CFD_SNAPSHOT_Z_MAGIC, sizeof(hdr->magic)) == 0;
+    const i64 frame_bytes = (i64)sizeof(f64) * (1 + 3 * hdr->npoints);
+    i64 keep = (i64)sizeof(old) + frames * frame_bytes;
+    struct stat st;
+    if (fread(&old, sizeof(old), 1, bin) != 1 || memcmp(old.magic, hdr->magic, sizeof(old.magic)) != 0
+        || old.version != hdr->version || old.nx != hdr->nx || old.npoints != hdr->npoints
+        || old.idx_start != hdr->idx_start || old.idx_stride != hdr->idx_stride || old.idx_end != hdr->idx_end
+        || old.sampling != hdr->sampling)
+    {
+        printf("[ERROR] %s does not match the current snapshot settings; cannot resume\n", filename);
+        fclose(bin);
+        return NULL;
+    }
+    const i32 have_size = fstat(fileno(bin), &st) == 0;
+    if (have_size && compressed) keep = compressedOffset(bin, (i64)st.st_size, frames);
+    if (!have_size || keep < 0 || (i64)st.st_size < keep)
+    {
+        printf("[ERROR] %s holds fewer than the %lld frames recorded in the checkpoint\n", filename, frames);
+        fclose(bin);
+        return NULL;
+    }
+    fflush(bin);
+    if (ftruncate(fileno(bin), (off_t)keep) != 0 || fseek(bin, 0, SEEK_END) != 0)
+    {
+        printf("[ERROR] Cannot truncate %s to resume snapshot output\n", filename);
+        fclose(bin);
+        return NULL;
+    }
+    return bin;
+}
+
+/*
+    打开 out->dir 下的快照文件 name：frames >= 0 时续写（失败返回 NULL），
+    否则新建并写入文件头（失败时给出警告并返回 NULL）
+*/
+static FILE *openContainer(const CfdOutput *out, const CfdSnapshotHeader *hdr, const char *name, const char *kind, i64 frames)
+{
+    char filename[CFD_PATH_MAX + 64];
+    snprintf(filename, sizeof(filename), "%s/%s", out->dir, name);
+    if (frames >= 0)
+    {
+        FILE *bin = resumeBinary(filename, hdr, frames);
+        if (bin) printf("[INFO] Resuming %s snapshots in %s after frame %lld\n", kind, filename, frames);
+        return bin;
+    }
+    FILE *bin = fopen(filename, "wb");
+    if (bin == NULL)
+    {
+        printf("[WARN] Cannot open %s for writing; continuing without %s output.\n", filename, kind);
+        return NULL;
+    }
+    fwrite(hdr, sizeof(*hdr), 1, bin);
+    fflush(bin);
+    printf("[INFO] Writing %s snapshots to %s\n", kind, filename);
+    return bin;
+}
+
+/* 压缩输出：各字段的量化步长与编码缓冲；续写时第一帧为关键帧。失败返回 -1 */
+static i32 openCompressed(CfdOutput *out, const CfdConfig *cfg, const CfdSnapshotHeader *hdr, i64 frames)
+{
+    const i32 n = out->npoints;
+    /* 误差界 output_error 给的是速度，密度与压力按声学关系换算；量化步长为误差界的两倍 */
+    const f64 c = sqrt(K);
+    out->zquantum[0] = 2 * cfg->output_error * RHO_INIT / c;
+    out->zquantum[1] = 2 * cfg->output_error;
+    out->zquantum[2] = 2 * cfg->output_error * RHO_INIT * c;
+    for (i32 f = 0; f < 3; f++) out->zlast[f] = -1.0;
+    u64 *keys = (u64 *)malloc(sizeof(u64) * 5 * (size_t)n);
+    out->zbuf = (u8 *)malloc(sizeof(CfdZFrameHeader) + 3 * (sizeof(CfdZFieldHeader) + cfdCodecBound(n)));
+    if (!keys || !out->zbuf)
+    {
+        printf("[ERROR] Memory allocation failed for compressed snapshot output\n");
+        free(keys);
+        return -1;
+    }
+    /* zres 留在这块存储的开头（释放时用），zkey 与 zcur 在写出时互相交换 */
+    out->zres = keys;
+    for (i32 f = 0; f < 3; f++) out->zkey[f] = keys + (size_t)(f + 1) * n;
+    out->zcur = keys + 4 * (size_t)n;
+    out->zbin = openContainer(out, hdr, CFD_SNAPSHOT_Z_FILE, "compressed", frames);
+    if (out->zbin == NULL && frames >= 0) return -1;
+    if (out->zbin == NULL)
+    {
+        out->format &= ~CFD_OUTPUT_COMPRESSED;
+        return 0;
+    }
+    if (cfg->output_error > 0)
+    {
+        printf("[INFO] Compressed snapshots: lossy, |error| <= %g m/s in vel, %.3g kg/m^3 in rho, %.3g Pa in pres\n",
+               cfg->output_error, 0.5 * out->zquantum[0], 0.5 * out->zquantum[2]);
+    }
+    else
+    {
+        printf("[INFO] Compressed snapshots: lossless\n");
+    }
+    return 0;
+}
+
+void cfdOutputHeader(const CfdOutput *out, const CfdSolver *s, CfdSnapshotHeader *hdr)
+{
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, CFD_SNAPSHOT_MAGIC, sizeof(hdr->magic));
+    hdr->version = CFD_SNAPSHOT_VERSION;
+    hdr->header_bytes = (u32)sizeof(*hdr);
+    hdr->nx = s->nx;
+    hdr->npoints = out->npoints;
+    hdr->idx_start = out->window_start;
+    hdr->idx_stride = out->stride;
+    hdr->idx_end = out->window_end;
+    hdr->dx = s->dx;
+    hdr->dt = s->dt;
+    hdr->sampling = (u32)out->sampling;
+    if (s->grid)
+    {
+        hdr->grid_stretch = s->grid->stretch;
+        hdr->grid_length = s->grid->length;
+    }
+}
+
+CfdOutput *cfdOutputOpen(const CfdConfig *cfg, const CfdSolver *s)
+{
+    return cfdOutputResume(cfg, s, -1, 0);
+}
+
+CfdOutput *cfdOutputResume(const CfdConfig *cfg, const CfdSolver *s, i64 frames, i64 calls)
+{
+    CfdOutput *out = (CfdOutput *)calloc(1, sizeof(CfdOutput));
+    if (!out)
+    {
+        printf("[ERROR] Memory allocation failed while opening snapshot output\n");
+        return NULL;
+    }
+    out->format = cfg->output_format;
+    strcpy(out->dir, cfg->output_dir);
+
+    out->sampling = cfg->output_sampling;
+    out->window_start = cfg->output_window_start;
+    out->window_end = cfg->output_window_end < 0 || cfg->output_window_end > s->nx ? s->nx : cfg->output_window_end;
+    out->stride = cfg->output_stride;
+    out->every = cfg->output_every;
+    i32 span = out->window_end - out->window_start;
+    i32 buckets = (span + out->stride - 1) / out->stride;
+    out->npoints = out->sampling == CFD_SAMPLE_MINMAX ? 2 * buckets : buckets;
+
+    if (frames >= 0)
+    {
+        out->frames = frames;
+        out->calls = calls;
+    }
+
+    CfdSnapshotHeader hdr;
+    cfdOutputHeader(out, s, &hdr);
+    if (out->format & CFD_OUTPUT_BINARY)
+    {
+        out->bin = openContainer(out, &hdr, CFD_SNAPSHOT_FILE, "binary", frames);
+        if (out->bin == NULL && frames >= 0)
+        {
+            free(out);
+            return NULL;
+        }
+        if (out->bin == NULL) out->format &= ~CFD_OUTPUT_BINARY;
+    }
+    if (out->format & CFD_OUTPUT_COMPRESSED)
+    {
+        memcpy(hdr.magic, CFD_SNAPSHOT_Z_MAGIC, sizeof(hdr.magic));
+        if (openCompressed(out, cfg, &hdr, frames) != 0)
+        {
+            cfdOutputClose(out);
+            return NULL;
+        }
+    }
+
+    if (out->format != 0 && !isIdentitySampling(out, s->nx))
+    {
+        printf("[INFO] Snapshot sampling: idx [%d, %d) stride %d (%s), %d points, every %d snapshot(s)\n",
+               out->window_start, out->window_end, out->stride,
+               out->sampling == CFD_SAMPLE_MINMAX ? "min/max" : "point", out->npoints, out->every);
+    }
+
+    if (cfg->output_queue > 0 && out->format != 0)
+    {
+        startWriter(out, cfg->output_queue);
+    }
+    if (!out->async && !isIdentitySampling(out, s->nx))
+    {
+        const i32 n = out->npoints;
+        out->scratch.npoints = n;
+        out->scratch.rho = (f64 *)malloc(sizeof(f64) * 3 * (size_t)n);
+        if (!out->scratch.rho)
+        {
+            printf("[ERROR] Memory allocation failed for snapshot sampling buffer\n");
+            cfdOutputClose(out);
+            return NULL;
+        }
+        out->scratch.vel = out->scratch.rho + n;
+        out->scratch.pres = out->scratch.rho + 2 * (size_t)n;
+    }
+    return out;
+}
+
+void cfdOutputWrite(CfdOutput *out, const CfdSolver *s)
+{
+    /* 时间方向的抽取：每 every 个快照时刻只写一帧 */
+    if (out->calls++ % out->every != 0) return;
+
+    if (!out->async)
+    {
+        if (out->scratch.rho)
+        {
+            cfdOutputSample(out, s, &out->scratch);
+            writeFrame(out, &out->scratch);
+        }
+        else
+        {
+            CfdFrame frame = {s->t, s->nx, s->rho, s->vel, s->pres};
+            writeFrame(out, &frame);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&out->lock);
+    if (out->count == out->capacity)
+    {
+        out->stalls++;
+        while (out->count == out->capacity)
+        {
+            pthread_cond_wait(&out->not_full, &out->lock);
+        }
+    }
+    CfdFrame *frame = &out->slots[(out->head + out->count) % out->capacity];
+    pthread_mutex_unlock(&out->lock);
+
+    /* 空闲帧此时只属于求解线程，采样复制时无需持锁 */
+    cfdOutputSample(out, s, frame);
+
+    pthread_mutex_lock(&out->lock);
+    out->count++;
+    pthread_cond_signal(&out->not_empty);
+    pthread_mutex_unlock(&out->lock);
+}
+
+i64 cfdOutputFlush(CfdOutput *out)
+{
+    if (out->async)
+    {
+        /* 写线程每写完一帧发一次 not_full */
+        pthread_mutex_lock(&out->lock);
+        while (out->count > 0)
+        {
+            pthread_cond_wait(&out->not_full, &out->lock);
+        }
+        pthread_mutex_unlock(&out->lock);
+    }
+    return out->frames;
+}
+
+void cfdOutputClose(CfdOutput *out)
+{
+    if (!out) return;
+    if (out->async)
+    {
+        pthread_mutex_lock(&out->lock);
+        out->stop = 1;
+        pthread_cond_signal(&out->not_empty);
+        pthread_mutex_unlock(&out->lock);
+        pthread_join(out->thread, NULL);
+
+        pthread_mutex_destroy(&out->lock);
+        pthread_cond_destroy(&out->not_empty);
+        pthread_cond_destroy(&out->not_full);
+        free(out->slots);
+        free(out->storage);
+        if (out->stalls > 0)
+        {
+            printf("[INFO] Snapshot queue was full %lld times; consider a larger output_queue.\n", out->stalls);
+        }
+    }
+    free(out->scratch.rho);
+    free(out->zres);
+    free(out->zbuf);
+    if (out->zbin)
+    {
+        fclose(out->zbin);
+        printf("[INFO] Wrote %lld compressed snapshot frames to %s/%s (%.1f%% of the uncompressed size)\n",
+               out->frames, out->dir, CFD_SNAPSHOT_Z_FILE, out->zraw > 0 ? 100.0 * out->zbytes / out->zraw : 0.0);
+    }
+    if (out->bin)
+    {
+        fclose(out->bin);
+        printf("[INFO] Wrote %lld binary snapshot frames to %s/%s\n", out->frames, out->dir, CFD_SNAPSHOT_FILE);
+    }
+    free(out);
+}
+
+/* 写出一个 CSV 快照，采样方式与二进制文件相同 */
+void cfdWriteSnapshotCsv(const CfdOutput *out_cfg, const CfdFrame *frame)
+{
+    char filename[CFD_PATH_MAX + 64];
+    snprintf(filename, sizeof(filename), "%s/snapshot_%.6e.csv", out_cfg->dir, frame->t);
+    FILE *out = fopen(filename, "w");
+    if (out == NULL){
+        printf("[WARN] Cannot open %s for writing; continuing without CSV output.\n", filename);
+    } else {
+        fprintf(out, "time,idx,rho,vel,pres\n");
+        for (i32 k = 0; k < frame->npoints; k++){
+            fprintf(out, "%.6f,%d,%.12e,%.12e,%.12e\n", frame->t, cfdOutputSampleIndex(out_cfg, k),
+                    frame->rho[k], frame->vel[k], frame->pres[k]);
+        }
+    fclose(out);
+    printf("[INFO] Saved snapshot at t=%.6f to %s\n", frame->t, filename);
+    }
+}
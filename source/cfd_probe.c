@@ -0,0 +1,148 @@
+/*
+    source/cfd_probe.c
+    探针时间序列：逐点采样与流式写出
+*/
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "cfd_probe.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/* 探针按步采样，记录很小；攒满较大的缓冲区再交给文件系统 */
+#define CFD_PROBE_BUFFER_BYTES (1 << 20)
+
+static i32 recordLength(const CfdProbes *pr)
+{
+    return 4 + 3 * pr->nprobes;
+}
+
+/* 续写已有的探针文件：文件头与下标表须与当前设置一致，截掉 samples 条之后的记录 */
+static FILE *resumeProbes(const char *filename, const CfdProbeHeader *hdr, const i64 *idx, i64 samples)
+{
+    FILE *fp = fopen(filename, "r+b");
+    if (fp == NULL)
+    {
+        printf("[ERROR] Cannot reopen %s to resume probe output\n", filename);
+        return NULL;
+    }
+    CfdProbeHeader old;
+    i64 old_idx[CFD_PROBE_MAX];
+    const i64 n = hdr->nprobes;
+    const i64 keep = (i64)hdr->header_bytes + samples * (i64)sizeof(f64) * (4 + 3 * n);
+    struct stat st;
+    if (fread(&old, sizeof(old), 1, fp) != 1 || memcmp(old.magic, hdr->magic, sizeof(old.magic)) != 0
+        || old.version != hdr->version || old.header_bytes != hdr->header_bytes || old.nx != hdr->nx
+        || old.nprobes != n || old.every != hdr->every
+        || fread(old_idx, sizeof(i64), (size_t)n, fp) != (size_t)n || memcmp(old_idx, idx, sizeof(i64) * (size_t)n) != 0)
+    {
+        printf("[ERROR] %s does not match the current probe settings; cannot resume\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+    if (fstat(fileno(fp), &st) != 0 || (i64)st.st_size < keep)
+    {
+        printf("[ERROR] %s holds fewer than the %lld records recorded in the checkpoint\n", filename, samples);
+        fclose(fp);
+        return NULL;
+    }
+    fflush(fp);
+    if (ftruncate(fileno(fp), (off_t)keep) != 0 || fseek(fp, 0, SEEK_END) != 0)
+    {
+        printf("[ERROR] Cannot truncate %s to resume probe output\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+CfdProbes *cfdProbesOpen(const CfdConfig *cfg, const CfdSolver *s, i64 resume_samples)
+{
+    CfdProbes *pr = (CfdProbes *)calloc(1, sizeof(CfdProbes));
+    if (!pr)
+    {
+        printf("[ERROR] Memory allocation failed for probes\n");
+        return NULL;
+    }
+    pr->nprobes = cfg->probe_count;
+    pr->every = cfg->probe_every;
+    i64 idx[CFD_PROBE_MAX];
+    for (i32 k = 0; k < pr->nprobes; k++)
+    {
+        pr->idx[k] = cfg->probe_idx[k] < 0 ? s->nx + cfg->probe_idx[k] : cfg->probe_idx[k];
+        idx[k] = pr->idx[k];
+    }
+
+    CfdProbeHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, CFD_PROBE_MAGIC, sizeof(hdr.magic));
+    hdr.version = CFD_PROBE_VERSION;
+    hdr.header_bytes = (u32)(sizeof(hdr) + sizeof(i64) * (size_t)pr->nprobes);
+    hdr.nx = s->nx;
+    hdr.nprobes = pr->nprobes;
+    hdr.every = pr->every;
+    hdr.dx = s->dx;
+    hdr.dt = s->dt;
+    if (s->grid)
+    {
+        hdr.grid_stretch = s->grid->stretch;
+        hdr.grid_length = s->grid->length;
+    }
+
+    char filename[CFD_PATH_MAX + 64];
+    snprintf(filename, sizeof(filename), "%s/%s", cfg->output_dir, CFD_PROBE_FILE);
+    if (resume_samples >= 0)
+    {
+        pr->fp = resumeProbes(filename, &hdr, idx, resume_samples);
+        pr->samples = resume_samples;
+    }
+    else if ((pr->fp = fopen(filename, "wb")) != NULL)
+    {
+        fwrite(&hdr, sizeof(hdr), 1, pr->fp);
+        fwrite(idx, sizeof(i64), (size_t)pr->nprobes, pr->fp);
+    }
+    else
+    {
+        printf("[ERROR] Cannot open %s for writing\n", filename);
+    }
+    if (pr->fp == NULL)
+    {
+        free(pr);
+        return NULL;
+    }
+    setvbuf(pr->fp, NULL, _IOFBF, CFD_PROBE_BUFFER_BYTES);
+    printf("[INFO] Recording %d probe(s) every %d step(s) to %s\n", pr->nprobes, pr->every, filename);
+    return pr;
+}
+
+void cfdProbesSample(CfdProbes *pr, const CfdSolver *s)
+{
+    f64 *r = pr->record;
+    r[0] = s->t;
+    r[1] = s->pa.acc;
+    pistonAccelKinematics(&s->pa, &r[2], &r[3]);
+    cfdSolverFetchPoints(s, pr->idx, pr->nprobes);
+    for (i32 k = 0; k < pr->nprobes; k++)
+    {
+        cfdSolverPoint(s, pr->idx[k], r + 4 + 3 * k);
+    }
+    fwrite(r, sizeof(f64), (size_t)recordLength(pr), pr->fp);
+    pr->samples++;
+}
+
+i64 cfdProbesFlush(CfdProbes *pr)
+{
+    fflush(pr->fp);
+    return pr->samples;
+}
+
+void cfdProbesClose(CfdProbes *pr)
+{
+    if (pr == NULL) return;
+    fclose(pr->fp);
+    printf("[INFO] Wrote %lld probe records\n", pr->samples);
+    free(pr);
+}
@@ -0,0 +1,188 @@
+/*
+    source/cfd_report.c
+    运行过程报告：墙钟计时、终端进度显示与分阶段性能统计
+*/
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "cfd_report.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+f64 cfdWallTime(void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + 1e-9 * (f64)ts.tv_nsec;
+#endif
+}
+
+/* 把秒数格式化为 HH:MM:SS，超过 99:59:59 的按 99:59:59 显示，9 字节的 buf 总能放下 */
+static void formatDuration(char *buf, size_t size, f64 secs)
+{
+    if (!(secs > 0.0)) secs = 0.0;
+    if (secs > 359999.0) secs = 359999.0;
+    const i32 total = (i32)(secs + 0.5);
+    snprintf(buf, size, "%02d:%02d:%02d", total / 3600, (total / 60) % 60, total % 60);
+}
+
+void cfdProgressBegin(CfdProgress *p, i32 quiet, i64 first_step, f64 first_progress)
+{
+    p->quiet = quiet;
+    p->tty = isatty(fileno(stdout));
+    p->pending = 0;
+    p->start = cfdWallTime();
+    p->first_step = first_step;
+    p->first_progress = first_progress;
+}
+
+void cfdProgressUpdate(CfdProgress *p, f64 t, i64 step, i64 total, f64 progress, const char *line)
+{
+    if (p->quiet) return;
+
+    f64 elapsed = cfdWallTime() - p->start;
+    char eta[16] = "--:--:--";
+    /* 续算时只计本次运行推进的步数；前几步的耗时包含首次访存等开销，不用于估计 */
+    const i64 run_steps = step - p->first_step;
+    const f64 run_progress = progress - p->first_progress;
+    if (run_steps > 10 && run_progress > 0.0)
+    {
+        formatDuration(eta, sizeof(eta), elapsed * (1.0 - progress) / run_progress);
+    }
+    f64 rate = elapsed > 0.0 ? (f64)run_steps / elapsed : 0.0;
+
+    char steps[48];
+    if (total > 0) snprintf(steps, sizeof(steps), "%lld/%lld", step, total);
+    else           snprintf(steps, sizeof(steps), "%lld", step);
+
+    /* 终端上回到行首并清除整行，其余情况逐行输出 */
+    if (p->tty) printf("\r\033[K");
+    printf("t=%.8f step=%s (%.2f%%) %.0f steps/s ETA: %s%s%s",
+           t, steps, progress * 100.0, rate, eta, line ? " | " : "", line ? line : "");
+    if (p->tty)
+    {
+        p->pending = 1;
+    }
+    else
+    {
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+void cfdProgressEnd(CfdProgress *p, i64 steps)
+{
+    if (p->pending)
+    {
+        printf("\n");
+        p->pending = 0;
+    }
+    char buf[16];
+    f64 elapsed = cfdWallTime() - p->start;
+    formatDuration(buf, sizeof(buf), elapsed);
+    printf("[INFO] Finished %lld steps in %s (%.3f s wall)\n", steps, buf, elapsed);
+    fflush(stdout);
+}
+
+static const char *phase_names[CFD_PHASE_COUNT] = {
+    "fused", "velocity", "rho", "border", "pressure", "swap", "piston", "cfl", "output", "region", "shadow", "checkpoint", "probe", "halo", "temporal", "stages",
+};
+
+void cfdTimersReset(CfdTimers *tm)
+{
+    memset(tm, 0, sizeof(*tm));
+}
+
+f64 cfdTimersAdd(CfdTimers *tm, i32 phase, f64 t0, f64 bytes)
+{
+    f64 now = cfdWallTime();
+    tm->seconds[phase] += now - t0;
+    tm->calls[phase]++;
+    tm->bytes[phase] += bytes;
+    return now;
+}
+
+i32 cfdReportSummary(const CfdTimers *tm, i32 nx, i64 steps, f64 wall, const char *path)
+{
+    f64 timed = 0.0, bytes = 0.0;
+    for (i32 k = 0; k < CFD_PHASE_COUNT; k++)
+    {
+        timed += tm->seconds[k];
+        bytes += tm->bytes[k];
+    }
+    /* 吞吐量按推进循环的总墙钟时间计算，包含未计时的部分（进度输出等） */
+    f64 updates = (f64)nx * (f64)steps;
+    f64 mpts = wall > 0.0 ? updates / wall * 1e-6 : 0.0;
+    f64 gbs = wall > 0.0 ? bytes / wall * 1e-9 : 0.0;
+#ifdef _OPENMP
+    i32 threads = omp_get_max_threads();
+#else
+    i32 threads = 1;
+#endif
+
+    printf("[INFO] Performance: %.2f Mpoint-updates/s, %.2f GB/s effective, %.3f s wall (%.1f%% timed)\n",
+           mpts, gbs, wall, wall > 0.0 ? 100.0 * timed / wall : 0.0);
+    printf("    %-10s %12s %8s %12s %10s\n", "phase", "seconds", "share", "ns/point", "GB/s");
+    for (i32 k = 0; k < CFD_PHASE_COUNT; k++)
+    {
+        if (tm->calls[k] == 0) continue;
+        printf("    %-10s %12.6f %7.2f%% %12.3f %10.2f\n", phase_names[k], tm->seconds[k],
+               wall > 0.0 ? 100.0 * tm->seconds[k] / wall : 0.0,
+               updates > 0.0 ? tm->seconds[k] / updates * 1e9 : 0.0,
+               tm->seconds[k] > 0.0 ? tm->bytes[k] / tm->seconds[k] * 1e-9 : 0.0);
+    }
+
+    if (path == NULL || path[0] == '\0') return 0;
+    FILE *out = fopen(path, "w");
+    if (out == NULL)
+    {
+        printf("[WARN] Cannot open %s for writing; skipping performance summary.\n", path);
+        return -1;
+    }
+    fprintf(out, "{\n");
+#ifdef CFD_REFERENCE_KERNEL
+    fprintf(out, "  \"kernel\": \"reference\",\n");
+#else
+    fprintf(out, "  \"kernel\": \"fused\",\n");
+#endif
+    fprintf(out, "  \"threads\": %d,\n", threads);
+    fprintf(out, "  \"nx\": %d,\n", nx);
+    fprintf(out, "  \"steps\": %lld,\n", steps);
+    fprintf(out, "  \"wall_seconds\": %.9g,\n", wall);
+    fprintf(out, "  \"timed_seconds\": %.9g,\n", timed);
+    fprintf(out, "  \"point_updates_per_second\": %.9g,\n", wall > 0.0 ? updates / wall : 0.0);
+    fprintf(out, "  \"bytes\": %.9g,\n", bytes);
+    fprintf(out, "  \"bandwidth_bytes_per_second\": %.9g,\n", wall > 0.0 ? bytes / wall : 0.0);
+    fprintf(out, "  \"phases\": {");
+    i32 first = 1;
+    for (i32 k = 0; k < CFD_PHASE_COUNT; k++)
+    {
+        if (tm->calls[k] == 0) continue;
+        fprintf(out, "%s\n    \"%s\": {\"seconds\": %.9g, \"calls\": %lld, \"bytes\": %.9g, "
+                     "\"ns_per_point\": %.9g, \"bandwidth_bytes_per_second\": %.9g}",
+                first ? "" : ",", phase_names[k], tm->seconds[k], tm->calls[k], tm->bytes[k],
+                updates > 0.0 ? tm->seconds[k] / updates * 1e9 : 0.0,
+                tm->seconds[k] > 0.0 ? tm->bytes[k] / tm->seconds[k] : 0.0);
+        first = 0;
+    }
+    fprintf(out, "\n  }\n}\n");
+    fclose(out);
+    printf("[INFO] Wrote performance summary to %s\n", path);
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+    source/cfd_simd.c
+    向量化的内部点模板核与运行时指令集选择
+*/
+#include "cfd_simd.h"
+#include "cfd_stencil.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+    模板核循环体。各个实现只是用不同的 target 属性编译同一段循环，
+    fusedPoint 被强制内联进来，由 omp simd 按所在函数的指令集向量化。
+    看门狗开启时走带归约的同一段循环，新值写出后立即参与归约，不再从内存读回。
+*/
+static CFD_ALWAYS_INLINE void simdRange(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    const f64 *restrict rho = s->rho;
+    const f64 *restrict vel = s->vel;
+    f64 *restrict new_rho = s->rho_next;
+    f64 *restrict new_vel = s->vel_next;
+    const f64 dt = s->dt;
+    const f64 half_dt2 = s->half_dt2;
+    const f64 inv_2dx = 1.0 / (2 * s->dx);
+    const f64 inv_dx2 = 1.0 / (s->dx * s->dx);
+    if (!w)
+    {
+#pragma omp simd
+        for (i32 i = lo; i < hi; i++)
+        {
+            fusedPoint(rho, vel, new_rho, new_vel, dt, half_dt2, inv_2dx, inv_dx2, acc, i);
+        }
+        return;
+    }
+    f64 vmax = w->vmax, rmin = w->rmin, bad = w->bad;
+#pragma omp simd reduction(max:vmax) reduction(min:rmin) reduction(+:bad)
+    for (i32 i = lo; i < hi; i++)
+    {
+        fusedPoint(rho, vel, new_rho, new_vel, dt, half_dt2, inv_2dx, inv_dx2, acc, i);
+        vmax = watchMax(vmax, new_vel[i]);
+        rmin = watchMin(rmin, new_rho[i]);
+        bad = watchBad(bad, new_rho[i], new_vel[i]);
+    }
+    w->vmax = vmax;
+    w->rmin = rmin;
+    w->bad = bad;
+}
+
+/* 混合精度版本：f32 存储，f64 计算；看门狗检查的是舍入到 f32 后存下的值 */
+static CFD_ALWAYS_INLINE void simdRangeMixed(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    const f32 *restrict drho = s->drho;
+    const f32 *restrict vel = s->vel32;
+    f32 *restrict new_drho = s->drho_next;
+    f32 *restrict new_vel = s->vel32_next;
+    const f64 dt = s->dt;
+    const f64 half_dt2 = s->half_dt2;
+    const f64 inv_2dx = 1.0 / (2 * s->dx);
+    const f64 inv_dx2 = 1.0 / (s->dx * s->dx);
+    if (!w)
+    {
+#pragma omp simd
+        for (i32 i = lo; i < hi; i++)
+        {
+            fusedPointMixed(drho, vel, new_drho, new_vel, dt, half_dt2, inv_2dx, inv_dx2, acc, i);
+        }
+        return;
+    }
+    f64 vmax = w->vmax, rmin = w->rmin, bad = w->bad;
+#pragma omp simd reduction(max:vmax) reduction(min:rmin) reduction(+:bad)
+    for (i32 i = lo; i < hi; i++)
+    {
+        fusedPointMixed(drho, vel, new_drho, new_vel, dt, half_dt2, inv_2dx, inv_dx2, acc, i);
+        vmax = watchMax(vmax, (f64)new_vel[i]);
+        rmin = watchMin(rmin, RHO_INIT + (f64)new_drho[i]);
+        bad = watchBad(bad, RHO_INIT + (f64)new_drho[i], (f64)new_vel[i]);
+    }
+    w->vmax = vmax;
+    w->rmin = rmin;
+    w->bad = bad;
+}
+
+static void interiorScalar(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    const f64 inv_2dx = 1.0 / (2 * s->dx);
+    const f64 inv_dx2 = 1.0 / (s->dx * s->dx);
+    for (i32 i = lo; i < hi; i++)
+    {
+        fusedPoint(s->rho, s->vel, s->rho_next, s->vel_next, s->dt, s->half_dt2, inv_2dx, inv_dx2, acc, i);
+        if (w)
+        {
+            watchPoint(s->rho_next[i], s->vel_next[i], &w->vmax, &w->rmin, &w->bad);
+        }
+    }
+}
+
+static void interiorGeneric(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    simdRange(s, acc, lo, hi, w);
+}
+
+static void interiorMixedScalar(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    const f64 inv_2dx = 1.0 / (2 * s->dx);
+    const f64 inv_dx2 = 1.0 / (s->dx * s->dx);
+    for (i32 i = lo; i < hi; i++)
+    {
+        fusedPointMixed(s->drho, s->vel32, s->drho_next, s->vel32_next, s->dt, s->half_dt2,
+                        inv_2dx, inv_dx2, acc, i);
+        if (w)
+        {
+            watchPoint(RHO_INIT + (f64)s->drho_next[i], (f64)s->vel32_next[i], &w->vmax, &w->rmin, &w->bad);
+        }
+    }
+}
+
+static void interiorMixedGeneric(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    simdRangeMixed(s, acc, lo, hi, w);
+}
+
+#ifdef CFD_SIMD_X86
+CFD_TARGET("avx2")
+static void interiorAvx2(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    simdRange(s, acc, lo, hi, w);
+}
+
+CFD_TARGET("avx512f")
+static void interiorAvx512(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    simdRange(s, acc, lo, hi, w);
+}
+
+CFD_TARGET("avx2")
+static void interiorMixedAvx2(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    simdRangeMixed(s, acc, lo, hi, w);
+}
+
+CFD_TARGET("avx512f")
+static void interiorMixedAvx512(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    simdRangeMixed(s, acc, lo, hi, w);
+}
+#endif
+
+static const char *simd_names[] = {"scalar", "generic", "avx2", "avx512"};
+
+i32 cfdSimdParse(const char *name)
+{
+    if (strcmp(name, "auto") == 0) return CFD_SIMD_AUTO;
+    for (i32 k = CFD_SIMD_SCALAR; k <= CFD_SIMD_AVX512; k++)
+    {
+        if (strcmp(name, simd_names[k]) == 0) return k;
+    }
+    return -2;
+}
+
+const char *cfdSimdName(i32 level)
+{
+    if (level == CFD_SIMD_AUTO) return "auto";
+    if (level < CFD_SIMD_SCALAR || level > CFD_SIMD_AVX512) return "unknown";
+    return simd_names[level];
+}
+
+/* 当前 CPU 能运行的最高一级 */
+static i32 simdDetect(void)
+{
+#ifdef CFD_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return CFD_SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2"))    return CFD_SIMD_AVX2;
+#endif
+    return CFD_SIMD_GENERIC;
+}
+
+i32 cfdSimdResolve(i32 requested)
+{
+    i32 best = simdDetect();
+    if (requested == CFD_SIMD_AUTO) return best;
+    if (requested > best)
+    {
+        printf("[WARN] %s kernel is not supported on this CPU; using %s instead.\n",
+               cfdSimdName(requested), cfdSimdName(best));
+        return best;
+    }
+    return requested;
+}
+
+void cfdSimdInterior(i32 level, CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    switch (level)
+    {
+#ifdef CFD_SIMD_X86
+    case CFD_SIMD_AVX512: interiorAvx512(s, acc, lo, hi, w);  break;
+    case CFD_SIMD_AVX2:   interiorAvx2(s, acc, lo, hi, w);    break;
+#endif
+    case CFD_SIMD_GENERIC: interiorGeneric(s, acc, lo, hi, w); break;
+    default:               interiorScalar(s, acc, lo, hi, w);  break;
+    }
+}
+
+void cfdSimdInteriorMixed(i32 level, CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    switch (level)
+    {
+#ifdef CFD_SIMD_X86
+    case CFD_SIMD_AVX512:  interiorMixedAvx512(s, acc, lo, hi, w);  break;
+    case CFD_SIMD_AVX2:    interiorMixedAvx2(s, acc, lo, hi, w);    break;
+#endif
+    case CFD_SIMD_GENERIC: interiorMixedGeneric(s, acc, lo, hi, w); break;
+    default:               interiorMixedScalar(s, acc, lo, hi, w);  break;
+    }
+}
@@ -0,0 +1,347 @@
+/*
+    source/cfd_stepper.c
+    多级时间格式：SSP-RK3、RK4 与 MacCormack 的各级遍历
+*/
+#include "cfd_stepper.h"
+#include "cfd_stencil.h"
+#include "cfd_differentials.h"
+#include "cfd_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+static const char *stepper_names[] = {"taylor", "ssprk3", "rk4", "maccormack"};
+#define CFD_STEPPER_COUNT ((i32)(sizeof(stepper_names) / sizeof(stepper_names[0])))
+
+i32 cfdStepperParse(const char *name)
+{
+    for (i32 k = 0; k < CFD_STEPPER_COUNT; k++)
+    {
+        if (strcmp(name, stepper_names[k]) == 0) return k;
+    }
+    return -1;
+}
+
+const char *cfdStepperName(i32 stepper)
+{
+    if (stepper < 0 || stepper >= CFD_STEPPER_COUNT) return "unknown";
+    return stepper_names[stepper];
+}
+
+f64 cfdStepperCflLimit(i32 stepper)
+{
+    /* 中心差分的特征值在虚轴上，RK3/RK4 的稳定域在虚轴上延伸到 sqrt(3) 与 2 sqrt(2) */
+    switch (stepper)
+    {
+    case CFD_STEPPER_SSPRK3: return 1.7;
+    case CFD_STEPPER_RK4:    return 2.8;
+    default:                 return 1.0;
+    }
+}
+
+i32 cfdStepperStages(i32 stepper)
+{
+    switch (stepper)
+    {
+    case CFD_STEPPER_SSPRK3:     return 1;
+    case CFD_STEPPER_RK4:        return 2;
+    case CFD_STEPPER_MACCORMACK: return 1;
+    default:                     return 0;
+    }
+}
+
+i32 cfdStepperAlloc(CfdSolver *s)
+{
+    size_t bytes = sizeof(f64) * (size_t)s->nx;
+    for (i32 k = 0; k < cfdStepperStages(s->stepper); k++)
+    {
+        s->stage_rho[k] = (f64 *)malloc(bytes);
+        s->stage_vel[k] = (f64 *)malloc(bytes);
+        if (!s->stage_rho[k] || !s->stage_vel[k]) return -1;
+    }
+    return 0;
+}
+
+void cfdStepperFree(CfdSolver *s)
+{
+    for (i32 k = 0; k < 2; k++)
+    {
+        free(s->stage_rho[k]);
+        free(s->stage_vel[k]);
+        s->stage_rho[k] = s->stage_vel[k] = NULL;
+    }
+}
+
+/*
+    参考核构建中中心差分的右端项直接调用 cfd_differentials.c 的 prho_pt/pvx_pt，
+    view 是指向阶段状态的求解器视图；否则用 cfd_stencil.h 中展开式相同的内联版本。
+*/
+static CFD_ALWAYS_INLINE void centralRhs(const CfdSolver *view, const f64 *r, const f64 *v, i32 i,
+                                         f64 inv_2dx, f64 acc, f64 *rt, f64 *vt)
+{
+#ifdef CFD_REFERENCE_KERNEL
+    (void)r;
+    (void)v;
+    (void)inv_2dx;
+    *rt = prho_pt(view, i);
+    *vt = pvx_pt(view, i, acc);
+#else
+    (void)view;
+    firstDerivs(r[i - 1], r[i], r[i + 1], v[i - 1], v[i], v[i + 1], inv_2dx, acc, rt, vt);
+#endif
+}
+
+static CFD_ALWAYS_INLINE f64 delta4(const f64 *u, i32 i)
+{
+    return u[i + 2] - 4 * u[i + 1] + 6 * u[i] - 4 * u[i - 1] + u[i - 2];
+}
+
+/*
+    内部点 [2, nx - 2) 的右端项：中心差分加四阶耗散。
+    eps_dx = CFD_STEPPER_DISSIPATION / dx，c 为声速 sqrt(K)
+*/
+static CFD_ALWAYS_INLINE void interiorRhs(const CfdSolver *view, const f64 *r, const f64 *v, i32 i,
+                                          f64 inv_2dx, f64 eps_dx, f64 c, f64 acc, f64 *rt, f64 *vt)
+{
+    centralRhs(view, r, v, i, inv_2dx, acc, rt, vt);
+    const f64 lam = eps_dx * (fabs(v[i]) + c);
+    *rt -= lam * delta4(r, i);
+    *vt -= lam * delta4(v, i);
+}
+
+static void stageView(CfdSolver *view, const CfdSolver *s, const f64 *r, const f64 *v)
+{
+#ifdef CFD_REFERENCE_KERNEL
+    memset(view, 0, sizeof(*view));
+    view->nx = s->nx;
+    view->dx = s->dx;
+    view->rho = (f64 *)r;
+    view->vel = (f64 *)v;
+#else
+    (void)view;
+    (void)s;
+    (void)r;
+    (void)v;
+#endif
+}
+
+/*
+    靠近两端的四个点 {0, 1, nx - 2, nx - 1} 的右端项。端点用单边差分（与 prho_px/pvx_px
+    在端点的取法相同），活塞壁面 ∂v/∂t = 0；次端点放不下五点耗散模板，只用中心差分。
+*/
+static void edgeRhs(const CfdSolver *s, const CfdSolver *view, const f64 *r, const f64 *v, f64 acc,
+                    i32 *idx, f64 *rt, f64 *vt)
+{
+    const i32 c = s->nx - 1;
+    const f64 inv_dx = 1.0 / s->dx;
+    idx[0] = 0;
+    idx[1] = 1;
+    idx[2] = c - 1;
+    idx[3] = c;
+    firstDerivs(r[0], r[0], r[1], v[0], v[0], v[1], inv_dx, acc, &rt[0], &vt[0]);
+    vt[0] = 0.0;
+    centralRhs(view, r, v, 1, 0.5 * inv_dx, acc, &rt[1], &vt[1]);
+    centralRhs(view, r, v, c - 1, 0.5 * inv_dx, acc, &rt[2], &vt[2]);
+    firstDerivs(r[c - 1], r[c], r[c], v[c - 1], v[c], v[c], inv_dx, acc, &rt[3], &vt[3]);
+}
+
+/* SSP-RK3 的一级：out = a * u + b * in + c * dt * L(in)，u 为步初的状态 */
+static void stageCombine(const CfdSolver *s, const f64 *restrict ur, const f64 *restrict uv,
+                         const f64 *restrict ir, const f64 *restrict iv,
+                         f64 *restrict out_r, f64 *restrict out_v, f64 acc, f64 a, f64 b, f64 c)
+{
+    const i32 nx = s->nx;
+    const f64 cdt = c * s->dt;
+    const f64 inv_2dx = 1.0 / (2 * s->dx);
+    const f64 eps_dx = CFD_STEPPER_DISSIPATION / s->dx, sound = sqrt(K);
+    CfdSolver view;
+    stageView(&view, s, ir, iv);
+    i32 idx[4];
+    f64 rt[4], vt[4];
+    edgeRhs(s, &view, ir, iv, acc, idx, rt, vt);
+    for (i32 k = 0; k < 4; k++)
+    {
+        const i32 i = idx[k];
+        out_r[i] = a * ur[i] + b * ir[i] + cdt * rt[k];
+        out_v[i] = a * uv[i] + b * iv[i] + cdt * vt[k];
+    }
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(CFD_OMP_SCHEDULE)
+#endif
+    for (i32 i = 2; i < nx - 2; i++)
+    {
+        f64 r_t, v_t;
+        interiorRhs(&view, ir, iv, i, inv_2dx, eps_dx, sound, acc, &r_t, &v_t);
+        out_r[i] = a * ur[i] + b * ir[i] + cdt * r_t;
+        out_v[i] = a * uv[i] + b * iv[i] + cdt * v_t;
+    }
+}
+
+/*
+    RK4 的一级：out = u + c * dt * L(in)（out 为 NULL 时不写，即最后一级），
+    同时累加 sum = base + w * dt * L(in)；第一级 base 为 u，其余各级 base 就是 sum。
+*/
+static void stageAccumulate(const CfdSolver *s, const f64 *restrict ur, const f64 *restrict uv,
+                            const f64 *restrict ir, const f64 *restrict iv,
+                            f64 *restrict out_r, f64 *restrict out_v,
+                            const f64 *base_r, const f64 *base_v, f64 *sum_r, f64 *sum_v,
+                            f64 acc, f64 c, f64 w)
+{
+    const i32 nx = s->nx;
+    const f64 cdt = c * s->dt, wdt = w * s->dt;
+    const f64 inv_2dx = 1.0 / (2 * s->dx);
+    const f64 eps_dx = CFD_STEPPER_DISSIPATION / s->dx, sound = sqrt(K);
+    CfdSolver view;
+    stageView(&view, s, ir, iv);
+    i32 idx[4];
+    f64 rt[4], vt[4];
+    edgeRhs(s, &view, ir, iv, acc, idx, rt, vt);
+    for (i32 k = 0; k < 4; k++)
+    {
+        const i32 i = idx[k];
+        if (out_r)
+        {
+            out_r[i] = ur[i] + cdt * rt[k];
+            out_v[i] = uv[i] + cdt * vt[k];
+        }
+        sum_r[i] = base_r[i] + wdt * rt[k];
+        sum_v[i] = base_v[i] + wdt * vt[k];
+    }
+    if (out_r)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(CFD_OMP_SCHEDULE)
+#endif
+        for (i32 i = 2; i < nx - 2; i++)
+        {
+            f64 r_t, v_t;
+            interiorRhs(&view, ir, iv, i, inv_2dx, eps_dx, sound, acc, &r_t, &v_t);
+            out_r[i] = ur[i] + cdt * r_t;
+            out_v[i] = uv[i] + cdt * v_t;
+            sum_r[i] = base_r[i] + wdt * r_t;
+            sum_v[i] = base_v[i] + wdt * v_t;
+        }
+    }
+    else
+    {
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(CFD_OMP_SCHEDULE)
+#endif
+        for (i32 i = 2; i < nx - 2; i++)
+        {
+            f64 r_t, v_t;
+            interiorRhs(&view, ir, iv, i, inv_2dx, eps_dx, sound, acc, &r_t, &v_t);
+            sum_r[i] = base_r[i] + wdt * r_t;
+            sum_v[i] = base_v[i] + wdt * v_t;
+        }
+    }
+}
+
+/*
+    Shu-Osher 形式的三级 SSP-RK3，各级时刻 t、t + dt、t + dt/2：
+        u1 = u + dt L(u)
+        u2 = 3/4 u + 1/4 u1 + 1/4 dt L(u1)
+        u3 = 1/3 u + 2/3 u2 + 2/3 dt L(u2)
+    u1 与 u3 写在同一个阶段缓冲中，u2 写在 *_next 中，最后与阶段缓冲交换指针。
+*/
+static void stepSsprk3(CfdSolver *s, f64 acc0, f64 acc_half, f64 acc1)
+{
+    f64 *ar = s->stage_rho[0], *av = s->stage_vel[0];
+    stageCombine(s, s->rho, s->vel, s->rho, s->vel, ar, av, acc0, 0.0, 1.0, 1.0);
+    stageCombine(s, s->rho, s->vel, ar, av, s->rho_next, s->vel_next, acc1, 0.75, 0.25, 0.25);
+    stageCombine(s, s->rho, s->vel, s->rho_next, s->vel_next, ar, av, acc_half, 1.0 / 3.0, 2.0 / 3.0, 2.0 / 3.0);
+    s->stage_rho[0] = s->rho_next;
+    s->stage_vel[0] = s->vel_next;
+    s->rho_next = ar;
+    s->vel_next = av;
+}
+
+/*
+    经典 RK4。*_next 累加 u + dt (k1 + 2 k2 + 2 k3 + k4) / 6，
+    两个阶段缓冲轮流存放下一级的输入 u + c dt k。
+*/
+static void stepRk4(CfdSolver *s, f64 acc0, f64 acc_half, f64 acc1)
+{
+    const f64 *ur = s->rho, *uv = s->vel;
+    f64 *ar = s->stage_rho[0], *av = s->stage_vel[0];
+    f64 *br = s->stage_rho[1], *bv = s->stage_vel[1];
+    f64 *nr = s->rho_next, *nv = s->vel_next;
+    stageAccumulate(s, ur, uv, ur, uv, ar, av, ur, uv, nr, nv, acc0, 0.5, 1.0 / 6.0);
+    stageAccumulate(s, ur, uv, ar, av, br, bv, nr, nv, nr, nv, acc_half, 0.5, 1.0 / 3.0);
+    stageAccumulate(s, ur, uv, br, bv, ar, av, nr, nv, nr, nv, acc_half, 1.0, 1.0 / 3.0);
+    stageAccumulate(s, ur, uv, ar, av, NULL, NULL, nr, nv, nr, nv, acc1, 0.0, 1.0 / 6.0);
+}
+
+/*
+    MacCormack 预测-校正：预测步用前向差分与 t 时刻的加速度，校正步对预测值用后向差分与
+    t + dt 时刻的加速度，结果取两者的平均。前向差分在右端点、后向差分在左端点无法取得，
+    这两个点改用另一侧的单边差分；活塞壁面速度保持为 0。
+*/
+static void stepMacCormack(CfdSolver *s, f64 acc0, f64 acc1)
+{
+    const i32 nx = s->nx, c = nx - 1;
+    const f64 dt = s->dt, inv_dx = 1.0 / s->dx;
+    const f64 *restrict r = s->rho, *restrict v = s->vel;
+    f64 *restrict pr = s->stage_rho[0], *restrict pv = s->stage_vel[0];
+    f64 *restrict nr = s->rho_next, *restrict nv = s->vel_next;
+    f64 rt, vt;
+
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(CFD_OMP_SCHEDULE)
+#endif
+    for (i32 i = 0; i < nx - 1; i++)
+    {
+        f64 r_t, v_t;
+        firstDerivs(r[i], r[i], r[i + 1], v[i], v[i], v[i + 1], inv_dx, acc0, &r_t, &v_t);
+        pr[i] = r[i] + dt * r_t;
+        pv[i] = v[i] + dt * v_t;
+    }
+    pv[0] = 0.0;
+    firstDerivs(r[c - 1], r[c], r[c], v[c - 1], v[c], v[c], inv_dx, acc0, &rt, &vt);
+    pr[c] = r[c] + dt * rt;
+    pv[c] = v[c] + dt * vt;
+
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(CFD_OMP_SCHEDULE)
+#endif
+    for (i32 i = 1; i < nx; i++)
+    {
+        f64 r_t, v_t;
+        firstDerivs(pr[i - 1], pr[i], pr[i], pv[i - 1], pv[i], pv[i], inv_dx, acc1, &r_t, &v_t);
+        nr[i] = 0.5 * (r[i] + pr[i] + dt * r_t);
+        nv[i] = 0.5 * (v[i] + pv[i] + dt * v_t);
+    }
+    firstDerivs(pr[0], pr[0], pr[1], pv[0], pv[0], pv[1], inv_dx, acc1, &rt, &vt);
+    nr[0] = 0.5 * (r[0] + pr[0] + dt * rt);
+    nv[0] = 0.0;
+}
+
+void cfdStepperStep(CfdSolver *s)
+{
+    f64 t0 = cfdWallTime();
+    const f64 nx = (f64)s->nx;
+    /* 步初的加速度沿用活塞上下文的值，步中与步末按时刻精确求值 */
+    const f64 acc0 = s->pa.acc;
+    const f64 acc1 = pistonAccelAt(&s->pa, s->pa.time + s->dt);
+    f64 bytes = 0.0;
+    switch (s->stepper)
+    {
+    case CFD_STEPPER_SSPRK3:
+        stepSsprk3(s, acc0, pistonAccelAt(&s->pa, s->pa.time + 0.5 * s->dt), acc1);
+        bytes = (4 + 6 + 6) * sizeof(f64) * nx;
+        break;
+    case CFD_STEPPER_RK4:
+        stepRk4(s, acc0, pistonAccelAt(&s->pa, s->pa.time + 0.5 * s->dt), acc1);
+        bytes = (6 + 10 + 10 + 6) * sizeof(f64) * nx;
+        break;
+    case CFD_STEPPER_MACCORMACK:
+        stepMacCormack(s, acc0, acc1);
+        bytes = (4 + 6) * sizeof(f64) * nx;
+        break;
+    default:
+        printf("[ERROR] Unknown stepper %d\n", s->stepper);
+        return;
+    }
+    cfdTimersAdd(&s->timers, CFD_PHASE_STAGES, t0, bytes);
+}
@@ -0,0 +1,577 @@
+/*
+    source/cfd_sweep.c
+    参数扫描：作业列表的读取与展开、工作窃取调度与汇总表
+*/
+#include "cfd_sweep.h"
+#include "cfd_report.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define CFD_SWEEP_VARY_MAX      16      // 每个作业（含公共部分）最多的 vary 行数
+#define CFD_SWEEP_VALUES_MAX    64      // 每个 vary 最多的取值个数
+
+typedef struct {
+    char key[64];
+    char values[CFD_SWEEP_VALUES_MAX][128];
+    i32 count;
+} SweepVary;
+
+/* 作业列表中的一节：公共部分或一个 [job] */
+typedef struct {
+    CfdConfig cfg;
+    CfdEnsembleMember member;       // 作业名与活塞曲线
+    i32 named;                      // 是否显式给出了 name
+    i32 custom_profile;             // 是否设置过活塞曲线
+    SweepVary vary[CFD_SWEEP_VARY_MAX];
+    i32 nvary;
+    char keys[CFD_SWEEP_VALUES_MAX][64];  // 本节显式设置的键，覆盖公共部分同名的 vary
+    i32 nkeys;
+} SweepSection;
+
+typedef struct {
+    CfdConfig cfg;
+    CfdEnsembleMember member;
+    i32 custom_profile;
+    f64 cost;                       // 估计的计算量：nx * 步数
+    i32 wide;                       // 是否用全部线程运行
+    i32 threads;                    // 实际使用的线程数
+    f64 wall;                       // 墙钟时间 (s)
+    CfdRunResult result;
+} SweepJob;
+
+/* 一个线程的双端队列 [head, tail)：自己从头部取，其他线程从尾部窃取 */
+typedef struct {
+    i32 *items;
+    i32 head, tail;
+    f64 load;                       // 队列中剩余作业的估计计算量
+#ifdef _OPENMP
+    omp_lock_t lock;
+#endif
+} SweepQueue;
+
+static char *trim(char *s)
+{
+    while (isspace((unsigned char)*s)) s++;
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return s;
+}
+
+static i32 hasKey(const SweepSection *sec, const char *key)
+{
+    for (i32 k = 0; k < sec->nkeys; k++)
+    {
+        if (strcmp(sec->keys[k], key) == 0) return 1;
+    }
+    return 0;
+}
+
+static i32 isProfileKey(const char *key)
+{
+    static const char *keys[] = {"name", "period", "dc", "amplitude", "harmonics", "harmonic"};
+    for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); k++)
+    {
+        if (strcmp(key, keys[k]) == 0) return 1;
+    }
+    return 0;
+}
+
+/* 设置作业的一项：活塞曲线的键交给 cfdEnsembleMemberSet，其余为运行参数 */
+static i32 sectionSet(SweepSection *sec, const char *key, const char *value)
+{
+    if (strcmp(key, "sweep") == 0 || strcmp(key, "ensemble") == 0 || strcmp(key, "restart") == 0 || strcmp(key, "live") == 0)
+    {
+        printf("[ERROR] %s cannot be set for a sweep job\n", key);
+        return -1;
+    }
+    if (isProfileKey(key))
+    {
+        if (strcmp(key, "name") == 0) sec->named = 1;
+        else sec->custom_profile = 1;
+        return cfdEnsembleMemberSet(&sec->member, key, value);
+    }
+    return cfdConfigSet(&sec->cfg, key, value);
+}
+
+/* "vary key = v1, v2, ..." */
+static i32 addVary(SweepSection *sec, const char *key, char *values)
+{
+    if (sec->nvary == CFD_SWEEP_VARY_MAX)
+    {
+        printf("[ERROR] At most %d vary lines per job\n", CFD_SWEEP_VARY_MAX);
+        return -1;
+    }
+    if (key[0] == '\0' || strlen(key) >= sizeof(sec->vary[0].key) || strcmp(key, "name") == 0)
+    {
+        printf("[ERROR] Invalid vary key '%s'\n", key);
+        return -1;
+    }
+    SweepVary *v = &sec->vary[sec->nvary];
+    strcpy(v->key, key);
+    v->count = 0;
+    for (char *item = values; item != NULL; )
+    {
+        char *comma = strchr(item, ',');
+        if (comma) *comma = '\0';
+        char *text = trim(item);
+        if (text[0] == '\0' || strlen(text) >= sizeof(v->values[0]) || v->count == CFD_SWEEP_VALUES_MAX)
+        {
+            printf("[ERROR] vary %s: expected up to %d comma-separated values\n", key, CFD_SWEEP_VALUES_MAX);
+            return -1;
+        }
+        strcpy(v->values[v->count++], text);
+        item = comma ? comma + 1 : NULL;
+    }
+    sec->nvary++;
+    return 0;
+}
+
+/* 把一节按公共部分与本节的 vary 展开成作业，追加到 *jobs */
+static i32 expandSection(const SweepSection *common, const SweepSection *sec, SweepJob **jobs, i32 *count, i32 *unnamed)
+{
+    const SweepVary *vary[2 * CFD_SWEEP_VARY_MAX];
+    i32 nvary = 0;
+    for (i32 k = 0; k < common->nvary; k++)
+    {
+        if (sec == common || !hasKey(sec, common->vary[k].key)) vary[nvary++] = &common->vary[k];
+    }
+    if (sec != common)
+    {
+        for (i32 k = 0; k < sec->nvary; k++) vary[nvary++] = &sec->vary[k];
+    }
+    i64 combos = 1;
+    for (i32 k = 0; k < nvary; k++)
+    {
+        combos *= vary[k]->count;
+        if (combos > 100000)
+        {
+            printf("[ERROR] The sweep expands to more than 100000 jobs\n");
+            return -1;
+        }
+    }
+
+    SweepJob *grown = (SweepJob *)realloc(*jobs, sizeof(SweepJob) * (size_t)(*count + combos));
+    if (!grown)
+    {
+        printf("[ERROR] Memory allocation failed while expanding the sweep\n");
+        return -1;
+    }
+    *jobs = grown;
+    for (i64 c = 0; c < combos; c++)
+    {
+        SweepSection job = *sec;
+        i64 index = c;
+        for (i32 k = nvary - 1; k >= 0; k--)
+        {
+            const char *value = vary[k]->values[index % vary[k]->count];
+            index /= vary[k]->count;
+            if (sectionSet(&job, vary[k]->key, value) != 0)
+            {
+                printf("[ERROR] vary %s = %s: invalid value\n", vary[k]->key, value);
+                return -1;
+            }
+        }
+        SweepJob *out = &grown[*count];
+        memset(out, 0, sizeof(*out));
+        out->cfg = job.cfg;
+        out->member = job.member;
+        out->custom_profile = job.custom_profile;
+        if (!job.named)
+        {
+            snprintf(out->member.name, sizeof(out->member.name), "job_%03d", (*unnamed)++);
+        }
+        else if (combos > 1)
+        {
+            char base[CFD_ENSEMBLE_NAME_MAX];
+            strcpy(base, job.member.name);
+            snprintf(out->member.name, sizeof(out->member.name), "%.*s_%03lld",
+                     CFD_ENSEMBLE_NAME_MAX - 16, base, (long long)c);
+        }
+        (*count)++;
+    }
+    return 0;
+}
+
+static i32 loadJobs(const char *path, const CfdConfig *base, SweepJob **jobs, i32 *count)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL)
+    {
+        printf("[ERROR] Cannot open sweep file %s\n", path);
+        return -1;
+    }
+    SweepSection *common = (SweepSection *)calloc(1, sizeof(SweepSection));
+    SweepSection *sec = (SweepSection *)calloc(1, sizeof(SweepSection));
+    if (!common || !sec)
+    {
+        printf("[ERROR] Memory allocation failed while reading %s\n", path);
+        free(common);
+        free(sec);
+        fclose(in);
+        return -1;
+    }
+    common->cfg = *base;
+    common->cfg.sweep[0] = '\0';
+    pistonProfileDefault(&common->member.profile);
+
+    SweepSection *current = common;
+    SweepJob *list = NULL;
+    i32 n = 0, unnamed = 0, sections = 0;
+    char line[2048];
+    i32 lineno = 0;
+    i32 status = 0;
+    while (status == 0 && fgets(line, sizeof(line), in))
+    {
+        lineno++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *text = trim(line);
+        if (*text == '\0') continue;
+
+        if (strcmp(text, "[job]") == 0)
+        {
+            if (current == sec) status = expandSection(common, sec, &list, &n, &unnamed);
+            /* 新的一节继承公共部分的设置，公共部分的 vary 在展开时再合并 */
+            *sec = *common;
+            sec->nvary = 0;
+            sec->nkeys = 0;
+            current = sec;
+            sections++;
+            continue;
+        }
+        char *eq = strchr(text, '=');
+        if (eq == NULL)
+        {
+            printf("[ERROR] %s:%d: expected 'key = value'\n", path, lineno);
+            status = -1;
+            break;
+        }
+        *eq = '\0';
+        char *key = trim(text);
+        if (strncmp(key, "vary", 4) == 0 && isspace((unsigned char)key[4]))
+        {
+            status = addVary(current, trim(key + 4), eq + 1);
+        }
+        else
+        {
+            status = sectionSet(current, key, trim(eq + 1));
+            if (status == 0 && current == sec && !hasKey(sec, key) && sec->nkeys < CFD_SWEEP_VALUES_MAX
+                && strlen(key) < sizeof(sec->keys[0]))
+            {
+                strcpy(sec->keys[sec->nkeys++], key);
+            }
+        }
+        if (status != 0) printf("[ERROR] %s:%d: invalid entry\n", path, lineno);
+    }
+    fclose(in);
+    /* 没有 [job] 时公共部分本身就是一个作业 */
+    if (status == 0) status = expandSection(common, sections ? sec : common, &list, &n, &unnamed);
+    free(common);
+    free(sec);
+
+    for (i32 a = 0; status == 0 && a < n; a++)
+    {
+        for (i32 b = a + 1; b < n; b++)
+        {
+            if (strcmp(list[a].member.name, list[b].member.name) == 0)
+            {
+                printf("[ERROR] %s: duplicate job name '%s'\n", path, list[a].member.name);
+                status = -1;
+                break;
+            }
+        }
+    }
+    for (i32 j = 0; status == 0 && j < n; j++)
+    {
+        if (cfdConfigValidate(&list[j].cfg) != 0)
+        {
+            printf("[ERROR] %s: job '%s' has invalid parameters\n", path, list[j].member.name);
+            status = -1;
+        }
+    }
+    if (status != 0)
+    {
+        free(list);
+        return -1;
+    }
+    *jobs = list;
+    *count = n;
+    return 0;
+}
+
+/* 每个作业的输出写到 <output_dir>/<name>/，检查点与性能汇总也随之放进去 */
+static i32 jobConfig(SweepJob *job, const CfdConfig *cfg)
+{
+    CfdConfig *c = &job->cfg;
+    char dir[CFD_PATH_MAX];
+    i32 n = snprintf(dir, sizeof(dir), "%s/%s", c->output_dir, job->member.name);
+    if (n < 0 || n >= (i32)sizeof(dir))
+    {
+        printf("[ERROR] Output path for job '%s' is too long\n", job->member.name);
+        return -1;
+    }
+    if ((mkdir(c->output_dir, 0755) != 0 && errno != EEXIST) || (mkdir(dir, 0755) != 0 && errno != EEXIST))
+    {
+        printf("[ERROR] Cannot create %s\n", dir);
+        return -1;
+    }
+    strcpy(c->output_dir, dir);
+    c->perf_json[0] = '\0';
+    c->checkpoint[0] = '\0';
+    c->ensemble[0] = '\0';
+    c->live[0] = '\0';
+    /* 没有另行设置时，按进度输出的间隔检查流场，发散的算例尽早中止 */
+    if (c->nan_check == 0) c->nan_check = c->print_after_steps;
+
+    const f64 steps = c->t_end / c->dt;      // 自适应步长时以初始 dt 估计
+    job->cost = (f64)c->nx * steps;
+    job->wide = c->nx >= cfg->sweep_split_nx;
+    if (!job->wide)
+    {
+        /* 小算例各占一个线程：不输出进度，也不为每个作业另开写线程 */
+        c->quiet = 1;
+        c->output_queue = 0;
+    }
+    return 0;
+}
+
+static void runJob(SweepJob *job, CfdRunFn run, i32 threads, i32 *done, i32 total)
+{
+    f64 t0 = cfdWallTime();
+    job->threads = threads;
+    job->result.status = CFD_RUN_FAILED;
+    if (run(&job->cfg, job->custom_profile ? &job->member.profile : NULL, &job->result) != 0
+        && job->result.status == CFD_RUN_OK)
+    {
+        job->result.status = CFD_RUN_FAILED;
+    }
+    job->wall = cfdWallTime() - t0;
+    i32 finished;
+#ifdef _OPENMP
+#pragma omp atomic capture
+#endif
+    finished = ++*done;
+    static const char *what[] = {"finished", "failed", "aborted (unstable)"};
+    printf("[INFO] Sweep job %s %s after %.3f s on %d thread(s) (%d/%d)\n", job->member.name,
+           what[job->result.status], job->wall, threads, finished, total);
+}
+
+static i32 popJob(SweepQueue *q, const SweepJob *jobs, i32 back)
+{
+    i32 j = -1;
+#ifdef _OPENMP
+    omp_set_lock(&q->lock);
+#endif
+    if (q->head < q->tail)
+    {
+        j = back ? q->items[--q->tail] : q->items[q->head++];
+        q->load -= jobs[j].cost;
+    }
+#ifdef _OPENMP
+    omp_unset_lock(&q->lock);
+#endif
+    return j;
+}
+
+static f64 queueLoad(SweepQueue *q)
+{
+#ifdef _OPENMP
+    omp_set_lock(&q->lock);
+#endif
+    f64 load = q->head < q->tail ? q->load : 0.0;
+#ifdef _OPENMP
+    omp_unset_lock(&q->lock);
+#endif
+    return load;
+}
+
+/* 估计计算量从大到小 */
+static const SweepJob *sort_jobs;
+static int byCost(const void *a, const void *b)
+{
+    f64 ca = sort_jobs[*(const i32 *)a].cost, cb = sort_jobs[*(const i32 *)b].cost;
+    return ca < cb ? 1 : ca > cb ? -1 : 0;
+}
+
+/* 小算例：按计算量贪心分配到各线程的队列，运行中空闲的线程从别的队列尾部窃取 */
+static i32 runSmall(SweepJob *jobs, i32 count, CfdRunFn run, i32 workers, i32 *done)
+{
+    i32 *order = (i32 *)malloc(sizeof(i32) * (size_t)(count + 1));
+    SweepQueue *queues = (SweepQueue *)calloc((size_t)workers, sizeof(SweepQueue));
+    i32 *items = (i32 *)malloc(sizeof(i32) * (size_t)workers * (size_t)(count + 1));
+    if (!order || !queues || !items)
+    {
+        printf("[ERROR] Memory allocation failed for the sweep scheduler\n");
+        free(order);
+        free(queues);
+        free(items);
+        return -1;
+    }
+    i32 small = 0;
+    for (i32 j = 0; j < count; j++)
+    {
+        if (!jobs[j].wide) order[small++] = j;
+    }
+    sort_jobs = jobs;
+    qsort(order, (size_t)small, sizeof(i32), byCost);
+    for (i32 w = 0; w < workers; w++)
+    {
+        queues[w].items = items + (size_t)w * (size_t)(count + 1);
+#ifdef _OPENMP
+        omp_init_lock(&queues[w].lock);
+#endif
+    }
+    for (i32 k = 0; k < small; k++)
+    {
+        i32 w = 0;
+        for (i32 v = 1; v < workers; v++)
+        {
+            if (queues[v].load < queues[w].load) w = v;
+        }
+        queues[w].items[queues[w].tail++] = order[k];
+        queues[w].load += jobs[order[k]].cost;
+    }
+
+#ifdef _OPENMP
+    /* 每个作业内部的核不再嵌套并行 */
+    i32 levels = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+#pragma omp parallel num_threads(workers)
+#endif
+    {
+#ifdef _OPENMP
+        const i32 me = omp_get_thread_num();
+#else
+        const i32 me = 0;
+#endif
+        for (;;)
+        {
+            i32 j = popJob(&queues[me], jobs, 0);
+            if (j < 0)
+            {
+                i32 victim = -1;
+                f64 most = 0.0;
+                for (i32 v = 0; v < workers; v++)
+                {
+                    f64 load = v == me ? 0.0 : queueLoad(&queues[v]);
+                    if (load > most)
+                    {
+                        most = load;
+                        victim = v;
+                    }
+                }
+                if (victim < 0) break;
+                j = popJob(&queues[victim], jobs, 1);
+                if (j < 0) continue;
+            }
+            runJob(&jobs[j], run, 1, done, count);
+        }
+    }
+#ifdef _OPENMP
+    omp_set_max_active_levels(levels);
+    for (i32 w = 0; w < workers; w++) omp_destroy_lock(&queues[w].lock);
+#endif
+    free(order);
+    free(queues);
+    free(items);
+    return 0;
+}
+
+static const char *statusName(i32 status)
+{
+    return status == CFD_RUN_OK ? "ok" : status == CFD_RUN_UNSTABLE ? "unstable" : "failed";
+}
+
+static void writeSummary(const CfdConfig *cfg, const SweepJob *jobs, i32 count, f64 wall)
+{
+    printf("[INFO] Sweep summary: %d jobs in %.3f s wall\n", count, wall);
+    printf("  %-24s %10s %11s %11s %4s %10s %12s %12s  %s\n",
+           "job", "nx", "dx", "dt", "thr", "wall (s)", "steps", "t (s)", "status");
+    for (i32 j = 0; j < count; j++)
+    {
+        const SweepJob *job = &jobs[j];
+        printf("  %-24s %10d %11.4e %11.4e %4d %10.3f %12lld %12.6f  %s\n", job->member.name, job->cfg.nx,
+               job->cfg.dx, job->cfg.dt, job->threads, job->wall, job->result.steps, job->result.t,
+               statusName(job->result.status));
+    }
+
+    char path[CFD_PATH_MAX + 64];
+    snprintf(path, sizeof(path), "%s/sweep_summary.csv", cfg->output_dir);
+    FILE *csv = fopen(path, "w");
+    if (csv == NULL)
+    {
+        printf("[WARN] Cannot open %s for writing; the summary is only printed.\n", path);
+        return;
+    }
+    fprintf(csv, "job,nx,dx,dt,t_end,period,amplitude,threads,wall_s,steps,t,mpoints_per_s,status\n");
+    for (i32 j = 0; j < count; j++)
+    {
+        const SweepJob *job = &jobs[j];
+        const f64 rate = job->wall > 0.0 ? (f64)job->cfg.nx * job->result.steps / job->wall * 1e-6 : 0.0;
+        fprintf(csv, "%s,%d,%.17g,%.17g,%.17g,%.17g,%.17g,%d,%.6f,%lld,%.17g,%.3f,%s\n", job->member.name,
+                job->cfg.nx, job->cfg.dx, job->cfg.dt, job->cfg.t_end, job->member.profile.period,
+                job->member.profile.amplitude, job->threads, job->wall, job->result.steps, job->result.t, rate,
+                statusName(job->result.status));
+    }
+    fclose(csv);
+    printf("[INFO] Wrote the sweep summary to %s\n", path);
+}
+
+i32 cfdSweepRun(const CfdConfig *cfg, CfdRunFn run)
+{
+    SweepJob *jobs = NULL;
+    i32 count = 0;
+    if (cfg->live[0] != '\0')
+    {
+        printf("[WARN] Live publishing is not supported for sweeps; ignoring live.\n");
+    }
+    if (loadJobs(cfg->sweep, cfg, &jobs, &count) != 0) return -1;
+    for (i32 j = 0; j < count; j++)
+    {
+        if (jobConfig(&jobs[j], cfg) != 0)
+        {
+            free(jobs);
+            return -1;
+        }
+    }
+
+#ifdef _OPENMP
+    i32 workers = omp_get_max_threads();
+#else
+    i32 workers = 1;
+#endif
+    i32 wide = 0;
+    for (i32 j = 0; j < count; j++) wide += jobs[j].wide;
+    printf("[INFO] Sweep: %d jobs from %s; %d with nx >= %d use all %d threads, %d run one per thread\n",
+           count, cfg->sweep, wide, cfg->sweep_split_nx, workers, count - wide);
+
+    f64 start = cfdWallTime();
+    i32 done = 0;
+    /* 大算例先运行，每个都用全部线程 */
+    for (i32 j = 0; j < count; j++)
+    {
+        if (jobs[j].wide) runJob(&jobs[j], run, workers, &done, count);
+    }
+    i32 status = runSmall(jobs, count, run, workers, &done);
+    f64 wall = cfdWallTime() - start;
+
+    writeSummary(cfg, jobs, count, wall);
+    for (i32 j = 0; j < count; j++)
+    {
+        if (jobs[j].result.status == CFD_RUN_FAILED) status = -1;
+    }
+    free(jobs);
+    return status;
+}
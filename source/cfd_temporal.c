@@ -0,0 +1,223 @@
+/*
+    source/cfd_temporal.c
+    时间分块：tile 的划分、私有缓冲内的多步推进与写回
+*/
+#include "cfd_temporal.h"
+#include "cfd_simd.h"
+#include "cfd_stencil.h"
+#include "cfd_report.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* 每核 L2 容量（字节），查不到时返回 CFD_TEMPORAL_L2_DEFAULT */
+static size_t l2Bytes(void)
+{
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    long bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (bytes > 0) return (size_t)bytes;
+#endif
+    return CFD_TEMPORAL_L2_DEFAULT;
+}
+
+CfdTemporal *cfdTemporalCreate(const CfdSolver *s, i32 depth, i32 tile)
+{
+    if (depth < 1) depth = 1;
+    if (tile <= 0)
+    {
+        /* 一个 tile 的全部私有缓冲占 L2 的一半，另一半留给写回的 *_next 与其余数据 */
+        i64 width = (i64)(l2Bytes() / 2 / (CFD_TEMPORAL_ARRAYS * sizeof(f64)));
+        tile = (i32)(width - 2 * depth);
+        /* 重复计算的比例约为 depth / tile，tile 太窄时退回 8 倍 depth */
+        if (tile < 8 * depth) tile = 8 * depth;
+    }
+    if (tile > s->nx) tile = s->nx;
+
+    CfdTemporal *tb = (CfdTemporal *)calloc(1, sizeof(CfdTemporal));
+    if (!tb)
+    {
+        printf("[ERROR] Memory allocation failed for temporal blocking\n");
+        return NULL;
+    }
+    tb->depth = depth;
+    tb->tile = tile;
+    tb->width = tile + 2 * depth;
+#ifdef _OPENMP
+    tb->threads = omp_get_max_threads();
+#else
+    tb->threads = 1;
+#endif
+    tb->scratch = (f64 *)malloc(sizeof(f64) * CFD_TEMPORAL_ARRAYS * (size_t)tb->width * (size_t)tb->threads);
+    tb->acc = (f64 *)malloc(sizeof(f64) * (size_t)depth);
+    if (s->derived_pressure) tb->rho_lag = (f64 *)malloc(sizeof(f64) * (size_t)s->nx);
+    if (!tb->scratch || !tb->acc || (s->derived_pressure && !tb->rho_lag))
+    {
+        printf("[ERROR] Memory allocation failed for temporal blocking\n");
+        cfdTemporalDestroy(tb);
+        return NULL;
+    }
+    printf("[INFO] Temporal blocking: %d steps per pass, tiles of %d points (%.0f KiB of scratch each)\n",
+           depth, tile, CFD_TEMPORAL_ARRAYS * sizeof(f64) * (f64)tb->width / 1024.0);
+    return tb;
+}
+
+void cfdTemporalDestroy(CfdTemporal *tb)
+{
+    if (!tb) return;
+    free(tb->scratch);
+    free(tb->acc);
+    free(tb->rho_lag);
+    free(tb);
+}
+
+/* 右边界在当前步使用的压力：存储压力时与 updatePressure 相同，导出压力时经状态方程 */
+static inline f64 borderPressure(const CfdSolver *s, f64 rho)
+{
+    return s->derived_pressure ? cfdEosPressure(&s->eos, rho) : R / MU_STAR * rho * T_INIT;
+}
+
+/*
+    把 tile [a, b) 推进 steps 步。private 缓冲载入 [gl, gr) = [a - steps, b + steps) 与网格求交，
+    第 k 步只更新仍然有效的 [lo, hi)；p_c/p_m 为右边界两点在第一步时的压力。
+*/
+static void tileAdvance(const CfdTemporal *tb, const CfdSolver *s, f64 *scratch, i32 a, i32 b, i32 steps,
+                        f64 p_c, f64 p_m)
+{
+    const i32 nx = s->nx;
+    const i32 gl = a - steps > 0 ? a - steps : 0;
+    const i32 gr = b + steps < nx ? b + steps : nx;
+    const i32 n = gr - gl;
+    const i32 left = gl == 0, right = gr == nx;
+    const i32 w = tb->width;
+    f64 *prev = scratch, *cur = scratch + w, *next = scratch + 2 * w;
+    f64 *vcur = scratch + 3 * w, *vnext = scratch + 4 * w;
+    memcpy(cur, s->rho + gl, sizeof(f64) * (size_t)n);
+    memcpy(vcur, s->vel + gl, sizeof(f64) * (size_t)n);
+
+    /* 内部点核只读网格参数与四个数组指针，用一个指向私有缓冲的视图复用各个 SIMD 实现 */
+    CfdSolver view;
+    memset(&view, 0, sizeof(view));
+    view.dx = s->dx;
+    view.dt = s->dt;
+    view.half_dt2 = s->half_dt2;
+    for (i32 k = 0; k < steps; k++)
+    {
+        const f64 acc = tb->acc[k];
+        const i32 lo = left ? 1 : k + 1;
+        const i32 hi = right ? n - 1 : n - k - 1;
+        if (right)
+        {
+            const i32 c = n - 1;
+            vnext[c] = borderVelRight(cur[c], vcur[c - 1], vcur[c], p_c - p_m, s->dx, s->dt, acc);
+            next[c] = borderRhoRight(cur[c - 1], cur[c], vcur[c - 1], vcur[c], s->dx, s->dt);
+            /* 下一步的压力由这一步的密度给出 */
+            p_c = borderPressure(s, cur[c]);
+            p_m = borderPressure(s, cur[c - 1]);
+        }
+        if (left)
+        {
+            vnext[0] = 0.0;
+            next[0] = borderRhoLeft(cur[0], vcur[0], vcur[1], s->dx, s->dt);
+        }
+        view.rho = cur;
+        view.vel = vcur;
+        view.rho_next = next;
+        view.vel_next = vnext;
+        if (lo < hi) cfdSimdInterior(s->simd, &view, acc, lo, hi, NULL);
+
+        f64 *tmp = prev;
+        prev = cur;
+        cur = next;
+        next = tmp;
+        tmp = vcur;
+        vcur = vnext;
+        vnext = tmp;
+    }
+
+    /* 写回 tile 自己的点：cur 为最后一步的结果，prev 为它的上一步 */
+    const i32 off = a - gl, len = b - a;
+    memcpy(s->rho_next + a, cur + off, sizeof(f64) * (size_t)len);
+    memcpy(s->vel_next + a, vcur + off, sizeof(f64) * (size_t)len);
+    if (s->derived_pressure)
+    {
+        memcpy(tb->rho_lag + a, prev + off, sizeof(f64) * (size_t)len);
+    }
+    else
+    {
+        f64 *pres = s->pres_next + a;
+        for (i32 i = 0; i < len; i++) pres[i] = R / MU_STAR * prev[off + i] * T_INIT;
+    }
+}
+
+/* 所有 tile 推进 steps 步（steps <= depth），然后交换缓冲区并推进时间与活塞加速度 */
+static void blockAdvance(CfdTemporal *tb, CfdSolver *s, i32 steps)
+{
+    CfdTimers *tm = &s->timers;
+    const i32 nx = s->nx;
+    f64 t0 = cfdWallTime();
+    /* 时间与活塞加速度与逐步推进一样逐步累加，先记下每一步用到的加速度 */
+    for (i32 k = 0; k < steps; k++)
+    {
+        tb->acc[k] = s->pa.acc;
+        s->t += s->dt;
+        s->step++;
+        pistonAccelAdvance(&s->pa);
+    }
+    t0 = cfdTimersAdd(tm, CFD_PHASE_PISTON, t0, 0.0);
+
+    const f64 p_c = s->derived_pressure ? cfdEosPressure(&s->eos, s->rho_next[nx - 1]) : s->pres[nx - 1];
+    const f64 p_m = s->derived_pressure ? cfdEosPressure(&s->eos, s->rho_next[nx - 2]) : s->pres[nx - 2];
+    const i32 tiles = (nx + tb->tile - 1) / tb->tile;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE)
+#endif
+    for (i32 j = 0; j < tiles; j++)
+    {
+#ifdef _OPENMP
+        const i32 tid = omp_get_thread_num();
+#else
+        const i32 tid = 0;
+#endif
+        const i32 a = j * tb->tile;
+        const i32 b = a + tb->tile < nx ? a + tb->tile : nx;
+        tileAdvance(tb, s, tb->scratch + (size_t)tid * CFD_TEMPORAL_ARRAYS * tb->width, a, b, steps, p_c, p_m);
+    }
+
+    /* 读写各一遍 rho/vel，再写一遍压力（或上一步的密度） */
+    t0 = cfdTimersAdd(tm, CFD_PHASE_TEMPORAL, t0, CFD_TEMPORAL_ARRAYS * sizeof(f64) * (f64)nx);
+    swapFlowField(s);
+    if (s->derived_pressure)
+    {
+        /* 交换后 rho_next 是分块开始时的密度，换成最后一步的上一步 */
+        f64 *tmp = s->rho_next;
+        s->rho_next = tb->rho_lag;
+        tb->rho_lag = tmp;
+    }
+    s->synced = 0;
+    cfdTimersAdd(tm, CFD_PHASE_SWAP, t0, 0.0);
+}
+
+i64 cfdTemporalAdvance(CfdTemporal *tb, CfdSolver *s, i64 nsteps, f64 t_stop)
+{
+    /* 先按逐步推进的时间累加确定这次要走的步数 */
+    i64 total = 0;
+    f64 t = s->t;
+    while (total < nsteps)
+    {
+        t += s->dt;
+        total++;
+        if (t > t_stop) break;
+    }
+    i64 done = 0;
+    while (done < total)
+    {
+        i32 steps = total - done < tb->depth ? (i32)(total - done) : tb->depth;
+        blockAdvance(tb, s, steps);
+        done += steps;
+    }
+    return done;
+}
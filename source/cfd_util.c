@@ -1,5 +1,11 @@
 #include "cfd_util.h"
 #include "cfd_differentials.h"
+#include "cfd_stencil.h"
+#include "cfd_simd.h"
+#include "cfd_mixed.h"
+#include "cfd_offload.h"
+#include "cfd_stepper.h"
+#include "cfd_active.h"
 #include "constants.h"
 #include <string.h>
 #include <stdio.h>
@@ -9,170 +15,1204 @@
 #include <omp.h>
 #endif
 
-/* 全局数组定义（在头文件中用 extern 声明） */
-f64 vel[NX];
-f64 pres[NX];
-f64 rho[NX];
-/* Fourier series coefficients for piston acceleration: rows are (a_n, b_n) */
-f64 fourierSeries[50][2] = {
-    {0.5513288954, 0.3183098862},
-    {0.5513288954, 0.9549296586},
-    {-0.0000000000, 0.4244131816},
-    {-0.2756644477, 0.4774648293},
-    {-0.1102657791, 0.0636619772},
-    {-0.0000000000, 0.0000000000},
-    {0.0787612708, 0.0454728409},
-    {0.1378322239, 0.2387324146},
-    {-0.0000000000, 0.1414710605},
-    {-0.1102657791, 0.1909859317},
-    {-0.0501208087, 0.0289372624},
-    {-0.0000000000, 0.0000000000},
-    {0.0424099150, 0.0244853759},
-    {0.0787612708, 0.1364185227},
-    {-0.0000000000, 0.0848826363},
-    {-0.0689161119, 0.1193662073},
-    {-0.0324311115, 0.0187241110},
-    {-0.0000000000, 0.0000000000},
-    {0.0290173103, 0.0167531519},
-    {0.0551328895, 0.0954929659},
-    {0.0000000000, 0.0606304545},
-    {-0.0501208087, 0.0868117871},
-    {-0.0239708215, 0.0138395603},
-    {-0.0000000000, 0.0000000000},
-    {0.0220531558, 0.0127323954},
-    {0.0424099150, 0.0734561276},
-    {-0.0000000000, 0.0471570202},
-    {-0.0393806354, 0.0682092613},
-    {-0.0190113412, 0.0109762030},
-    {-0.0000000000, 0.0000000000},
-    {0.0177848031, 0.0102680608},
-    {0.0344580560, 0.0596831037},
-    {-0.0000000000, 0.0385830165},
-    {-0.0324311115, 0.0561723329},
-    {-0.0157522542, 0.0090945682},
-    {-0.0000000000, 0.0000000000},
-    {0.0149007810, 0.0086029699},
-    {0.0290173103, 0.0502594557},
-    {-0.0000000000, 0.0326471678},
-    {-0.0275664448, 0.0477464829},
-    {-0.0134470462, 0.0077636558},
-    {-0.0000000000, 0.0000000000},
-    {0.0128216022, 0.0074025555},
-    {0.0250604043, 0.0434058936},
-    {-0.0000000000, 0.0282942121},
-    {-0.0239708215, 0.0415186808},
-    {-0.0117304020, 0.0067725508},
-    {-0.0000000000, 0.0000000000},
-    {0.0112516101, 0.0064961201},
-    {0.0220531558, 0.0381971863},
-};
+/* Fourier series coefficients for piston acceleration: rows are (a_n, b_n)
+   （写成初始化宏，fourierSeries 与题设曲线 pistonProfileReadme 共用） */
+#define PISTON_FOURIER_COEF { \
+    {0.5513288954, 0.3183098862}, \
+    {0.5513288954, 0.9549296586}, \
+    {-0.0000000000, 0.4244131816}, \
+    {-0.2756644477, 0.4774648293}, \
+    {-0.1102657791, 0.0636619772}, \
+    {-0.0000000000, 0.0000000000}, \
+    {0.0787612708, 0.0454728409}, \
+    {0.1378322239, 0.2387324146}, \
+    {-0.0000000000, 0.1414710605}, \
+    {-0.1102657791, 0.1909859317}, \
+    {-0.0501208087, 0.0289372624}, \
+    {-0.0000000000, 0.0000000000}, \
+    {0.0424099150, 0.0244853759}, \
+    {0.0787612708, 0.1364185227}, \
+    {-0.0000000000, 0.0848826363}, \
+    {-0.0689161119, 0.1193662073}, \
+    {-0.0324311115, 0.0187241110}, \
+    {-0.0000000000, 0.0000000000}, \
+    {0.0290173103, 0.0167531519}, \
+    {0.0551328895, 0.0954929659}, \
+    {0.0000000000, 0.0606304545}, \
+    {-0.0501208087, 0.0868117871}, \
+    {-0.0239708215, 0.0138395603}, \
+    {-0.0000000000, 0.0000000000}, \
+    {0.0220531558, 0.0127323954}, \
+    {0.0424099150, 0.0734561276}, \
+    {-0.0000000000, 0.0471570202}, \
+    {-0.0393806354, 0.0682092613}, \
+    {-0.0190113412, 0.0109762030}, \
+    {-0.0000000000, 0.0000000000}, \
+    {0.0177848031, 0.0102680608}, \
+    {0.0344580560, 0.0596831037}, \
+    {-0.0000000000, 0.0385830165}, \
+    {-0.0324311115, 0.0561723329}, \
+    {-0.0157522542, 0.0090945682}, \
+    {-0.0000000000, 0.0000000000}, \
+    {0.0149007810, 0.0086029699}, \
+    {0.0290173103, 0.0502594557}, \
+    {-0.0000000000, 0.0326471678}, \
+    {-0.0275664448, 0.0477464829}, \
+    {-0.0134470462, 0.0077636558}, \
+    {-0.0000000000, 0.0000000000}, \
+    {0.0128216022, 0.0074025555}, \
+    {0.0250604043, 0.0434058936}, \
+    {-0.0000000000, 0.0282942121}, \
+    {-0.0239708215, 0.0415186808}, \
+    {-0.0117304020, 0.0067725508}, \
+    {-0.0000000000, 0.0000000000}, \
+    {0.0112516101, 0.0064961201}, \
+    {0.0220531558, 0.0381971863}, \
+}
+const f64 fourierSeries[PISTON_HARMONICS][2] = PISTON_FOURIER_COEF;
 /* DC term a0/2 for the piecewise acceleration (period T=60s):
    integral over a(t) is 3*10 + 0*20 + 1*10 + 0*20 = 40
    a0 = (2/T)*Integral = (2/60)*40 = 4/3, hence a0/2 = 2/3
 */
-static const f64 PISTON_FOURIER_A0_HALF = 2.0/3.0;  /* ~0.6666666667 */
-static const f64 PISTON_PERIOD = 60.0;
+#define PISTON_FOURIER_A0_HALF (2.0/3.0)  /* ~0.6666666667 */
+#define PISTON_PERIOD 60.0
 
-f64 getPistonAcceleration(f64 time)
+/* 题设的加速度曲线，pistonAccelInit 传入 NULL 时使用；只读，多个线程同时创建求解器也无需同步 */
+static const PistonProfile pistonProfileReadme = {
+    PISTON_PERIOD, PISTON_FOURIER_A0_HALF, 1.0, PISTON_FOURIER_COEF,
+};
+
+/* 题设周期下各谐波的角频率 w_n = 2πn/T，编译期求值；其他周期在 pistonAccelInit 中算一次 */
+#define PISTON_W(n) (2.0 * PI * (n) / PISTON_PERIOD)
+#define PISTON_W10(n) PISTON_W(n + 1), PISTON_W(n + 2), PISTON_W(n + 3), PISTON_W(n + 4), PISTON_W(n + 5), \
+                      PISTON_W(n + 6), PISTON_W(n + 7), PISTON_W(n + 8), PISTON_W(n + 9), PISTON_W(n + 10)
+static const f64 pistonOmegaDefault[PISTON_HARMONICS] = {
+    PISTON_W10(0), PISTON_W10(10), PISTON_W10(20), PISTON_W10(30), PISTON_W10(40),
+};
+
+/*
+    题设的分段常数加速度：各段的终点（占周期的比例）与加速度 (m/s^2)。
+    周期为 60 s 时即 10/30/40/60 s 处的间断。
+*/
+static const f64 pistonPiecewiseEnd[4] = {10.0 / 60.0, 30.0 / 60.0, 40.0 / 60.0, 1.0};
+static const f64 pistonPiecewiseAcc[4] = {3.0, 0.0, 1.0, 0.0};
+
+void pistonProfileDefault(PistonProfile *p)
+{
+    *p = pistonProfileReadme;
+}
+
+/* 曲线各谐波的角频率：题设周期直接用编译期的表，否则算到 scratch 中 */
+static const f64 *profileOmega(const PistonProfile *p, f64 *scratch)
+{
+    if (p->period == PISTON_PERIOD) return pistonOmegaDefault;
+    for (int k = 0; k < PISTON_HARMONICS; ++k)
+    {
+        scratch[k] = 2.0 * PI * (k + 1) / p->period;
+    }
+    return scratch;
+}
+
+/* 把时刻约化到 [0, T) 内（周期延拓） */
+static f64 reducePeriod(const PistonProfile *p, f64 time)
 {
-    /* Reduce time to [0, T) for periodic extension */
-    f64 t = fmod(time, PISTON_PERIOD);
-    if (t < 0) t += PISTON_PERIOD;
+    f64 t = fmod(time, p->period);
+    if (t < 0) t += p->period;
+    return t;
+}
 
-    f64 acc = PISTON_FOURIER_A0_HALF;
+static f64 profileEvalOmega(const PistonProfile *p, const f64 *w, f64 time)
+{
+    f64 t = reducePeriod(p, time);
+    f64 acc = p->dc;
     /* Sum over provided harmonics */
-    for (int k = 0; k < 50; ++k)
+    for (int k = 0; k < PISTON_HARMONICS; ++k)
+    {
+        f64 an = p->coef[k][0];
+        f64 bn = p->coef[k][1];
+        acc += an * cos(w[k] * t) + bn * sin(w[k] * t);
+    }
+    return p->amplitude * acc;
+}
+
+f64 pistonProfileEval(const PistonProfile *p, f64 time)
+{
+    f64 scratch[PISTON_HARMONICS];
+    return profileEvalOmega(p, profileOmega(p, scratch), time);
+}
+
+f64 pistonPiecewiseEval(const PistonProfile *p, f64 time)
+{
+    /* t <= 10 s 时为 3 m/s^2，即各段含右端点 */
+    f64 u = reducePeriod(p, time) / p->period;
+    i32 k = 0;
+    while (k < 3 && u > pistonPiecewiseEnd[k]) k++;
+    return p->amplitude * pistonPiecewiseAcc[k];
+}
+
+/* c[k]、s[k] 为 cos(w_n t)、sin(w_n t) */
+static void kinematicsSum(const PistonProfile *p, const f64 *w, f64 time, const f64 *c, const f64 *s, f64 *vel, f64 *disp)
+{
+    f64 v = p->dc * time;
+    f64 x = 0.5 * p->dc * time * time;
+    for (int k = 0; k < PISTON_HARMONICS; ++k)
     {
-        int n = k + 1; /* harmonic index */
-        f64 an = fourierSeries[k][0];
-        f64 bn = fourierSeries[k][1];
-        f64 w = 2.0 * PI * n / PISTON_PERIOD;
-        acc += an * cos(w * t) + bn * sin(w * t);
+        f64 an = p->coef[k][0];
+        f64 bn = p->coef[k][1];
+        v += (an * s[k] + bn * (1.0 - c[k])) / w[k];
+        x += (an * (1.0 - c[k]) - bn * s[k]) / (w[k] * w[k]) + bn * time / w[k];
     }
-    return acc;
+    *vel = p->amplitude * v;
+    *disp = p->amplitude * x;
 }
 
-void initFlowField()
+void pistonProfileKinematics(const PistonProfile *p, f64 time, f64 *vel, f64 *disp)
 {
-    for (int i = 0; i < NX; i++)
+    /* 谐波项是周期的，三角函数用约化后的时刻；常数项与 b_n 的线性项用原始时刻 */
+    f64 t = reducePeriod(p, time);
+    f64 scratch[PISTON_HARMONICS];
+    const f64 *w = profileOmega(p, scratch);
+    f64 c[PISTON_HARMONICS], s[PISTON_HARMONICS];
+    for (int k = 0; k < PISTON_HARMONICS; ++k)
     {
-        vel[i] = 0;
-        pres[i] = P_INIT;
-        rho[i] = RHO_INIT;
+        c[k] = cos(w[k] * t);
+        s[k] = sin(w[k] * t);
     }
-    printf("[INFO] FlowField Initialized.\n");
+    kinematicsSum(p, w, time, c, s, vel, disp);
+}
+
+/* 分段常数曲线的精确积分：先累加整周期，再逐段积到周期内的时刻 */
+static void piecewiseKinematics(const PistonProfile *p, f64 time, f64 *vel, f64 *disp)
+{
+    const f64 T = p->period;
+    f64 v1 = 0.0, x1 = 0.0, start = 0.0;       /* 从静止出发一个周期后的速度与位移 */
+    for (i32 k = 0; k < 4; k++)
+    {
+        f64 h = (pistonPiecewiseEnd[k] - start) * T;
+        x1 += v1 * h + 0.5 * pistonPiecewiseAcc[k] * h * h;
+        v1 += pistonPiecewiseAcc[k] * h;
+        start = pistonPiecewiseEnd[k];
+    }
+    f64 n = floor(time / T);
+    f64 tau = time - n * T;
+    /* 第 j 个周期开始时速度为 j*v1，n 个整周期的位移为 n*x1 + v1*T*n(n-1)/2 */
+    f64 v = n * v1, x = n * x1 + v1 * T * 0.5 * n * (n - 1.0);
+    start = 0.0;
+    for (i32 k = 0; k < 4 && tau > start * T; k++)
+    {
+        f64 end = pistonPiecewiseEnd[k] * T;
+        f64 h = (tau < end ? tau : end) - start * T;
+        x += v * h + 0.5 * pistonPiecewiseAcc[k] * h * h;
+        v += pistonPiecewiseAcc[k] * h;
+        start = pistonPiecewiseEnd[k];
+    }
+    *vel = p->amplitude * v;
+    *disp = p->amplitude * x;
+}
+
+void pistonAccelKinematics(const PistonAccel *pa, f64 *vel, f64 *disp)
+{
+    if (pa->source == CFD_PISTON_PIECEWISE) piecewiseKinematics(pa->profile, pa->time, vel, disp);
+    else if (pa->source == CFD_PISTON_FOURIER && pa->use_recurrence)
+        kinematicsSum(pa->profile, pa->w, pa->time, pa->c, pa->s, vel, disp);
+    /* 查表是傅里叶级数的近似，运动量按级数精确积分 */
+    else pistonProfileKinematics(pa->profile, pa->time, vel, disp);
+}
+
+f64 getPistonAcceleration(f64 time)
+{
+    return pistonProfileEval(&pistonProfileReadme, time);
+}
+
+/* 查表：一个周期均匀采样 PISTON_TABLE_SIZE 段，段内线性插值 */
+static void tableBuild(PistonAccel *pa)
+{
+    const PistonProfile *p = pa->profile;
+    const f64 h = p->period / PISTON_TABLE_SIZE;
+    for (i32 j = 0; j < PISTON_TABLE_SIZE; j++)
+    {
+        pa->table[j] = profileEvalOmega(p, pa->w, j * h);
+    }
+    pa->table[PISTON_TABLE_SIZE] = pa->table[0];
+}
+
+static f64 tableEval(const PistonAccel *pa, f64 time)
+{
+    f64 u = reducePeriod(pa->profile, time) * (PISTON_TABLE_SIZE / pa->profile->period);
+    i32 j = (i32)u;
+    if (j >= PISTON_TABLE_SIZE) j = PISTON_TABLE_SIZE - 1;
+    f64 f = u - j;
+    return pa->table[j] + f * (pa->table[j + 1] - pa->table[j]);
+}
+
+f64 pistonAccelAt(const PistonAccel *pa, f64 time)
+{
+    switch (pa->source)
+    {
+    case CFD_PISTON_TABLE:      return tableEval(pa, time);
+    case CFD_PISTON_PIECEWISE:  return pistonPiecewiseEval(pa->profile, time);
+    default:                    return profileEvalOmega(pa->profile, pa->w, time);
+    }
+}
+
+/* 不使用递推时 pa->time 处的加速度 */
+static f64 accelEval(const PistonAccel *pa)
+{
+    return pistonAccelAt(pa, pa->time);
+}
+
+/* 用精确求和重新同步递推状态，消除累积的舍入误差 */
+static void pistonAccelSync(PistonAccel *pa)
+{
+    const PistonProfile *p = pa->profile;
+    f64 t = reducePeriod(p, pa->time);
+
+    f64 acc = p->dc;
+    for (int k = 0; k < PISTON_HARMONICS; ++k)
+    {
+        pa->c[k] = cos(pa->w[k] * t);
+        pa->s[k] = sin(pa->w[k] * t);
+        acc += p->coef[k][0] * pa->c[k] + p->coef[k][1] * pa->s[k];
+    }
+    pa->acc = p->amplitude * acc;
+    pa->since_sync = 0;
+}
+
+void pistonAccelInit(PistonAccel *pa, const PistonProfile *profile, f64 time, f64 dt, i32 source, i32 use_recurrence)
+{
+    pa->profile = profile ? profile : &pistonProfileReadme;
+    pa->time = time;
+    pa->source = source;
+    /* 递推只用于傅里叶级数，查表与分段曲线本身每步只需 O(1) */
+    pa->use_recurrence = source == CFD_PISTON_FOURIER && use_recurrence;
+    const f64 *w = profileOmega(pa->profile, pa->w);
+    if (w != pa->w) memcpy(pa->w, w, sizeof(pa->w));
+    if (source == CFD_PISTON_TABLE) tableBuild(pa);
+    pistonAccelSetDt(pa, dt);
+}
+
+void pistonAccelSetDt(PistonAccel *pa, f64 dt)
+{
+    pa->dt = dt;
+    if (!pa->use_recurrence)
+    {
+        pa->acc = accelEval(pa);
+        return;
+    }
+    for (int k = 0; k < PISTON_HARMONICS; ++k)
+    {
+        pa->cd[k] = cos(pa->w[k] * dt);
+        pa->sd[k] = sin(pa->w[k] * dt);
+    }
+    pistonAccelSync(pa);
+}
+
+f64 pistonAccelAdvance(PistonAccel *pa)
+{
+    pa->time += pa->dt;
+    if (!pa->use_recurrence)
+    {
+        pa->acc = accelEval(pa);
+        return pa->acc;
+    }
+    if (++pa->since_sync >= PISTON_RESYNC_STEPS)
+    {
+        pistonAccelSync(pa);
+        return pa->acc;
+    }
+    /* 每个谐波的相位前进 w*dt：(c, s) 旋转一个固定角度 */
+    const PistonProfile *p = pa->profile;
+    f64 acc = p->dc;
+    for (int k = 0; k < PISTON_HARMONICS; ++k)
+    {
+        f64 c = pa->c[k] * pa->cd[k] - pa->s[k] * pa->sd[k];
+        f64 s = pa->s[k] * pa->cd[k] + pa->c[k] * pa->sd[k];
+        pa->c[k] = c;
+        pa->s[k] = s;
+        acc += p->coef[k][0] * c + p->coef[k][1] * s;
+    }
+    pa->acc = p->amplitude * acc;
+    return pa->acc;
 }
 
-f64 rborderRho()
+CfdSolver *cfdSolverCreate(const CfdConfig *cfg)
 {
-    int i = NX - 1;
-    return (-rho[i] * (vel[i] - vel[i - 1]) / DX - vel[i] * (rho[i] - rho[i - 1]) / DX) * DT + rho[i];
+    CfdSolver *s = (CfdSolver *)calloc(1, sizeof(CfdSolver));
+    if (!s)
+    {
+        printf("[ERROR] Memory allocation failed while creating solver\n");
+        return NULL;
+    }
+    s->nx = cfg->nx;
+    s->dx = cfg->dx;
+    s->dt = cfg->dt;
+    s->half_dt2 = cfg->dt * cfg->dt / 2;
+    s->precision = cfg->precision;
+    s->derived_pressure = cfg->derived_pressure;
+    s->stepper = cfg->stepper;
+    cfdEosIsothermal(&s->eos, T_INIT);
+#ifdef CFD_REFERENCE_KERNEL
+    if (s->precision == CFD_PRECISION_MIXED)
+    {
+        printf("[WARN] Mixed precision is not available with the reference kernel; using double.\n");
+        s->precision = CFD_PRECISION_DOUBLE;
+    }
+#endif
+    if (cfg->grid_stretch > 0)
+    {
+        /* 拉伸网格只实现了 f64 存储上的 Taylor 格式（融合核与参考核） */
+        if (s->precision == CFD_PRECISION_MIXED)
+        {
+            printf("[WARN] The stretched grid needs float64 storage; using double.\n");
+            s->precision = CFD_PRECISION_DOUBLE;
+        }
+        if (s->stepper != CFD_STEPPER_TAYLOR)
+        {
+            printf("[WARN] The stretched grid only runs the taylor stepper; stepper %s is ignored.\n", cfdStepperName(s->stepper));
+            s->stepper = CFD_STEPPER_TAYLOR;
+        }
+    }
+    if (s->stepper != CFD_STEPPER_TAYLOR && s->precision == CFD_PRECISION_MIXED)
+    {
+        printf("[WARN] The %s stepper needs float64 storage; mixed precision uses taylor.\n", cfdStepperName(s->stepper));
+        s->stepper = CFD_STEPPER_TAYLOR;
+    }
+    i32 track = cfg->active_region;
+    if (track)
+    {
+        /* 均匀段的代表值用融合核推进，只实现了 f64 存储上的 Taylor 格式 */
+#ifdef CFD_REFERENCE_KERNEL
+        printf("[WARN] Active-region tracking uses the fused kernel; not available with the reference kernel.\n");
+        track = 0;
+#else
+        if (s->precision == CFD_PRECISION_MIXED)
+        {
+            printf("[WARN] Active-region tracking only applies to double precision; updating every cell.\n");
+            track = 0;
+        }
+        else if (s->stepper != CFD_STEPPER_TAYLOR)
+        {
+            printf("[WARN] Active-region tracking only applies to the taylor stepper; updating every cell.\n");
+            track = 0;
+        }
+#endif
+    }
+
+    size_t bytes = sizeof(f64) * (size_t)cfg->nx;
+    s->vel = (f64 *)malloc(bytes);
+    s->pres = (f64 *)malloc(bytes);
+    s->rho = (f64 *)malloc(bytes);
+    i32 failed = !s->vel || !s->pres || !s->rho;
+    if (s->precision == CFD_PRECISION_MIXED)
+    {
+        /* 混合精度只需要 f32 的双缓冲，f64 数组仅用于输出 */
+        failed = failed || cfdMixedAlloc(s) != 0;
+    }
+    else
+    {
+        s->vel_next = (f64 *)malloc(bytes);
+        s->rho_next = (f64 *)malloc(bytes);
+        if (!s->derived_pressure) s->pres_next = (f64 *)malloc(bytes);
+        failed = failed || !s->vel_next || !s->rho_next || (!s->derived_pressure && !s->pres_next);
+        failed = failed || cfdStepperAlloc(s) != 0;
+    }
+    if (cfg->grid_stretch > 0)
+    {
+        const f64 length = cfg->grid_length > 0 ? cfg->grid_length : (cfg->nx - 1) * cfg->dx;
+        s->grid = cfdGridCreate(cfg->nx, length, cfg->grid_stretch);
+        failed = failed || !s->grid;
+    }
+    if (failed)
+    {
+        printf("[ERROR] Memory allocation failed for NX=%d field arrays\n", cfg->nx);
+        cfdSolverDestroy(s);
+        return NULL;
+    }
+
+    s->simd = cfdSimdResolve(cfg->simd);
+    if (s->grid)
+    {
+        /* 拉伸网格的内部点系数逐点不同，走标量核；dx 取最小间距，自适应步长按它估计 */
+        s->simd = CFD_SIMD_SCALAR;
+        s->dx = s->grid->dx_min;
+        printf("[INFO] Stretched grid: beta=%g over %.4g m, spacing %.3e m at the piston to %.3e m at the open end\n",
+               s->grid->stretch, s->grid->length, s->grid->dx_min, s->grid->dx_max);
+        const f64 cfl = sqrt(K) * s->dt / s->dx;
+        if (cfg->cfl == 0 && cfl > 1.0)
+        {
+            printf("[WARN] dt=%.3e gives CFL %.2f at the piston; the taylor stepper is likely to diverge\n", s->dt, cfl);
+        }
+    }
+#ifndef CFD_REFERENCE_KERNEL
+    printf("[INFO] Interior kernel: %s\n", cfdSimdName(s->simd));
+#endif
+    if (s->stepper != CFD_STEPPER_TAYLOR)
+    {
+        printf("[INFO] Time integrator: %s (%d stage buffers)\n", cfdStepperName(s->stepper), cfdStepperStages(s->stepper));
+    }
+    if (s->derived_pressure)
+    {
+        printf("[INFO] Pressure derived on demand from the %s equation of state\n", s->eos.name);
+    }
+    if (s->precision == CFD_PRECISION_MIXED) cfdMixedInit(s);
+    else initFlowField(s);
+    if (track) cfdActiveStart(s);
+    s->watch.enabled = cfg->watchdog;
+    s->watch.limit = cfdStepperCflLimit(s->stepper) * WATCHDOG_CFL_MARGIN;
+    cfdTimersReset(&s->timers);
+    s->t = 0.0;
+    s->step = 0;
+    pistonProfileDefault(&s->profile);
+    pistonAccelInit(&s->pa, &s->profile, s->t, s->dt, cfg->piston_source, cfg->piston_recurrence);
+
+    if (s->precision == CFD_PRECISION_MIXED && cfg->precision_check)
+    {
+        /* 同样的算例以 f64 再跑一份，与混合精度解逐步比较 */
+        CfdConfig ref = *cfg;
+        ref.precision = CFD_PRECISION_DOUBLE;
+        ref.precision_check = 0;
+        ref.watchdog = 0;
+        ref.stepper = s->stepper;
+        s->shadow = cfdSolverCreate(&ref);
+        if (!s->shadow)
+        {
+            cfdSolverDestroy(s);
+            return NULL;
+        }
+    }
+    return s;
 }
 
-f64 rborderVel(f64 time)
+void cfdSolverDestroy(CfdSolver *s)
 {
-    int i = NX - 1;
-    f64 fx = -rho[i] * getPistonAcceleration(time);
-    return (
-        ((fx - ((pres[i] - pres[i - 1]) / DX)) / rho[i] - vel[i] * (vel[i] - vel[i - 1]) / DX) * DT + vel[i]);
+    if (!s) return;
+    cfdOffloadDetach(s);
+    free(s->active);
+    free(s->vel);
+    free(s->pres);
+    free(s->rho);
+    free(s->vel_next);
+    free(s->pres_next);
+    free(s->rho_next);
+    cfdStepperFree(s);
+    cfdGridDestroy(s->grid);
+    if (s->precision == CFD_PRECISION_MIXED) cfdMixedFree(s);
+    cfdSolverDestroy(s->shadow);
+    free(s);
 }
-f64 *updateRho(f64 time)
+
+/* 这一步的看门狗归约：没有开启时为 NULL，核里不做归约 */
+static inline CfdWatchSums *watchBegin(CfdSolver *s)
 {
-    f64 *new_rho = (f64 *)malloc(sizeof(f64) * NX);
-    if (!new_rho)
+    if (!s->watch.enabled) return NULL;
+    s->watch.sums.vmax = 0.0;
+    s->watch.sums.rmin = INFINITY;
+    s->watch.sums.bad = 0.0;
+    return &s->watch.sums;
+}
+
+/* 合并一段内部点的归约 */
+static inline void watchMerge(CfdWatchSums *w, f64 vmax, f64 rmin, f64 bad)
+{
+    if (vmax > w->vmax) w->vmax = vmax;
+    if (rmin < w->rmin) w->rmin = rmin;
+    w->bad += bad;
+}
+
+/* 两端边界点的新值（由 updateBorders 写出） */
+static inline void watchBorders(const CfdSolver *s, CfdWatchSums *w)
+{
+    const i32 nx = s->nx;
+    watchPoint(s->rho_next[0], s->vel_next[0], &w->vmax, &w->rmin, &w->bad);
+    watchPoint(s->rho_next[nx - 1], s->vel_next[nx - 1], &w->vmax, &w->rmin, &w->bad);
+}
+
+/* 用一步的归约判断是否中止；在 t 与 step 推进之后调用。已中止时不再更新，诊断信息始终描述中止的那一步 */
+static void watchCheck(CfdSolver *s, const CfdWatchSums *sums)
+{
+    CfdWatch *w = &s->watch;
+    if (w->tripped) return;
+    w->vmax = sums->vmax;
+    w->rmin = sums->rmin;
+    w->cfl = (sums->vmax + sqrt(K)) * s->dt / s->dx;
+    i32 reason = CFD_WATCH_OK;
+    if (!isfinite(sums->bad))     reason = CFD_WATCH_NONFINITE;
+    else if (!(sums->rmin > 0.0)) reason = CFD_WATCH_DENSITY;
+    else if (w->cfl > w->limit)   reason = CFD_WATCH_CFL;
+    if (reason == CFD_WATCH_OK) return;
+    w->tripped = reason;
+    w->trip_step = s->step;
+    w->trip_t = s->t;
+}
+
+void cfdSolverStep(CfdSolver *s)
+{
+    CfdTimers *tm = &s->timers;
+    const f64 nx = (f64)s->nx;
+    f64 t0 = cfdWallTime();
+    CfdWatchSums *watch = watchBegin(s);
+    i32 fused = watch != NULL;
+    if (s->shadow)
+    {
+        cfdSolverStep(s->shadow);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_SHADOW, t0, 0.0);
+    }
+    if (s->precision == CFD_PRECISION_MIXED)
+    {
+        cfdMixedStep(s);
+        t0 = cfdWallTime();
+    }
+    else if (s->device)
+    {
+        /* 只计入提交核的时间，核本身在设备上异步执行 */
+        cfdOffloadStep(s);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_FUSED, t0, (s->derived_pressure ? 4 : 6) * sizeof(f64) * nx);
+        fused = 0;
+    }
+    else if (s->stepper != CFD_STEPPER_TAYLOR)
+    {
+        /* 多级格式自己处理两端边界，压力与交换沿用 Taylor 的约定 */
+        cfdStepperStep(s);
+        t0 = cfdWallTime();
+        fused = 0;
+        if (!s->derived_pressure)
+        {
+            updatePressure(s);
+            t0 = cfdTimersAdd(tm, CFD_PHASE_PRESSURE, t0, 2 * sizeof(f64) * nx);
+        }
+        swapFlowField(s);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_SWAP, t0, 0.0);
+    }
+    else if (s->active)
     {
-        printf("[ERROR] Memory allocation failed during rho update at %.8f sec", time);
-        exit(-1);
+        /* 只逐点更新均匀段以外的部分（见 cfd_active.h） */
+        const i32 updated = cfdActiveStep(s, s->pa.acc);
+        if (watch) watchBorders(s, watch);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_FUSED, t0, (s->derived_pressure ? 4 : 6) * sizeof(f64) * (f64)updated);
+        swapFlowField(s);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_SWAP, t0, 0.0);
     }
+    else
+    {
+        /* 边界先于内部点：导出压力时边界要读 rho_next 中上一步的密度 */
+        updateBorders(s, s->pa.acc);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_BORDER, t0, 0.0);
+#ifdef CFD_REFERENCE_KERNEL
+        /* 参考实现的三个核保持原样，不做归约 */
+        updateVelocity(s, s->pa.acc);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_VELOCITY, t0, 3 * sizeof(f64) * nx);
+        updateRho(s, s->pa.acc);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_RHO, t0, 3 * sizeof(f64) * nx);
+        fused = 0;
+#else
+        updateFlowField(s, s->pa.acc);
+        if (watch) watchBorders(s, watch);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_FUSED, t0, 4 * sizeof(f64) * nx);
+#endif
+        if (!s->derived_pressure)
+        {
+            updatePressure(s);
+            t0 = cfdTimersAdd(tm, CFD_PHASE_PRESSURE, t0, 2 * sizeof(f64) * nx);
+        }
+        swapFlowField(s);
+        t0 = cfdTimersAdd(tm, CFD_PHASE_SWAP, t0, 0.0);
+    }
+
+    s->t += s->dt;
+    s->step++;
+    s->synced = 0;
+    s->watch.fused = fused;
+    if (fused) watchCheck(s, watch);
+    pistonAccelAdvance(&s->pa);
+    cfdTimersAdd(tm, CFD_PHASE_PISTON, t0, 0.0);
+}
+
+void cfdSolverSetProfile(CfdSolver *s, const PistonProfile *profile)
+{
+    s->profile = *profile;
+    pistonAccelInit(&s->pa, &s->profile, s->t, s->dt, s->pa.source, s->pa.use_recurrence);
+    if (s->shadow) cfdSolverSetProfile(s->shadow, profile);
+}
+
+void cfdSolverSync(CfdSolver *s)
+{
+    if (s->synced) return;
+    if (s->device) cfdOffloadDownload(s);
+    if (s->precision == CFD_PRECISION_MIXED) cfdMixedExpand(s);
+    cfdActiveFill(s);
+    if (s->derived_pressure)
+    {
+        const CfdEos *eos = &s->eos;
+        if (s->precision == CFD_PRECISION_MIXED)
+        {
+            const f32 *prev = s->drho_next;
+            const i32 nx = s->nx;
 #ifdef _OPENMP
 #pragma omp parallel for schedule(static)
 #endif
-    for (int i = 1; i < NX - 1; i++)
+            for (int i = 0; i < nx; i++) s->pres[i] = cfdEosPressure(eos, RHO_INIT + (f64)prev[i]);
+        }
+        else
+        {
+            cfdEosFill(eos, s->rho_next, s->pres, s->nx);
+        }
+    }
+    s->synced = 1;
+}
+
+void cfdSolverSetDt(CfdSolver *s, f64 dt)
+{
+    if (dt == s->dt) return;
+    s->dt = dt;
+    s->half_dt2 = dt * dt / 2;
+    pistonAccelSetDt(&s->pa, dt);
+    if (s->shadow) cfdSolverSetDt(s->shadow, dt);
+}
+
+f64 cfdSolverMaxWaveSpeed(CfdSolver *s)
+{
+    f64 t0 = cfdWallTime();
+    const i32 nx = s->nx;
+    if (s->precision == CFD_PRECISION_MIXED)
     {
-        f64 _prho_pt = prho_pt(i);
-        f64 _pprho_ppt = pprho_ppt(i, time);
-        new_rho[i] = rho[i] + DT * _prho_pt + HALF_DT2 * _pprho_ppt;
+        f64 vmax = cfdMixedMaxSpeed(s);
+        cfdTimersAdd(&s->timers, CFD_PHASE_CFL, t0, sizeof(f32) * (f64)nx);
+        return vmax + sqrt(K);
     }
-    new_rho[NX - 1] = rborderRho();
-    /* 左边界：用连续性方程更新，避免与内部离散不一致 */
-    new_rho[0] = rho[0] - rho[0] * DT * ((vel[1] - vel[0]) / DX);
-    return new_rho;
+    if (s->device)
+    {
+        f64 vmax = cfdOffloadMaxSpeed(s);
+        cfdTimersAdd(&s->timers, CFD_PHASE_CFL, t0, sizeof(f64) * (f64)nx);
+        return vmax + sqrt(K);
+    }
+    if (s->active)
+    {
+        f64 vmax = cfdActiveMaxSpeed(s);
+        cfdTimersAdd(&s->timers, CFD_PHASE_CFL, t0, sizeof(f64) * (f64)(nx - (s->active->hi - s->active->lo)));
+        return vmax + sqrt(K);
+    }
+    const f64 *vel = s->vel;
+    f64 vmax = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(max:vmax)
+#endif
+    for (int i = 0; i < nx; i++)
+    {
+        f64 v = fabs(vel[i]);
+        if (v > vmax) vmax = v;
+    }
+    cfdTimersAdd(&s->timers, CFD_PHASE_CFL, t0, sizeof(f64) * (f64)nx);
+    return vmax + sqrt(K);
 }
 
-f64 *updateVelocity(f64 time)
+i32 cfdSolverFindInvalid(CfdSolver *s)
 {
-    f64 *new_vel = (f64 *)malloc(sizeof(f64) * NX);
-    if (!new_vel)
+    cfdSolverSync(s);
+    const f64 *rho = s->rho, *vel = s->vel;
+    const i32 nx = s->nx;
+    i32 first = nx;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(min:first)
+#endif
+    for (int i = 0; i < nx; i++)
     {
-        printf("[ERROR] Memory allocation failed during vel update at %.8f sec", time);
-        exit(-1);
+        /* 写成 !(rho > 0) 使 NaN 也判为异常 */
+        if ((!(rho[i] > 0) || !isfinite(rho[i]) || !isfinite(vel[i])) && i < first) first = i;
     }
+    return first < nx ? first : -1;
+}
+
+i32 cfdSolverWatchScan(CfdSolver *s)
+{
+    cfdSolverSync(s);
+    const f64 *rho = s->rho, *vel = s->vel;
+    const i32 nx = s->nx;
+    f64 vmax = 0.0, rmin = INFINITY, bad = 0.0;
 #ifdef _OPENMP
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for simd schedule(static) reduction(max:vmax) reduction(min:rmin) reduction(+:bad)
 #endif
-    for (int i = 1; i < NX - 1; i++)
+    for (int i = 0; i < nx; i++)
+    {
+        vmax = watchMax(vmax, vel[i]);
+        rmin = watchMin(rmin, rho[i]);
+        bad = watchBad(bad, rho[i], vel[i]);
+    }
+    CfdWatchSums sums = {vmax, rmin, bad};
+    watchCheck(s, &sums);
+    return s->watch.tripped;
+}
+
+i32 cfdSolverRewind(CfdSolver *s)
+{
+    /* 导出压力要读两步之前的密度、活动区的代表值只保留当前一步，这两种情形都无法退回 */
+    if (!s->watch.fused || s->precision == CFD_PRECISION_MIXED || s->derived_pressure || s->active || s->shadow
+        || s->device)
+    {
+        return -1;
+    }
+    swapFlowField(s);
+    s->t -= s->dt;
+    s->step--;
+    s->synced = 0;
+    s->watch.fused = 0;
+    pistonAccelInit(&s->pa, &s->profile, s->t, s->dt, s->pa.source, s->pa.use_recurrence);
+    return 0;
+}
+
+const char *cfdWatchReason(i32 tripped)
+{
+    switch (tripped)
     {
-        new_vel[i] = vel[i] + DT * pvx_pt(i, time) + HALF_DT2 * ppvx_ppt(i, time);
+    case CFD_WATCH_NONFINITE: return "non-finite value in the field";
+    case CFD_WATCH_DENSITY:   return "non-positive density";
+    case CFD_WATCH_CFL:       return "CFL limit exceeded";
+    default:                  return "ok";
     }
-    new_vel[NX - 1] = rborderVel(time);
-    new_vel[0] = 0.0;
-    return new_vel;
 }
 
-f64 *updatePressure(f64 time)
+void cfdSolverPoint(const CfdSolver *s, i32 i, f64 *out)
 {
-    f64 *new_pres = (f64 *)malloc(sizeof(f64) * NX);
-    if (!new_pres)
+    if (s->precision == CFD_PRECISION_MIXED)
     {
-        printf("[ERROR] Memory allocation failed during pres update at %.8f sec", time);
-        exit(-1);
+        out[0] = RHO_INIT + (f64)s->drho[i];
+        out[1] = (f64)s->vel32[i];
+        out[2] = s->derived_pressure ? cfdEosPressure(&s->eos, RHO_INIT + (f64)s->drho_next[i])
+                                     : P_INIT + (f64)s->dpres[i];
+        return;
     }
+    if (cfdActivePoint(s, i, out)) return;
+    out[0] = s->rho[i];
+    out[1] = s->vel[i];
+    out[2] = s->derived_pressure ? cfdEosPressure(&s->eos, s->rho_next[i]) : s->pres[i];
+}
+
+void cfdSolverFetchPoints(const CfdSolver *s, const i32 *idx, i32 n)
+{
+    if (s->device && !s->synced) cfdOffloadFetchPoints(s, idx, n);
+}
+
+void initFlowField(CfdSolver *s)
+{
+    const i32 nx = s->nx;
+    /* 与更新核相同的 static 划分做首次写入，页面落在各自线程所在的 NUMA 节点上 */
 #ifdef _OPENMP
 #pragma omp parallel for schedule(static)
 #endif
-    for (int i = 0; i < NX; i++)
+    for (int i = 0; i < nx; i++)
+    {
+        s->vel[i] = s->vel_next[i] = 0;
+        s->pres[i] = P_INIT;
+        if (s->pres_next) s->pres_next[i] = P_INIT;
+        s->rho[i] = s->rho_next[i] = RHO_INIT;
+    }
+    s->synced = 1;
+    printf("[INFO] FlowField Initialized.\n");
+}
+
+/* 右边界两点的间距：均匀网格为 dx，拉伸网格为开口端的最大间距 */
+static inline f64 rightSpacing(const CfdSolver *s)
+{
+    return s->grid ? s->grid->dx_max : s->dx;
+}
+
+f64 rborderRho(const CfdSolver *s)
+{
+    const f64 *rho = s->rho, *vel = s->vel;
+    int i = s->nx - 1;
+    return borderRhoRight(rho[i - 1], rho[i], vel[i - 1], vel[i], rightSpacing(s), s->dt);
+}
+
+f64 rborderVel(const CfdSolver *s, f64 acc)
+{
+    const f64 *rho = s->rho, *vel = s->vel;
+    int i = s->nx - 1;
+    f64 p_diff;
+    if (s->derived_pressure)
+    {
+        /* 当前步的压力由上一步的密度给出 */
+        p_diff = cfdEosPressure(&s->eos, s->rho_next[i]) - cfdEosPressure(&s->eos, s->rho_next[i - 1]);
+    }
+    else
+    {
+        p_diff = s->pres[i] - s->pres[i - 1];
+    }
+    return borderVelRight(rho[i], vel[i - 1], vel[i], p_diff, rightSpacing(s), s->dt, acc);
+}
+
+void updateRho(CfdSolver *s, f64 acc)
+{
+    const i32 nx = s->nx;
+    const f64 *rho = s->rho;
+    f64 *new_rho = s->rho_next;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE)
+#endif
+    for (int i = 1; i < nx - 1; i++)
+    {
+        f64 _prho_pt = prho_pt(s, i);
+        f64 _pprho_ppt = pprho_ppt(s, i, acc);
+        new_rho[i] = rho[i] + s->dt * _prho_pt + s->half_dt2 * _pprho_ppt;
+    }
+}
+
+/*
+    融合核的内部点循环。nx 作为参数传入并内联到各个特化版本中，
+    对常用网格规模，编译器可以按常量循环边界展开与向量化。
+*/
+static inline void fusedInterior(CfdSolver *s, f64 acc, const i32 nx, CfdWatchSums *w)
+{
+    const f64 *restrict rho = s->rho;
+    const f64 *restrict vel = s->vel;
+    f64 *restrict new_rho = s->rho_next;
+    f64 *restrict new_vel = s->vel_next;
+    const f64 dt = s->dt;
+    const f64 half_dt2 = s->half_dt2;
+    const f64 inv_2dx = 1.0 / (2 * s->dx);
+    const f64 inv_dx2 = 1.0 / (s->dx * s->dx);
+    if (!w)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE)
+#endif
+        for (int i = 1; i < nx - 1; i++)
+        {
+            fusedPoint(rho, vel, new_rho, new_vel, dt, half_dt2, inv_2dx, inv_dx2, acc, i);
+        }
+        return;
+    }
+    f64 vmax = 0.0, rmin = INFINITY, bad = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE) reduction(max:vmax) reduction(min:rmin) reduction(+:bad)
+#endif
+    for (int i = 1; i < nx - 1; i++)
+    {
+        fusedPoint(rho, vel, new_rho, new_vel, dt, half_dt2, inv_2dx, inv_dx2, acc, i);
+        vmax = watchMax(vmax, new_vel[i]);
+        rmin = watchMin(rmin, new_rho[i]);
+        bad = watchBad(bad, new_rho[i], new_vel[i]);
+    }
+    watchMerge(w, vmax, rmin, bad);
+}
+
+/* 拉伸网格的内部点循环 [lo, hi)：各点的差分系数取自 s->grid（见 cfd_grid.h） */
+static void stretchedInterior(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    const f64 *restrict rho = s->rho;
+    const f64 *restrict vel = s->vel;
+    f64 *restrict new_rho = s->rho_next;
+    f64 *restrict new_vel = s->vel_next;
+    const f64 *restrict d1 = s->grid->d1;
+    const f64 *restrict d1s = s->grid->d1s;
+    const f64 *restrict d2 = s->grid->d2;
+    const f64 *restrict d2s = s->grid->d2s;
+    const f64 dt = s->dt;
+    const f64 half_dt2 = s->half_dt2;
+    if (!w)
+    {
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(CFD_OMP_SCHEDULE)
+#endif
+        for (int i = lo; i < hi; i++)
+        {
+            fusedPointStretched(rho, vel, new_rho, new_vel, d1, d1s, d2, d2s, dt, half_dt2, acc, i);
+        }
+        return;
+    }
+    f64 vmax = 0.0, rmin = INFINITY, bad = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for simd schedule(CFD_OMP_SCHEDULE) reduction(max:vmax) reduction(min:rmin) reduction(+:bad)
+#endif
+    for (int i = lo; i < hi; i++)
+    {
+        fusedPointStretched(rho, vel, new_rho, new_vel, d1, d1s, d2, d2s, dt, half_dt2, acc, i);
+        vmax = watchMax(vmax, new_vel[i]);
+        rmin = watchMin(rmin, new_rho[i]);
+        bad = watchBad(bad, new_rho[i], new_vel[i]);
+    }
+    watchMerge(w, vmax, rmin, bad);
+}
+
+/*
+    SIMD 核按块分给各线程的内部点循环 [lo, hi)；blocks 不超过 1 时不进入并行区。
+    看门狗开启时每块的归约再在线程间归约，合并进 *w。
+*/
+static void simdInterior(CfdSolver *s, f64 acc, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    const i32 blocks = (hi - lo + CFD_SIMD_BLOCK - 1) / CFD_SIMD_BLOCK;
+    f64 vmax = 0.0, rmin = INFINITY, bad = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE) if(blocks > 1) reduction(max:vmax) reduction(min:rmin) reduction(+:bad)
+#endif
+    for (i32 b = 0; b < blocks; b++)
+    {
+        i32 blo = lo + b * CFD_SIMD_BLOCK;
+        i32 bhi = blo + CFD_SIMD_BLOCK < hi ? blo + CFD_SIMD_BLOCK : hi;
+        CfdWatchSums part = {vmax, rmin, bad};
+        cfdSimdInterior(s->simd, s, acc, blo, bhi, w ? &part : NULL);
+        vmax = part.vmax;
+        rmin = part.rmin;
+        bad = part.bad;
+    }
+    if (w) watchMerge(w, vmax, rmin, bad);
+}
+
+/*
+    融合的单遍模板核：每个内部点只读取一次 rho/vel 的三点模板，
+    一次性求出一阶、二阶空间导数，并同时写出 new_rho/new_vel。
+    展开式与 cfd_differentials.c 中的 pprho_ppt/ppvx_ppt 相同，
+    后者保留为参考实现（见 CFD_REFERENCE_KERNEL）。
+*/
+void updateFlowField(CfdSolver *s, f64 acc)
+{
+    CfdWatchSums *w = s->watch.enabled ? &s->watch.sums : NULL;
+    if (s->simd != CFD_SIMD_SCALAR)
+    {
+        /* 向量化核：按块分给各线程，块内由 SIMD 实现连续处理 */
+        simdInterior(s, acc, 1, s->nx - 1, w);
+        return;
+    }
+
+    if (s->grid)
+    {
+        stretchedInterior(s, acc, 1, s->nx - 1, w);
+        return;
+    }
+
+    /* 标量核：常用网格规模走编译期特化的路径，其余规模走通用路径 */
+    switch (s->nx)
+    {
+    case 1000:    fusedInterior(s, acc, 1000, w);    break;
+    case 10000:   fusedInterior(s, acc, 10000, w);   break;
+    case 100000:  fusedInterior(s, acc, 100000, w);  break;
+    case 1000000: fusedInterior(s, acc, 1000000, w); break;
+    default:      fusedInterior(s, acc, s->nx, w);   break;
+    }
+}
+
+void updateFlowFieldRange(CfdSolver *s, f64 acc, i32 lo, i32 hi)
+{
+    if (lo >= hi) return;
+    CfdWatchSums *w = s->watch.enabled ? &s->watch.sums : NULL;
+    if (s->grid)
+    {
+        stretchedInterior(s, acc, lo, hi, w);
+        return;
+    }
+    /* 活动区开始时只有几百个点，只有一块时不进入并行区 */
+    simdInterior(s, acc, lo, hi, w);
+}
+
+void updateBorders(CfdSolver *s, f64 acc)
+{
+    const i32 nx = s->nx;
+    const f64 *rho = s->rho, *vel = s->vel;
+    /* 速度边界先求：导出压力时它还要读 rho_next[nx - 1] 中上一步的密度；拉伸网格时 dx 即活塞面处的间距 */
+    s->vel_next[nx - 1] = rborderVel(s, acc);
+    s->vel_next[0] = 0.0;
+    s->rho_next[nx - 1] = rborderRho(s);
+    s->rho_next[0] = borderRhoLeft(rho[0], vel[0], vel[1], s->dx, s->dt);
+}
+
+void updateVelocity(CfdSolver *s, f64 acc)
+{
+    const i32 nx = s->nx;
+    const f64 *vel = s->vel;
+    f64 *new_vel = s->vel_next;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE)
+#endif
+    for (int i = 1; i < nx - 1; i++)
+    {
+        new_vel[i] = vel[i] + s->dt * pvx_pt(s, i, acc) + s->half_dt2 * ppvx_ppt(s, i, acc);
+    }
+}
+
+void updatePressure(CfdSolver *s)
+{
+    const i32 nx = s->nx;
+    const f64 *rho = s->rho;
+    f64 *new_pres = s->pres_next;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE)
+#endif
+    for (int i = 0; i < nx; i++)
+    {
+        new_pres[i] = R / MU_STAR * rho[i] * T_INIT;
+    }
+}
+
+void updatePressureRange(CfdSolver *s, i32 lo, i32 hi)
+{
+    const f64 *rho = s->rho;
+    f64 *new_pres = s->pres_next;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(CFD_OMP_SCHEDULE) if(hi - lo > CFD_SIMD_BLOCK)
+#endif
+    for (int i = lo; i < hi; i++)
     {
         new_pres[i] = R / MU_STAR * rho[i] * T_INIT;
     }
-    return new_pres;
-}
\ No newline at end of file
+}
+
+void swapFlowField(CfdSolver *s)
+{
+    f64 *tmp;
+    tmp = s->vel;  s->vel = s->vel_next;   s->vel_next = tmp;
+    tmp = s->rho;  s->rho = s->rho_next;   s->rho_next = tmp;
+    if (!s->derived_pressure)
+    {
+        tmp = s->pres; s->pres = s->pres_next; s->pres_next = tmp;
+    }
+}
+
+/*
+    常驻并行区内一个线程负责的一段网格 [lo, hi) 上的更新：内部点写 *_next，
+    压力覆盖整段。分段与 initFlowField 的 static 划分相同，页面始终留在本线程的 NUMA 节点上。
+*/
+static void updateSlice(CfdSolver *s, i32 lo, i32 hi, CfdWatchSums *w)
+{
+    const i32 nx = s->nx;
+    const i32 ilo = lo < 1 ? 1 : lo;
+    const i32 ihi = hi > nx - 1 ? nx - 1 : hi;
+    const f64 acc = s->pa.acc;
+#ifdef CFD_REFERENCE_KERNEL
+    for (int i = ilo; i < ihi; i++)
+    {
+        s->vel_next[i] = s->vel[i] + s->dt * pvx_pt(s, i, acc) + s->half_dt2 * ppvx_ppt(s, i, acc);
+        s->rho_next[i] = s->rho[i] + s->dt * prho_pt(s, i) + s->half_dt2 * pprho_ppt(s, i, acc);
+        if (w)
+        {
+            watchPoint(s->rho_next[i], s->vel_next[i], &w->vmax, &w->rmin, &w->bad);
+        }
+    }
+#else
+    if (ilo < ihi) cfdSimdInterior(s->simd, s, acc, ilo, ihi, w);
+#endif
+    if (s->derived_pressure) return;
+    f64 *new_pres = s->pres_next;
+    for (int i = lo; i < hi; i++)
+    {
+        new_pres[i] = R / MU_STAR * s->rho[i] * T_INIT;
+    }
+}
+
+i64 cfdSolverAdvance(CfdSolver *s, i64 nsteps, f64 t_stop)
+{
+    if (nsteps <= 0 || s->watch.tripped) return 0;
+    i64 done = 0;
+    if (s->precision == CFD_PRECISION_MIXED || s->shadow || s->device || s->stepper != CFD_STEPPER_TAYLOR || s->grid
+        || s->active)
+    {
+        /*
+            常驻并行区只实现了主机上 f64 存储、均匀网格的 Taylor 格式，也不跟踪活动区；
+            其余情况逐步推进，结果相同（活动区跟踪结束后回到常驻并行区）
+        */
+        while (done < nsteps && !s->watch.tripped)
+        {
+            cfdSolverStep(s);
+            done++;
+            if (s->t > t_stop) break;
+        }
+        return done;
+    }
+    f64 t0 = cfdWallTime();
+    /*
+        看门狗：每个线程把自己一段的归约写进按步数奇偶交替的槽（每槽一条缓存行），barrier 之后
+        每个线程按同样的顺序合并全部槽，得到同样的判断，在同一步一起退出。下一次写同一组槽
+        要再过一个 barrier，此时所有线程都已读完。
+    */
+#ifdef _OPENMP
+    const i32 max_threads = omp_get_max_threads();
+#else
+    const i32 max_threads = 1;
+#endif
+    enum { SLOT = 8 };
+    f64 *slots = NULL;
+    if (s->watch.enabled)
+    {
+        slots = (f64 *)malloc(sizeof(f64) * SLOT * 2 * (size_t)max_threads);
+        if (!slots)
+        {
+            printf("[WARN] Memory allocation failed for the watchdog; this chunk is not checked.\n");
+        }
+    }
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+#ifdef _OPENMP
+        const i32 nthreads = omp_get_num_threads();
+        const i32 tid = omp_get_thread_num();
+#else
+        const i32 nthreads = 1;
+        const i32 tid = 0;
+#endif
+        const i32 q = s->nx / nthreads, r = s->nx % nthreads;
+        const i32 lo = tid * q + (tid < r ? tid : r);
+        const i32 hi = lo + q + (tid < r ? 1 : 0);
+        /* 边界由负责 nx - 2 的线程在自己的内部点之前更新（导出压力时要先读 rho_next[nx - 2]） */
+        const i32 border = lo <= s->nx - 2 && s->nx - 2 < hi;
+
+        /*
+            每个线程持有求解器的私有副本（数组指针、时间与活塞加速度），
+            各自做同样的交换与推进，结果逐位相同，因此每步只需要一个 barrier：
+            barrier 之前所有线程只读当前场、只写 *_next 中互不重叠的部分。
+        */
+        CfdSolver local = *s;
+        i64 k = 0;
+        while (k < nsteps)
+        {
+            CfdWatchSums part = {0.0, INFINITY, 0.0};
+            CfdWatchSums *w = slots ? &part : NULL;
+            if (border)
+            {
+                updateBorders(&local, local.pa.acc);
+                if (w) watchBorders(&local, w);
+            }
+            updateSlice(&local, lo, hi, w);
+            if (w)
+            {
+                f64 *slot = slots + SLOT * (2 * tid + (k & 1));
+                slot[0] = part.vmax;
+                slot[1] = part.rmin;
+                slot[2] = part.bad;
+            }
+#ifdef _OPENMP
+#pragma omp barrier
+#endif
+            swapFlowField(&local);
+            local.t += local.dt;
+            local.step++;
+            pistonAccelAdvance(&local.pa);
+            if (w)
+            {
+                CfdWatchSums all = {0.0, INFINITY, 0.0};
+                for (i32 t = 0; t < nthreads; t++)
+                {
+                    const f64 *slot = slots + SLOT * (2 * t + (k & 1));
+                    watchMerge(&all, slot[0], slot[1], slot[2]);
+                }
+                watchCheck(&local, &all);
+            }
+            k++;
+            if (local.watch.tripped || local.t > t_stop) break;
+        }
+
+        if (tid == 0)
+        {
+            s->vel = local.vel;      s->vel_next = local.vel_next;
+            s->rho = local.rho;      s->rho_next = local.rho_next;
+            s->pres = local.pres;    s->pres_next = local.pres_next;
+            s->t = local.t;
+            s->step = local.step;
+            s->synced = 0;
+            s->pa = local.pa;
+            s->watch = local.watch;
+            s->watch.fused = slots != NULL;
+            done = k;
+        }
+    }
+    free(slots);
+    cfdTimersAdd(&s->timers, CFD_PHASE_REGION, t0, (f64)done * (s->derived_pressure ? 4 : 6) * sizeof(f64) * s->nx);
+    return done;
+}
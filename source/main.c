@@ -5,94 +5,406 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
-#include <time.h>
+#include <math.h>
 
 #include "cfd_util.h"
 #include "cfd_differentials.h"
+#include "cfd_output.h"
+#include "cfd_report.h"
+#include "cfd_mixed.h"
+#include "cfd_ensemble.h"
+#include "cfd_checkpoint.h"
+#include "cfd_probe.h"
+#include "cfd_mpi.h"
+#include "cfd_offload.h"
+#include "cfd_temporal.h"
+#include "cfd_stepper.h"
+#include "cfd_live.h"
+#include "cfd_sweep.h"
 #include "constants.h"
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
-#ifdef _WIN32
-#define CLEAR "cls"
+/*
+    自适应步长：每 cfl_interval 步按 dt = CFL * dx / max(|v|+c) 重新估计一次，
+    并截断到下一个快照时刻与结束时刻，使快照恰好落在 TIMER 的整数倍上。
+    返回非 0 表示这一步结束时正好到达快照时刻。
+*/
+static i32 chooseAdaptiveStep(CfdSolver *s, const CfdConfig *cfg, i64 step, f64 *dt_cfl, f64 next_snapshot)
+{
+    if (step % cfg->cfl_interval == 0){
+        *dt_cfl = cfg->cfl * s->dx / cfdSolverMaxWaveSpeed(s);
+    }
+    f64 dt = *dt_cfl;
+    f64 target = next_snapshot < cfg->t_end ? next_snapshot : cfg->t_end;
+    i32 landed = 0;
+    /* 留一点余量，避免在目标时刻前留下极短的一步 */
+    if (s->t + dt * (1.0 + 1e-9) >= target){
+        dt = target - s->t;
+        landed = target == next_snapshot;
+    }
+    cfdSolverSetDt(s, dt);
+    return landed;
+}
+
+/* 把主循环的输出进度记入 run 并提交一个检查点；先等写线程把已提交的帧写完，检查点记录的帧数才与文件内容一致 */
+static i32 saveCheckpoint(CfdCheckpoint *checkpoint, CfdSolver *s, CfdRunState *run, CfdOutput *output, CfdProbes *probes)
+{
+    run->output_frames = cfdOutputFlush(output);
+    run->output_calls = output->calls;
+    run->probe_samples = probes ? cfdProbesFlush(probes) : 0;
+    if (s->device || s->active) cfdSolverSync(s);
+    return cfdCheckpointSave(checkpoint, s, run);
+}
+
+/* 看门狗中止时的诊断：原因、最近一步的 max|v|、min rho 与 CFL 数，以及建议的步长 */
+static void reportWatchdog(CfdSolver *s)
+{
+    const CfdWatch *w = &s->watch;
+    const f64 c = sqrt(K);
+    printf("[ERROR] Watchdog: %s at step %lld (t=%.6e s); aborting\n", cfdWatchReason(w->tripped), w->trip_step, w->trip_t);
+    printf("[ERROR]   max|v|=%.4e m/s, min rho=%.4e kg/m^3, CFL=(max|v|+c)*dt/dx=%.3f with dt=%.3e, dx=%.3e "
+           "(%s limit %.2f, c=%.1f m/s)\n", w->vmax, w->rmin, w->cfl, s->dt, s->dx, cfdStepperName(s->stepper),
+           cfdStepperCflLimit(s->stepper), c);
+    if (w->tripped != CFD_WATCH_CFL){
+        i32 bad = cfdSolverFindInvalid(s);
+        if (bad >= 0) printf("[ERROR]   first invalid point at grid index %d\n", bad);
+    }
+    if (isfinite(w->vmax)){
+        printf("[INFO] dt <= %.3e keeps CFL at 0.5 for this max|v| (or use --cfl 0.5)\n", 0.5 * s->dx / (w->vmax + c));
+    }
+}
+
+/* 按给定参数完整运行一个算例；profile 为 NULL 时用题设的活塞曲线，结果写入 *result */
+static i32 runSimulation(const CfdConfig *cfg, const PistonProfile *profile, CfdRunResult *result)
+{
+    result->status = CFD_RUN_FAILED;
+    result->steps = 0;
+    result->t = 0.0;
+    /* 用 mpirun 启动多个进程时按区域分解运行，单进程走下面的完整路径 */
+    if (cfdMpiSize() > 1){
+        if (cfdMpiRun(cfg) != 0) return -1;
+        result->status = CFD_RUN_OK;
+        result->t = cfg->t_end;
+        return 0;
+    }
+    if (cfg->ensemble[0] != '\0'){
+        if (cfg->checkpoint_interval > 0 || cfg->restart){
+            printf("[WARN] Checkpoints are not supported for ensemble runs; ignoring checkpoint_interval/restart.\n");
+        }
+        if (cfg->probe_count > 0){
+            printf("[WARN] Probes are not supported for ensemble runs; ignoring probes.\n");
+        }
+        if (cfg->live[0] != '\0'){
+            printf("[WARN] Live publishing is not supported for ensemble runs; ignoring live.\n");
+        }
+        if (cfdEnsembleRun(cfg) != 0) return -1;
+        result->status = CFD_RUN_OK;
+        result->t = cfg->t_end;
+        return 0;
+    }
+
+    CfdSolver *s = cfdSolverCreate(cfg);
+    if (s == NULL) return -1;
+    if (profile) cfdSolverSetProfile(s, profile);
+
+    /* 续算时先恢复求解器与主循环的状态，输出从检查点记录的帧之后接着写 */
+    CfdRunState run = {0.0, cfg->timer, 1, cfg->dt, 0, 0, 0};
+    if (cfg->restart && cfdCheckpointLoad(cfg, s, &run) != 0){
+        cfdSolverDestroy(s);
+        return -1;
+    }
+    /* USE_OFFLOAD 构建中流场此后常驻在设备上（续算时搬上去的是恢复后的状态） */
+    if (cfdOffloadAttach(s) != 0){
+        cfdSolverDestroy(s);
+        return -1;
+    }
+    CfdTemporal *temporal = NULL;
+    if (cfg->temporal_depth > 0){
+        if (cfg->cfl > 0){
+            printf("[WARN] Temporal blocking only applies to fixed time steps; advancing step by step.\n");
+        } else if (s->precision == CFD_PRECISION_MIXED || s->shadow){
+            printf("[WARN] Temporal blocking only applies to double precision; advancing step by step.\n");
+        } else if (s->device){
+            printf("[WARN] Temporal blocking is not used when the fields live on an offload device.\n");
+        } else if (s->stepper != CFD_STEPPER_TAYLOR){
+            printf("[WARN] Temporal blocking only applies to the taylor stepper; advancing step by step.\n");
+        } else if (s->grid){
+            printf("[WARN] Temporal blocking only applies to the uniform grid; advancing step by step.\n");
+        } else if (s->active){
+            printf("[WARN] Temporal blocking does not track the active region; advancing step by step.\n");
+        } else {
+#ifdef CFD_REFERENCE_KERNEL
+            printf("[WARN] Temporal blocking uses the fused kernel; not available with the reference kernel.\n");
 #else
-#define CLEAR "clear"
+            temporal = cfdTemporalCreate(s, cfg->temporal_depth, cfg->temporal_tile);
+            if (temporal == NULL){
+                cfdSolverDestroy(s);
+                return -1;
+            }
 #endif
+        }
+    }
+    CfdOutput *output = cfg->restart ? cfdOutputResume(cfg, s, run.output_frames, run.output_calls)
+                                     : cfdOutputOpen(cfg, s);
+    if (output == NULL){
+        cfdTemporalDestroy(temporal);
+        cfdSolverDestroy(s);
+        return -1;
+    }
+    CfdProbes *probes = NULL;
+    if (cfg->probe_count > 0){
+        probes = cfdProbesOpen(cfg, s, cfg->restart ? run.probe_samples : -1);
+        if (probes == NULL){
+            cfdOutputClose(output);
+            cfdTemporalDestroy(temporal);
+            cfdSolverDestroy(s);
+            return -1;
+        }
+        if (!cfg->restart) cfdProbesSample(probes, s);
+    }
+    /* 实时发布失败只给出警告，不影响求解 */
+    CfdLive *live = cfg->live[0] != '\0' ? cfdLiveOpen(cfg, s, output) : NULL;
+    if (live) cfdLivePublish(live, s);
+    CfdCheckpoint *checkpoint = NULL;
+    if (cfg->checkpoint_interval > 0){
+        checkpoint = cfdCheckpointOpen(cfg);
+        if (checkpoint == NULL){
+            cfdLiveClose(live);
+            cfdProbesClose(probes);
+            cfdOutputClose(output);
+            cfdTemporalDestroy(temporal);
+            cfdSolverDestroy(s);
+            return -1;
+        }
+    }
+
+    i32 adaptive = cfg->cfl > 0;
+    i32 persistent = cfg->persistent_region && !adaptive;
+    printf("[INFO] NX=%d DX=%.3e DT=%.3e T_END=%.3f\n", cfg->nx, cfg->dx, cfg->dt, cfg->t_end);
+    if (adaptive){
+        printf("[INFO] Adaptive time step enabled: CFL=%.3f, re-estimated every %d steps\n", cfg->cfl, cfg->cfl_interval);
+    }
+    if (cfg->persistent_region && adaptive){
+        printf("[WARN] persistent_region only applies to fixed time steps; advancing step by step.\n");
+    } else if (persistent && s->precision == CFD_PRECISION_MIXED){
+        printf("[WARN] persistent_region only applies to double precision; advancing step by step.\n");
+    } else if (persistent && s->stepper != CFD_STEPPER_TAYLOR){
+        printf("[WARN] persistent_region only applies to the taylor stepper; advancing step by step.\n");
+    } else if (persistent && s->grid && !temporal){
+        printf("[WARN] persistent_region only applies to the uniform grid; advancing step by step.\n");
+    } else if (persistent && s->active && !temporal){
+        printf("[INFO] The persistent parallel region starts once the active region covers the whole tube\n");
+    } else if (persistent && temporal){
+        printf("[INFO] Temporal blocking replaces the persistent parallel region\n");
+    } else if (persistent){
+        printf("[INFO] Advancing inside a persistent OpenMP parallel region\n");
+    }
+
+    i64 maxSteps = (i64)(cfg->t_end / cfg->dt) + 1;
+    f64 total_timer = run.total_timer;
+    i64 snapshot_index = run.snapshot_index;
+    f64 next_snapshot = run.next_snapshot;
+    f64 dt_cfl = run.dt_cfl;
+    const i64 first_step = s->step;
+    f64 last_checkpoint = cfdWallTime();
+    /* 核内不归约的推进路径（多级格式、时间分块、卸载）隔这么多步单独扫描一次 */
+    const i32 scan_every = cfg->nan_check > 0 ? cfg->nan_check : cfg->watchdog ? cfg->print_after_steps : 0;
+    i64 last_scan = s->step;
+    i32 unstable = 0;
+
+    CfdPrecisionReport precision_report;
+    if (s->shadow) cfdPrecisionReportOpen(&precision_report, cfg->output_dir);
+
+    CfdProgress progress_report;
+    /* 续算时以恢复的那一步为起点估计速度与 ETA */
+    const f64 first_progress = adaptive ? s->t / cfg->t_end : (f64)first_step / maxSteps;
+    cfdProgressBegin(&progress_report, cfg->quiet, first_step, first_progress);
+
+    i64 step;
+    for (step = first_step; adaptive ? s->t < cfg->t_end : step < maxSteps; step++){
+        i32 landed = 0;
+        if (adaptive){
+            landed = chooseAdaptiveStep(s, cfg, step, &dt_cfl, next_snapshot);
+            cfdSolverStep(s);
+        } else if (persistent || temporal){
+            /* 在一个并行区内（或按时间分块）推进到下一次进度输出，遇到快照时刻提前返回 */
+            i64 until = (step + cfg->print_after_steps - 1) / cfg->print_after_steps * cfg->print_after_steps;
+            if (until > maxSteps - 1) until = maxSteps - 1;
+            if (probes){
+                /* 下一个探针采样步之后返回 */
+                i64 probe_until = (step / cfg->probe_every + 1) * cfg->probe_every - 1;
+                if (until > probe_until) until = probe_until;
+            }
+            if (live){
+                i64 live_until = (step / cfg->live_every + 1) * cfg->live_every - 1;
+                if (until > live_until) until = live_until;
+            }
+            step += (temporal ? cfdTemporalAdvance(temporal, s, until - step + 1, total_timer)
+                              : cfdSolverAdvance(s, until - step + 1, total_timer)) - 1;
+        } else {
+            cfdSolverStep(s);
+        }
+        if (!s->watch.tripped && !s->watch.fused && scan_every > 0 && s->step - last_scan >= scan_every){
+            last_scan = s->step;
+            cfdSolverWatchScan(s);
+        }
+        if (s->watch.tripped){
+            /* 发散的算例不必推进到 t_end；在写出任何输出之前中止，快照、探针与检查点里只有正常的状态 */
+            reportWatchdog(s);
+            if (checkpoint){
+                /* 核内发现时上一步仍在 *_next 中，退回去保存；只超过 CFL 上限时当前状态仍然有效 */
+                if (s->watch.tripped == CFD_WATCH_CFL || cfdSolverRewind(s) == 0){
+                    cfdCheckpointWait(checkpoint);
+                    run.total_timer = total_timer;
+                    run.next_snapshot = next_snapshot;
+                    run.snapshot_index = snapshot_index;
+                    run.dt_cfl = dt_cfl;
+                    if (saveCheckpoint(checkpoint, s, &run, output, probes) == 0){
+                        printf("[INFO] Saving the last good state (step %lld, t=%.6e s) to the checkpoint\n",
+                               (long long)s->step, s->t);
+                    }
+                } else {
+                    printf("[WARN] Cannot step back from this state; any earlier periodic checkpoint is left in place\n");
+                }
+            }
+            unstable = 1;
+            step++;
+            break;
+        }
+        if (landed){
+            /* 消除累加误差，使快照时刻精确等于 TIMER 的整数倍 */
+            s->t = next_snapshot;
+        }
+        if (probes && s->step % cfg->probe_every == 0){
+            f64 t0 = cfdWallTime();
+            cfdProbesSample(probes, s);
+            cfdTimersAdd(&s->timers, CFD_PHASE_PROBE, t0, 0.0);
+        }
+        if (live && s->step % cfg->live_every == 0){
+            f64 t0 = cfdWallTime();
+            cfdLivePublish(live, s);
+            cfdTimersAdd(&s->timers, CFD_PHASE_OUTPUT, t0, 0.0);
+        }
+
+        /* 自适应模式下总步数未知，用模拟时间估计进度 */
+        f64 progress = adaptive ? s->t / cfg->t_end : (f64)step / maxSteps;
+        i32 last = adaptive ? !(s->t < cfg->t_end) : step == maxSteps - 1;
+        if (step % cfg->print_after_steps == 0 || last) {
+            /* 只取活塞面上的一个点，不必展开（或从设备传回）整个流场 */
+            char line[128];
+            const i32 piston = 0;
+            f64 p0[3];
+            cfdSolverFetchPoints(s, &piston, 1);
+            cfdSolverPoint(s, piston, p0);
+            if (adaptive){
+                snprintf(line, sizeof(line), "dt=%.3e rho[0]=%.8f vel[0]=%.8f pres[0]=%.8f",
+                         s->dt, p0[0], p0[1], p0[2]);
+            } else {
+                snprintf(line, sizeof(line), "rho[0]=%.8f vel[0]=%.8f pres[0]=%.8f",
+                         p0[0], p0[1], p0[2]);
+            }
+            cfdProgressUpdate(&progress_report, s->t, step, adaptive ? 0 : maxSteps, progress, line);
+        }
+
+        f64 t0 = cfdWallTime();
+        if (adaptive){
+            if (landed){
+                cfdSolverSync(s);
+                cfdOutputWrite(output, s);
+                cfdTimersAdd(&s->timers, CFD_PHASE_OUTPUT, t0, 0.0);
+                if (s->shadow) cfdPrecisionReportSample(&precision_report, s);
+                next_snapshot = ++snapshot_index * cfg->timer;
+            }
+        } else if (s->t > total_timer){
+            total_timer += cfg->timer;
+            cfdSolverSync(s);
+            cfdOutputWrite(output, s);
+            cfdTimersAdd(&s->timers, CFD_PHASE_OUTPUT, t0, 0.0);
+            if (s->shadow) cfdPrecisionReportSample(&precision_report, s);
+        }
+
+        if (checkpoint && cfdWallTime() - last_checkpoint >= cfg->checkpoint_interval){
+            t0 = cfdWallTime();
+            run.total_timer = total_timer;
+            run.next_snapshot = next_snapshot;
+            run.snapshot_index = snapshot_index;
+            run.dt_cfl = dt_cfl;
+            saveCheckpoint(checkpoint, s, &run, output, probes);
+            last_checkpoint = cfdTimersAdd(&s->timers, CFD_PHASE_CHECKPOINT, t0, 0.0);
+        }
+    }
+    cfdCheckpointClose(checkpoint);
+    /* 最后一帧总是发布，查看器停在结束时刻的流场上 */
+    if (live && s->step % cfg->live_every != 0) cfdLivePublish(live, s);
+    cfdLiveClose(live);
+    cfdProbesClose(probes);
+
+    /* 关闭输出时要等写线程清空队列，这部分也计入输出阶段 */
+    f64 t0 = cfdWallTime();
+    cfdOutputClose(output);
+    cfdTimersAdd(&s->timers, CFD_PHASE_OUTPUT, t0, 0.0);
+    f64 wall = cfdWallTime() - progress_report.start;
+    cfdProgressEnd(&progress_report, step - first_step);
+    if (s->shadow){
+        cfdPrecisionReportSample(&precision_report, s);
+        cfdPrecisionReportClose(&precision_report);
+    }
+
+    char perf_path[CFD_PATH_MAX + 64];
+    if (cfg->perf_json[0] != '\0'){
+        snprintf(perf_path, sizeof(perf_path), "%s", cfg->perf_json);
+    } else {
+        snprintf(perf_path, sizeof(perf_path), "%s/perf.json", cfg->output_dir);
+    }
+    cfdReportSummary(&s->timers, s->nx, step - first_step, wall, perf_path);
+    result->steps = step - first_step;
+    result->t = s->t;
+    result->status = unstable ? CFD_RUN_UNSTABLE : CFD_RUN_OK;
+    cfdTemporalDestroy(temporal);
+    cfdSolverDestroy(s);
+    return unstable ? -1 : 0;
+}
 
 i32 main(i32 argc, char **argv){
+    CfdConfig *runs = NULL;
+    i32 runCount = 0;
+    cfdMpiInit(&argc, &argv);
+    i32 status = cfdConfigParseArgs(argc, argv, &runs, &runCount);
+    if (status != 0){
+        cfdMpiFinalize();
+        return status == 1 ? 0 : -1;
+    }
+
 #ifdef _OPENMP
     printf("[INFO] OpenMP is enabled, running with %d threads.\n", omp_get_max_threads());
 #else
     printf("[INFO] OpenMP is not enabled, running in single-thread mode.\n");
 #endif
-    sleep(1);
-    initFlowField();
-
-    f64 t = 0.0;
-    i32 step = 0;
-    i32 maxSteps = (i32)(T_END / DT) + 1;
-    f64 total_timer = 0.0;
-
-    clock_t start_clock = clock();
-
-    for (step = 0; step < maxSteps; step++){
-        f64 *new_vel = updateVelocity(t);
-        f64 *new_rho = updateRho(t);
-        f64 *new_pres = updatePressure(t);
-        
-        memcpy(vel, new_vel, sizeof(f64) * NX);
-        memcpy(rho, new_rho, sizeof(f64) * NX);
-        memcpy(pres, new_pres, sizeof(f64) * NX);
-
-        free(new_rho);
-        free(new_pres);
-        free(new_vel);
-
-        if (step % PRINT_AFTER_STEPS == 0 || step == maxSteps - 1) {
-            system(CLEAR);
-
-
-            // ETA Calculation
-            char eta_str[32] = "ETA: --:--:--";
-            if (step > 10) { // Start calculating after a few steps for stability
-                clock_t current_clock = clock();
-                double elapsed_secs = (double)(current_clock - start_clock) / CLOCKS_PER_SEC;
-                double steps_per_sec = (double)step / elapsed_secs;
-                double remaining_secs = (double)(maxSteps - step) / steps_per_sec;
-
-                int hours = (int)(remaining_secs / 3600);
-                int minutes = (int)((remaining_secs - (hours * 3600)) / 60);
-                int seconds = (int)remaining_secs % 60;
-                sprintf(eta_str, "ETA: %02d:%02d:%02d", hours, minutes, seconds);
-            }
 
-            printf("t=%.8f step=%d/%d (%.2f%%) %s | rho[0]=%.8f vel[0]=%.8f pres[0]=%.8f\n",
-                   t, step, maxSteps, (double)step / maxSteps * 100.0, eta_str,
-                   rho[0], vel[0], pres[0]);
-            fflush(stdout);
-        }
-
-        t += DT;
-        if (t > total_timer){
-            total_timer += TIMER;
-            char filename[64];
-            sprintf(filename, "build/snapshot_%.6e.csv", t);
-            FILE *out = fopen(filename, "w");
-            if (out == NULL){
-                printf("[WARN] Cannot open %s for writing; continuing without CSV output.\n", filename);
+    for (i32 r = 0; r < runCount; r++){
+        if (runCount > 1) printf("[INFO] Starting run %d/%d\n", r + 1, runCount);
+        CfdRunResult result;
+        i32 failed;
+        if (runs[r].sweep[0] != '\0'){
+            if (cfdMpiSize() > 1){
+                printf("[ERROR] Parameter sweeps run in a single process; start without mpirun.\n");
+                failed = 1;
             } else {
-                fprintf(out, "time,idx,rho,vel,pres\n");
-                for (i32 i = 0; i < NX; i += NX / 1000){
-                    fprintf(out, "%.6f,%d,%.12e,%.12e,%.12e\n", t, i, rho[i], vel[i], pres[i]);
-                }
-            fclose(out);
-            printf("[INFO] Saved snapshot at t=%.6f to %s\n", t, filename);
+                failed = cfdSweepRun(&runs[r], runSimulation) != 0;
             }
+        } else {
+            failed = runSimulation(&runs[r], NULL, &result) != 0;
+        }
+        if (failed){
+            free(runs);
+            cfdMpiFinalize();
+            return -1;
         }
     }
+    free(runs);
+    cfdMpiFinalize();
     return 0;
-}
\ No newline at end of file
+}
@@ -2,7 +2,9 @@
 """
 visualizations.py
 
-Render heatmaps for 1D CFD snapshots saved as CSV by main.c.
+Render heatmaps for 1D CFD snapshots saved by main.c, either as the binary
+container build/snapshots.bin (memory-mapped, preferred when present), the
+compressed container build/snapshots.cfz (decoded on load), or as CSV.
 
 Usage examples:
   # Show latest snapshot, density heatmap
@@ -14,8 +16,17 @@ Usage examples:
   # Save the image instead of showing
   python vispy/visualizations.py --field pres --save out.png
 
+  # Show frame 42 of the binary container
+  python vispy/visualizations.py --field rho --file build/snapshots.bin --frame 42
+
+  # Follow a running solver through shared memory (`sim --live cfd`), no file I/O
+  python vispy/visualizations.py --field pres --watch --live cfd --interval 0.05
+
 Notes:
-- The script parses include/constants.h to read NX and DX.
+- For CSV snapshots the script parses include/constants.h to read NX and DX;
+  for the binary container and the live buffer the sample positions come
+  from the header (cfd_snapshots.sample_x), including stretched grids, which
+  are resampled to even spacing for display.
 - Since the simulation is 1D, we replicate the 1D profile along a fake y-axis to form a heatmap.
 """
 from __future__ import annotations
@@ -25,9 +36,10 @@ import csv
 import glob
 import os
 import re
+import sys
 import time
 from dataclasses import dataclass
-from typing import Optional, Tuple, List
+from typing import Callable, Optional, Tuple, List
 
 import numpy as np
 import matplotlib.pyplot as plt
@@ -37,6 +49,10 @@ ROOT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
 DEFAULT_CONSTANTS = os.path.join(ROOT_DIR, 'include', 'constants.h')
 DEFAULT_BUILD_DIR = os.path.join(ROOT_DIR, 'build')
 
+sys.path.insert(0, os.path.join(ROOT_DIR, 'scripts'))
+from cfd_snapshots import SnapshotFile, find_snapshot_file, open_snapshots, read_header  # noqa: E402
+from cfd_live import LiveField  # noqa: E402
+
 
 @dataclass
 class SimConstants:
@@ -96,14 +112,14 @@ def list_snapshots_sorted(build_dir: str = DEFAULT_BUILD_DIR) -> List[Tuple[str,
     return out
 
 
-def compute_minmax_over_files(files: List[Tuple[str, float]], field: str) -> Tuple[Optional[float], Optional[float]]:
-    """Compute global min/max for a field across given snapshot files.
+def compute_minmax(loaders: List[Tuple[str, Callable[[], 'Snapshot']]], field: str) -> Tuple[Optional[float], Optional[float]]:
+    """Compute global min/max for a field across the given snapshot loaders.
     Returns (vmin, vmax) or (None, None) if no data.
     """
     vmin: Optional[float] = None
     vmax: Optional[float] = None
-    for path, _ in files:
-        snap = load_snapshot(path)
+    for _, load in loaders:
+        snap = load()
         data = getattr(snap, field)
         if data.size == 0:
             continue
@@ -121,6 +137,18 @@ class Snapshot:
     rho: np.ndarray
     vel: np.ndarray
     pres: np.ndarray
+    x: Optional[np.ndarray] = None  # sample positions (m); None means idx * DX
+    stretched: bool = False         # x is unevenly spaced (grid_stretch > 0)
+
+
+def heatmap_row(snapshot: Snapshot, consts: SimConstants, field: str) -> Tuple[np.ndarray, np.ndarray]:
+    """(x, values) on evenly spaced positions for imshow; a stretched grid is linearly resampled."""
+    x = snapshot.x if snapshot.x is not None else snapshot.idx * consts.DX
+    data = getattr(snapshot, field)
+    if snapshot.stretched:
+        even = np.linspace(float(x[0]), float(x[-1]), len(x))
+        return even, np.interp(even, x, data)
+    return x, data
 
 
 def load_snapshot(csv_path: str) -> Snapshot:
@@ -158,6 +186,33 @@ def load_snapshot(csv_path: str) -> Snapshot:
     )
 
 
+def snapshot_from_frame(snaps: SnapshotFile, k: int) -> Snapshot:
+    """Wrap frame k of a memory-mapped container; the arrays are views, nothing is parsed."""
+    frame = snaps.frames[k]
+    return Snapshot(time=float(frame['time']), idx=snaps.idx,
+                    rho=frame['rho'], vel=frame['vel'], pres=frame['pres'],
+                    x=snaps.x, stretched=snaps.header.grid_stretch > 0)
+
+
+def collect_snapshot_loaders(build_dir: str) -> List[Tuple[str, Callable[[], Snapshot]]]:
+    """Return (label, loader) pairs in time order: frames of snapshots.bin/.cfz if present, else CSV files."""
+    bin_path = find_snapshot_file(build_dir)
+    if bin_path:
+        snaps = open_snapshots(bin_path)
+        return [(f"{os.path.basename(bin_path)}[{k}]", (lambda k=k: snapshot_from_frame(snaps, k)))
+                for k in range(len(snaps))]
+    return [(os.path.basename(p), (lambda p=p: load_snapshot(p))) for p, _ in list_snapshots_sorted(build_dir)]
+
+
+def constants_for(build_dir: str, consts: SimConstants) -> SimConstants:
+    """Prefer NX/DX from the binary container header over constants.h."""
+    bin_path = find_snapshot_file(build_dir)
+    if bin_path:
+        h = read_header(bin_path)
+        return SimConstants(NX=h.nx, DX=h.dx)
+    return consts
+
+
 def make_heatmap_2d(values_1d: np.ndarray, y_repeat: int) -> np.ndarray:
     values_1d = np.asarray(values_1d, dtype=float)
     # Shape: (y_repeat, nx_samples)
@@ -171,10 +226,8 @@ def plot_heatmap(snapshot: Snapshot, consts: SimConstants, field: str, y_repeat:
     if field not in ('rho', 'vel', 'pres'):
         raise ValueError("--field must be one of: rho, vel, pres")
 
-    data = getattr(snapshot, field)
-
-    # x positions in meters using constants
-    x = snapshot.idx * consts.DX
+    # x positions in meters (from the container header when available)
+    x, data = heatmap_row(snapshot, consts, field)
 
     # Build heatmap by repeating along y
     H = make_heatmap_2d(data, y_repeat=y_repeat)
@@ -204,36 +257,80 @@ def plot_heatmap(snapshot: Snapshot, consts: SimConstants, field: str, y_repeat:
         plt.close(fig)
 
 
+def open_live(name: str) -> Optional[LiveField]:
+    """Map the solver's live buffer; None while the solver has not created it yet."""
+    try:
+        return LiveField(name)
+    except (FileNotFoundError, ValueError):
+        return None
+
+
 def watch_heatmap(consts: SimConstants, field: str, build_dir: str = DEFAULT_BUILD_DIR,
                   y_repeat: int = 50, cmap: str = 'viridis', interval: float = 0.5,
                   vmin: Optional[float] = None, vmax: Optional[float] = None,
-                  lock_scale: bool = True) -> None:
-    """Continuously watch the build directory and refresh the heatmap with the latest snapshot."""
+                  lock_scale: bool = True, live_name: Optional[str] = None) -> None:
+    """Continuously watch the build directory (or the live buffer `live_name`) and refresh the heatmap."""
     plt.ion()
     fig, ax = plt.subplots(figsize=(10, 3.2))
     im = None
     cbar = None
     last_path = None
     last_mtime = 0.0
+    live: Optional[LiveField] = None
+    # Live frames have no history to scan: a locked scale grows with the frames seen so far
+    grow_scale = live_name is not None and lock_scale and (vmin is None or vmax is None)
 
     # If locking scale and user didn't provide bounds, compute once from current files
-    if lock_scale and (vmin is None or vmax is None):
-        files_now = list_snapshots_sorted(build_dir)
-        vmin_auto, vmax_auto = compute_minmax_over_files(files_now, field)
+    if live_name is None and lock_scale and (vmin is None or vmax is None):
+        vmin_auto, vmax_auto = compute_minmax(collect_snapshot_loaders(build_dir), field)
         if vmin is None:
             vmin = vmin_auto
         if vmax is None:
             vmax = vmax_auto
 
+    snaps: Optional[SnapshotFile] = None
+    last_frames = 0
+
     try:
         while True:
-            path = find_latest_snapshot(build_dir)
+            # Prefer the binary container: a new frame is simply a larger file
+            label = None
+            snap = None
+            bin_path = None if live_name else find_snapshot_file(build_dir)
+            if live_name:
+                # Shared memory: no file I/O, and the solver never waits for this loop
+                if live is None or live.stale():
+                    live = open_live(live_name) or live
+                frame = live.latest() if live else None
+                if frame is not None:
+                    snap = Snapshot(time=frame.time, idx=live.idx, rho=frame.rho, vel=frame.vel, pres=frame.pres,
+                                    x=live.x, stretched=live.header.grid_stretch > 0)
+                    label = f"live {live_name} frame {frame.frame} (step {frame.step})"
+                    if grow_scale:
+                        data = getattr(snap, field)
+                        vmin = float(np.nanmin(data)) if vmin is None else min(vmin, float(np.nanmin(data)))
+                        vmax = float(np.nanmax(data)) if vmax is None else max(vmax, float(np.nanmax(data)))
+                path = live_name if live and live.published else None
+            elif bin_path:
+                if snaps is None:
+                    snaps = open_snapshots(bin_path)
+                nframes = snaps.refresh()
+                if nframes > last_frames:
+                    snap = snapshot_from_frame(snaps, nframes - 1)
+                    label = f"{os.path.basename(bin_path)}[{nframes - 1}]"
+                    last_frames = nframes
+                path = bin_path if nframes else None
+            else:
+                path = find_latest_snapshot(build_dir)
+                if path:
+                    mtime = os.path.getmtime(path)
+                    if path != last_path or mtime > last_mtime:
+                        snap = load_snapshot(path)
+                        label = os.path.basename(path)
+                        last_path, last_mtime = path, mtime
             if path:
-                mtime = os.path.getmtime(path)
-                if path != last_path or mtime > last_mtime:
-                    snap = load_snapshot(path)
-                    data = getattr(snap, field)
-                    x = snap.idx * consts.DX
+                if snap is not None:
+                    x, data = heatmap_row(snap, consts, field)
                     H = make_heatmap_2d(data, y_repeat=y_repeat)
                     extent = [float(x.min()), float(x.max()), 0.0, 1.0]
 
@@ -257,11 +354,11 @@ def watch_heatmap(consts: SimConstants, field: str, build_dir: str = DEFAULT_BUI
                             # Only autoscale when not locking scale
                             im.autoscale()
 
-                    ax.set_title(f"{field} heatmap at t={snap.time:.6f}s  (samples={len(x)})\n{os.path.basename(path)}")
+                    ax.set_title(f"{field} heatmap at t={snap.time:.6f}s  (samples={len(x)})\n{label}")
                     fig.canvas.draw_idle()
-                    last_path, last_mtime = path, mtime
             else:
-                ax.set_title("Waiting for snapshot CSVs in build/ ...")
+                ax.set_title(f"Waiting for the solver to publish {live_name} ..." if live_name
+                             else "Waiting for snapshots in build/ ...")
                 fig.canvas.draw_idle()
 
             plt.pause(0.001)
@@ -278,14 +375,14 @@ def play_all_snapshots(consts: SimConstants, field: str, build_dir: str = DEFAUL
                        y_repeat: int = 50, cmap: str = 'viridis', interval: float = 0.2,
                        vmin: Optional[float] = None, vmax: Optional[float] = None,
                        loop: bool = False, lock_scale: bool = True) -> None:
-    """Load all CSVs under build/ and render from the beginning sequentially."""
-    files = list_snapshots_sorted(build_dir)
+    """Load all snapshots under build/ and render from the beginning sequentially."""
+    files = collect_snapshot_loaders(build_dir)
     if not files:
-        raise SystemExit("No snapshot CSVs found under build/. Run the simulation to generate snapshots.")
+        raise SystemExit("No snapshots found under build/. Run the simulation to generate snapshots.")
 
     # If locking scale and user didn't provide bounds, compute global min/max across files
     if lock_scale and (vmin is None or vmax is None):
-        vmin_auto, vmax_auto = compute_minmax_over_files(files, field)
+        vmin_auto, vmax_auto = compute_minmax(files, field)
         if vmin is None:
             vmin = vmin_auto
         if vmax is None:
@@ -298,10 +395,9 @@ def play_all_snapshots(consts: SimConstants, field: str, build_dir: str = DEFAUL
 
     try:
         while True:
-            for path, tval in files:
-                snap = load_snapshot(path)
-                data = getattr(snap, field)
-                x = snap.idx * consts.DX
+            for label, load in files:
+                snap = load()
+                x, data = heatmap_row(snap, consts, field)
                 H = make_heatmap_2d(data, y_repeat=y_repeat)
                 extent = [float(x.min()), float(x.max()), 0.0, 1.0]
 
@@ -323,7 +419,7 @@ def play_all_snapshots(consts: SimConstants, field: str, build_dir: str = DEFAUL
                     elif not lock_scale and (vmin is None or vmax is None):
                         im.autoscale()
 
-                ax.set_title(f"{field} heatmap at t={snap.time:.6f}s  (samples={len(x)})\n{os.path.basename(path)}")
+                ax.set_title(f"{field} heatmap at t={snap.time:.6f}s  (samples={len(x)})\n{label}")
                 fig.canvas.draw_idle()
                 plt.pause(0.001)
                 time.sleep(max(0.0, interval))
@@ -339,18 +435,21 @@ def play_all_snapshots(consts: SimConstants, field: str, build_dir: str = DEFAUL
 
 
 def main():
-    parser = argparse.ArgumentParser(description='Render heatmap for 1D CFD snapshot CSV.')
+    parser = argparse.ArgumentParser(description='Render heatmap for 1D CFD snapshots (binary container or CSV).')
     parser.add_argument('--field', required=True, choices=['rho', 'vel', 'pres'], help='Field to visualize')
-    parser.add_argument('--file', default=None, help='Path to snapshot CSV; default is the latest under build/')
+    parser.add_argument('--file', default=None, help='Path to snapshot CSV, snapshots.bin or snapshots.cfz; default is the latest under build/')
+    parser.add_argument('--frame', type=int, default=-1, help='Frame index when reading snapshots.bin/.cfz (default: last)')
     parser.add_argument('--constants', default=DEFAULT_CONSTANTS, help='Path to include/constants.h')
     parser.add_argument('--y-repeat', type=int, default=50, help='Rows to replicate along y for heatmap aesthetics')
     parser.add_argument('--cmap', default='viridis', help='Matplotlib colormap')
     parser.add_argument('--save', default=None, help='Output image path (PNG). If not set, show interactively.')
     parser.add_argument('--watch', action='store_true', help='Continuously watch build/ and refresh latest snapshot')
     parser.add_argument('--interval', type=float, default=0.5, help='Refresh interval (seconds) when --watch is used')
+    parser.add_argument('--live', default=None, metavar='NAME',
+                        help='With --watch, read the shared-memory buffer published by `sim --live NAME` instead of build/')
     parser.add_argument('--vmin', type=float, default=None, help='Fix colormap lower bound (optional)')
     parser.add_argument('--vmax', type=float, default=None, help='Fix colormap upper bound (optional)')
-    parser.add_argument('--play-all', action='store_true', help='Load all CSVs in build/ and render sequentially from the beginning')
+    parser.add_argument('--play-all', action='store_true', help='Load all snapshots in build/ and render sequentially from the beginning')
     parser.add_argument('--loop', action='store_true', help='Loop playback when used with --play-all')
     parser.add_argument('--no-lock-scale', action='store_true', help='Do not lock colormap scale globally; allow autoscale per frame')
     parser.add_argument('--no-show', action='store_true', help='Do not open a window (useful with --save)')
@@ -360,6 +459,8 @@ def main():
     consts = parse_constants(args.constants)
 
     lock_scale = not args.no_lock_scale
+    if args.file is None:
+        consts = constants_for(DEFAULT_BUILD_DIR, consts)
 
     if args.play_all and args.file is None:
         print(f"[INFO] Playing all snapshots from {DEFAULT_BUILD_DIR} ...")
@@ -367,6 +468,14 @@ def main():
         play_all_snapshots(consts, field=args.field, build_dir=DEFAULT_BUILD_DIR,
                            y_repeat=args.y_repeat, cmap=args.cmap, interval=args.interval,
                            vmin=args.vmin, vmax=args.vmax, loop=args.loop, lock_scale=lock_scale)
+    elif args.watch and args.live:
+        print(f"[INFO] Watching the live buffer {args.live} ...")
+        live = open_live(args.live)
+        if live is not None:
+            consts = SimConstants(NX=live.header.nx, DX=live.header.dx)
+        watch_heatmap(consts, field=args.field, build_dir=DEFAULT_BUILD_DIR,
+                      y_repeat=args.y_repeat, cmap=args.cmap, interval=args.interval,
+                      vmin=args.vmin, vmax=args.vmax, lock_scale=lock_scale, live_name=args.live)
     elif args.watch and args.file is None:
         print(f"[INFO] Watching {DEFAULT_BUILD_DIR} for latest snapshots ...")
         print(f"[INFO] Constants: NX={consts.NX}, DX={consts.DX}")
@@ -374,11 +483,18 @@ def main():
                       y_repeat=args.y_repeat, cmap=args.cmap, interval=args.interval,
                       vmin=args.vmin, vmax=args.vmax, lock_scale=lock_scale)
     else:
-        csv_path = args.file or find_latest_snapshot(DEFAULT_BUILD_DIR)
+        csv_path = args.file or find_snapshot_file(DEFAULT_BUILD_DIR) or find_latest_snapshot(DEFAULT_BUILD_DIR)
         if not csv_path:
-            raise SystemExit("No snapshot CSV found under build/. Run the simulation until it writes a snapshot.")
-
-        snap = load_snapshot(csv_path)
+            raise SystemExit("No snapshot found under build/. Run the simulation until it writes a snapshot.")
+
+        if csv_path.endswith(('.bin', '.cfz')):
+            snaps = open_snapshots(csv_path)
+            if len(snaps) == 0:
+                raise SystemExit(f"No complete frames in {csv_path}")
+            consts = SimConstants(NX=snaps.header.nx, DX=snaps.header.dx)
+            snap = snapshot_from_frame(snaps, args.frame)
+        else:
+            snap = load_snapshot(csv_path)
         print(f"[INFO] Loaded snapshot: {csv_path} (t={snap.time:.6f}s, samples={len(snap.idx)})")
         print(f"[INFO] Constants: NX={consts.NX}, DX={consts.DX}")
 